@@ -19,6 +19,13 @@ extern "C"{
 #include <bs_types.h>
 #include <bs_audio.h>
 #include <bs_json.h>
+#include <bs_staging.h>
+#include <bs_vram.h>
+#include <bs_jobs.h>
+#include <bs_profiler.h>
+#include <bs_vtex.h>
+#include <bs_pack.h>
+#include <bs_io.h>
 
 #ifdef __cplusplus
 }
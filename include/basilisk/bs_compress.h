@@ -0,0 +1,24 @@
+#ifndef BS_COMPRESS_H
+#define BS_COMPRESS_H
+
+#include <bs_types.h>
+
+// Self contained so tools can compile it without the rest of the engine
+
+/// @return CRC-32 (ISO-HDLC, as in zlib and PNG) of data, pass the previous result as crc to continue one, 0 to start
+bs_U32 bs_crc32(bs_U32 crc, const void* data, bs_U64 size);
+
+/// @return Largest size bs_lz4Compress() can produce for size bytes
+bs_U64 bs_lz4Bound(bs_U64 size);
+
+/// @brief Compresses into a single LZ4 block, readable by any LZ4 block decoder.
+/// Not thread safe, its hash table is static.
+/// @param dst At least bs_lz4Bound(size) bytes
+/// @return Compressed size
+bs_U64 bs_lz4Compress(const void* src, bs_U64 size, void* dst);
+
+/// @brief Decodes an LZ4 block, every read and write is bounds checked so corrupt input can't overrun.
+/// @return False unless the block decodes to exactly dst_size bytes
+bool bs_lz4Decompress(const void* src, bs_U64 src_size, void* dst, bs_U64 dst_size);
+
+#endif // BS_COMPRESS_H
@@ -2,7 +2,10 @@
 #define BS_CORE_H
 
 #include <bs_types.h>
+#include <bs_jobs.h>
+#ifdef _WIN32
 #include <windows.h>
+#endif
 
 const char* bs_version();
 
@@ -59,11 +62,20 @@ void bs_attrib(const int type, unsigned int amount, size_t size_per_type, size_t
 void bs_attribI(const int type, unsigned int amount, size_t size_per_type, size_t attrib_size);
 
 bs_Batch bs_batch(bs_Pipeline* pipeline);
+bs_Batch bs_staticBatch(bs_Pipeline* pipeline);
+void bs_sharedGeometry(bs_U32 vertex_bytes, bs_U32 index_bytes);
+void bs_recycleSharedGeometry();
 bs_Batch* bs_getBatch();
 void bs_selectBatch(bs_Batch *batch);
 void bs_bindBatch(bs_Batch* batch, int vao_binding, int ebo_binding);
 void bs_pushBatch(bs_Batch* batch);
+void bs_pushConstants(const void* data, bs_U32 offset, bs_U32 size);
 void bs_renderBatch(bs_Batch* batch, bs_BatchPart range, bs_RenderType render_type);
+/// @brief Queues a draw that is recorded with the other queued draws of the same pipeline and buffers,
+/// at the next bs_selectBatch(), bs_renderBatch() or the end of the render pass. Draws queued in between are grouped,
+/// so they can be recorded out of order among themselves but never after a later direct draw.
+/// @param instance Passed as firstInstance, shaders read it from gl_InstanceIndex
+void bs_renderBatchIndirect(bs_Batch* batch, bs_BatchPart range, bs_U32 instance);
 void bs_render(bs_BatchPart range, bs_RenderType render_type);
 void bs_renderTriangles(bs_BatchPart range);
 void bs_renderLines(bs_BatchPart range);
@@ -80,6 +92,8 @@ void bs_attach(bs_Renderer* renderer, bs_AttachmentType type);
 void bs_pushAttachments(bs_Renderer* renderer);
 void bs_selectRenderer(bs_Renderer* renderer);
 void bs_commitRenderer(bs_Renderer* renderer);
+void bs_recordJobs(bs_Renderer* renderer, bs_JobFn job, void* param, bs_U32 num_jobs);
+void bs_freeRecorders();
 
 // Matrices / Cameras
 bs_Texture* bs_defTexture();
@@ -124,6 +138,9 @@ enum {
 
 // Constants
 #define BS_BATCH_INCR_BY 256
+#define BS_SHARED_VERTEX_SIZE (64 * 1024 * 1024)
+#define BS_SHARED_INDEX_SIZE (16 * 1024 * 1024)
+#define BS_MAX_INDIRECT_DRAWS 131072
 
 // Clear Buffer Codes
 #define BS_DEPTH_BUFFER_BIT 0x00000100
@@ -0,0 +1,85 @@
+#ifndef BS_DESCRIPTORS_H
+#define BS_DESCRIPTORS_H
+
+#include <bs_types.h>
+#include <bs_shaders.h>
+
+#define BS_DESCRIPTOR_POOL_SETS 256
+
+// upper bound of the bindless image table, lowered to what the device supports
+#define BS_MAX_BINDLESS_IMAGES 16384
+// immutable samplers at binding BS_BINDLESS_SAMPLERS of set BS_BINDLESS_SET
+#define BS_SAMPLER_NEAREST 0
+#define BS_SAMPLER_LINEAR 1
+#define BS_NUM_BINDLESS_SAMPLERS 2
+
+/// @brief Allocates a descriptor set, new pools are created whenever the current one runs out.
+/// @param set_layout VkDescriptorSetLayout of the set
+/// @return The VkDescriptorSet
+void* bs_allocDescriptorSet(void* set_layout);
+
+/// @brief Destroys every descriptor pool and shader space, called by bs_cleanup().
+void bs_freeDescriptors();
+
+/// @brief Creates a shader space, a buffer every shader can read through set BS_SPACE_SET at binding bind_point.
+/// The gpu copy is ring buffered per frame in flight and bound with dynamic offsets.
+/// @param buf Initial contents, the space holds the larger of buf.capacity and buf.max_units units and never grows
+/// @param bind_point One of the BS_SPACE_ bindings
+/// @param type BS_STD140 for a uniform buffer, BS_STD430 for a storage buffer
+/// @return
+bs_Space bs_shaderSpace(bs_Buffer buf, bs_U32 bind_point, bs_SpaceType type);
+
+/// @brief Updates part of a shader space, only the changed range is copied to the gpu.
+/// @param space Space created with bs_shaderSpace()
+/// @param data num_units units of the space's unit size
+/// @param offset First unit to update
+/// @param num_units Number of units to update
+void bs_updateShaderSpace(bs_Space* space, void* data, bs_U32 offset, bs_U32 num_units);
+
+/// @brief Copies the changed ranges of every space into the slot of the current frame, called before a frame is submitted.
+void bs_flushShaderSpaces();
+
+/// @brief Allocates and writes the descriptor set of shader spaces a pipeline layout uses.
+/// The set is written once every space it uses exists, until then *out_set stays NULL.
+/// @param set_layout VkDescriptorSetLayout of set BS_SPACE_SET
+/// @param bindings Bindings of the set, sorted by binding
+/// @param out_set Receives the VkDescriptorSet, has to stay valid until bs_freeDescriptors()
+void bs_requestSpaceSet(void* set_layout, const bs_ShaderBinding* bindings, bs_U32 num_bindings, void** out_set);
+
+/// @brief Mapped contents of the slot a frame in flight reads, for spaces shaders write into.
+/// The slot is only safe to read or clear after the frame's fence, bs_updateShaderSpace() overwrites it.
+/// @param frame Frame in flight, usually bs_frameData()->swapchain_frame
+void* bs_shaderSpaceFrame(bs_Space* space, bs_U32 frame);
+
+/// @brief Fills the dynamic offsets of the spaces for the current frame.
+/// @param offsets One offset per binding
+void bs_spaceOffsets(const bs_ShaderBinding* bindings, bs_U32 num_bindings, bs_U32* offsets);
+
+/// @brief Creates the bindless image table on first use.
+/// Shaders read it through set BS_BINDLESS_SET, "sampler samplers[2]" at binding 0 and "texture2D images[]" at binding 1,
+/// indexed by the bs_Image vertex attribute.
+/// @return VkDescriptorSetLayout of set BS_BINDLESS_SET
+void* bs_bindlessLayout();
+
+/// @return The VkDescriptorSet of the bindless table, VK_NULL_HANDLE before bs_bindlessLayout()
+void* bs_bindlessSet();
+
+/// @return Number of slots the bindless table has on this device
+bs_U32 bs_bindlessCapacity();
+
+/// @brief Puts an image into a free slot of the bindless table.
+/// @param image_view VkImageView in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+/// @return The slot, written into the bs_Image vertex attribute
+bs_U32 bs_bindlessImage(void* image_view);
+
+/// @brief Points an allocated slot at another image, no frame in flight may be sampling the slot.
+void bs_updateBindlessImage(bs_U32 slot, void* image_view);
+
+/// @brief Frees a slot, it's only reused after every frame in flight that could sample it has finished.
+/// Throws when the slot isn't allocated, including a second free of the same slot.
+void bs_freeBindlessImage(bs_U32 slot);
+
+/// @brief Makes the slots freed by the current frame's previous use available again, called once its fence has been waited on.
+void bs_recycleBindlessImages();
+
+#endif // BS_DESCRIPTORS_H
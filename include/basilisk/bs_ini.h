@@ -2,8 +2,12 @@
 #define BS_WND_H
 
 #include <bs_types.h>
+#ifdef _WIN32
 #include <windows.h>
+#endif
 #define BS_NUM_KEYS 348
+#define BS_MAX_FRAMES_IN_FLIGHT 4
+#define BS_FRAME_STATS_WINDOW 128
 
 #define BS_VK_ERR(call, msg) \
     do { \
@@ -23,6 +27,7 @@ typedef struct {
 	double delta_time;
 
     bs_U32 swapchain_frame;
+    bs_U64 frame_num;
     bool key_states[BS_NUM_KEYS + 1];
 } bs_WindowFrame;
 
@@ -33,6 +38,13 @@ void* bs_vkPhysicalDevice();
 void* bs_vkRenderPass();
 void* bs_vkCmdPool();
 void* bs_vkGraphicsQueue();
+void* bs_vkFeatures();
+void* bs_vkIndexingFeatures();
+bs_U32 bs_vkGraphicsFamily();
+void* bs_vkTransferQueue();
+bs_U32 bs_vkTransferFamily();
+void* bs_vkCmdBuffer();
+void bs_setVkCmdBuffer(void* command_buffer);
 bs_U32 bs_handleOffset();
 void bs_addVkHandle(void* handle);
 void* bs_swapchainImgViews();
@@ -43,7 +55,13 @@ bs_U32 bs_swapchainImage();
 bs_ivec2 bs_swapchainExtents();
 void bs_throw(const char* message);
 void bs_throwVk(const char* message, bs_U32 result);
+bs_Config bs_defaultConfig();
 void bs_ini(bs_U32 width, bs_U32 height, const char* name);
+void bs_iniConfig(bs_U32 width, bs_U32 height, const char* name, bs_Config* config);
+bs_U32 bs_framesInFlight();
+bool bs_headless();
+double bs_time();
+bs_FrameStats bs_frameStats();
 void bs_run(void (*tick)());
 void bs_exit();
 double bs_deltaTime();
@@ -54,7 +72,9 @@ bool bs_keyDownOnce(bs_U32 code);
 bool bs_keyUpOnce(bs_U32 code);
 void bs_wndTitle(const char* title);
 void bs_wndTitlef(const char* format, ...);
+#ifdef _WIN32
 HWND bs_hwnd();
+#endif
 bs_PerformanceData bs_queryPerformance();
 double bs_queryPerformanceResult(bs_PerformanceData data);
 
@@ -0,0 +1,53 @@
+#ifndef BS_IO_H
+#define BS_IO_H
+
+#include <bs_types.h>
+
+// reads in flight at once, further requests wait in the queue until one completes
+#define BS_IO_QUEUE_DEPTH 256
+// reads are split into chunks of at most this size
+#define BS_IO_MAX_CHUNK (1024 * 1024 * 1024)
+
+// bs_IoRequest states
+#define BS_IO_PENDING 0
+#define BS_IO_DONE 1
+#define BS_IO_FAILED 2
+
+// bs_ioBackend()
+#define BS_IO_BACKEND_JOBS 0
+#define BS_IO_BACKEND_URING 1
+
+/// @brief Sets up an io_uring on Linux, reads go through the job threads if that fails or elsewhere. Called by bs_ini().
+void bs_prepareIo();
+
+/// @brief Completes every request and tears the ring down, called by bs_cleanup() before the job threads stop.
+void bs_freeIo();
+
+/// @return BS_IO_BACKEND_URING or BS_IO_BACKEND_JOBS
+bs_U32 bs_ioBackend();
+
+/// @brief Opens a file for many reads, e.g. a pack or page file, so requests don't open it every time.
+/// Doesn't throw.
+/// @return False if it couldn't be opened
+bool bs_openIo(bs_IoFile* file, const char* path);
+void bs_closeIo(bs_IoFile* file);
+
+/// @brief Queues a read, nothing is submitted until bs_submitIo(), bs_pollIo() or bs_waitIo().
+/// The request is owned by the caller and has to stay valid until it completed.
+/// A read that ends before size bytes, e.g. at the end of the file, fails.
+void bs_readAsync(bs_IoRequest* request);
+
+/// @brief Submits every queued read that fits in BS_IO_QUEUE_DEPTH in a single batch.
+void bs_submitIo();
+
+/// @brief Submits queued reads and runs the callbacks of completed ones, called by bs_render() before bs_streamImages().
+/// @return Number of requests that completed
+bs_U32 bs_pollIo();
+
+/// @brief Blocks until every queued and in flight request completed, including the ones their callbacks queue.
+void bs_waitIo();
+
+/// @return Number of requests queued or in flight
+bs_U32 bs_pendingIo();
+
+#endif // BS_IO_H
@@ -0,0 +1,54 @@
+#ifndef BS_JOBS_H
+#define BS_JOBS_H
+
+#include <bs_types.h>
+
+#define BS_MAX_JOB_THREADS 16
+#define BS_JOB_QUEUE_SIZE 4096
+
+#ifdef _MSC_VER
+#define BS_THREAD_LOCAL __declspec(thread)
+#else
+#define BS_THREAD_LOCAL __thread
+#endif
+
+typedef void (*bs_JobFn)(void* param, bs_U32 index);
+
+/// @brief Starts the worker threads, called by bs_ini().
+/// @param num_threads Total number of threads including the main thread, 0 uses one per core
+void bs_prepareJobs(bs_U32 num_threads);
+
+/// @brief Finishes queued jobs and joins the worker threads.
+void bs_freeJobs();
+
+/// @brief Number of threads that can execute jobs, including the main thread.
+bs_U32 bs_numJobThreads();
+
+/// @brief Index of the calling thread, 0 for the main thread and 1..bs_numJobThreads()-1 for workers.
+bs_U32 bs_jobThreadIndex();
+
+/// @brief Queues a job, runs one on the calling thread if the queue is full.
+/// @param fn Function to run
+/// @param param Passed to fn
+/// @param index Passed to fn
+/// @param counter Incremented now and decremented once the job finished, can be NULL
+void bs_pushJob(bs_JobFn fn, void* param, bs_U32 index, bs_JobCounter* counter);
+
+/// @brief Queues a long running job that only worker threads pick up, after every job queued with bs_pushJob().
+/// Runs it on the calling thread if there are no workers.
+void bs_pushBackgroundJob(bs_JobFn fn, void* param, bs_U32 index, bs_JobCounter* counter);
+
+/// @brief Runs queued jobs on the calling thread until every job of the counter finished.
+void bs_waitJobs(bs_JobCounter* counter);
+
+/// @brief Calls fn(param, 0..num_jobs-1) spread over every thread and waits for all of them.
+void bs_runJobs(bs_JobFn fn, void* param, bs_U32 num_jobs);
+
+/// @brief Atomically adds to a value.
+/// @return The new value
+bs_I32 bs_atomicAdd(volatile bs_I32* value, bs_I32 add);
+
+/// @brief Atomically reads a value.
+bs_I32 bs_atomicLoad(volatile bs_I32* value);
+
+#endif // BS_JOBS_H
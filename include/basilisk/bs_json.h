@@ -12,8 +12,20 @@ bs_JsonField bs_createJsonStringArray(const char* field, bs_JsonString* value, i
 bs_JsonField bs_createJsonObject(const char* field, bs_Json* value);
 bs_JsonField bs_createJsonObjectArray(const char* field, bs_Json* value, int num_elements);
 
+/// @brief Lexes a copy of raw in a single pass, tokens point into it and are terminated in place.
+/// raw is kept as is, bs_createJsonObject() writes it back out unchanged.
 bs_Json bs_json(const char* raw);
+/// @brief Like bs_jsonInPlace() on the loaded file, which the json keeps.
 bs_Json bs_jsonFile(const char* path);
+/// @brief Like bs_json() and bs_jsonFile() with tokens, arrays and object arrays allocated through an allocator,
+/// which has to outlive the json and everything read from it. An arena frees all of it at once.
+bs_Json bs_jsonWith(const char* raw, bs_Allocator* allocator);
+bs_Json bs_jsonFileWith(const char* path, bs_Allocator* allocator);
+/// @brief Like bs_jsonWith() without the copy, raw is lexed in place and has to outlive the json.
+/// The text is overwritten, so the json has no raw and bs_createJsonObject() writes it from its tokens.
+/// @param raw Null terminated text such as the result of bs_loadFile()
+/// @param raw_len Length of raw, the terminator may be counted as bs_loadFile() does
+bs_Json bs_jsonInPlace(char* raw, int raw_len, bs_Allocator* allocator);
 void bs_freeJson(bs_Json* json);
 bs_JsonValue bs_jsonField(bs_Json* json, const char* field);
 char* bs_jsonFromFields(bs_Json* json, bs_JsonField* fields, int num_fields);
@@ -22,17 +22,86 @@ bs_JsonString bs_string(const char* str);
 void* bs_memmem(const void *haystack, bs_U32 haystack_len, 
     const void * const needle, const bs_U32 needle_len);
 
+// bs_Buffer flags
+// skips zeroing the units a buffer grows by, for buffers that write every unit they append
+#define BS_BUFFER_NO_ZERO_FILL 0x01
+
+// bs_mapFile() hints
+// read front to back, read ahead aggressively and drop pages behind the reader early
+#define BS_MAP_SEQUENTIAL 0x01
+// scattered reads, no read ahead
+#define BS_MAP_RANDOM 0x02
+// start reading the whole file in right away
+#define BS_MAP_WILLNEED 0x04
+
+// bs_MappedFile sources
+#define BS_FILE_MAPPED 0
+// points into a mounted pack, nothing to release
+#define BS_FILE_PACKED 1
+// decompressed from a pack into the heap
+#define BS_FILE_HEAP 2
+
+// block size of arenas created with a block_size of 0, and of the frame arena
+#define BS_ARENA_BLOCK_SIZE (1024 * 1024)
+
 void* bs_free(void* p);
 void* bs_alloc(bs_U32 size);
 void* bs_realloc(void* p, bs_U32 size);
 
+/// @return Counters of bs_alloc(), bs_realloc(), bs_free() and bs_heapAllocator(), updated atomically
+bs_AllocStats bs_heapStats();
+
+/// @return Allocator over bs_alloc(), what a NULL allocator stands for
+bs_Allocator* bs_heapAllocator();
+
+/// @brief Allocate, resize or free through an allocator, NULL uses the heap.
+void* bs_allocWith(bs_Allocator* allocator, bs_U64 size);
+void* bs_reallocWith(bs_Allocator* allocator, void* p, bs_U64 old_size, bs_U64 new_size);
+void bs_freeWith(bs_Allocator* allocator, void* p, bs_U64 size);
+
+/// @brief Linear allocator over a chain of blocks, nothing is freed until it's rewound, reset or freed.
+/// Freeing or growing the latest allocation through its allocator happens in place.
+/// @param block_size Size of its blocks, 0 for BS_ARENA_BLOCK_SIZE. Larger allocations get a block of their own
+bs_Arena bs_arena(bs_U64 block_size);
+/// @param alignment Power of two
+void* bs_arenaAlloc(bs_Arena* arena, bs_U64 size, bs_U64 alignment);
+/// @return Position to hand to bs_arenaRewind(), which frees everything allocated after it
+bs_ArenaMark bs_arenaMark(bs_Arena* arena);
+void bs_arenaRewind(bs_Arena* arena, bs_ArenaMark mark);
+/// @brief Frees every allocation, blocks are merged into one as large as all of them so the next fill needs a single block.
+void bs_arenaReset(bs_Arena* arena);
+void bs_freeArena(bs_Arena* arena);
+
+/// @return Arena reset by bs_render() at the start of every frame, for data that doesn't outlive the frame on the main thread
+bs_Arena* bs_frameArena();
+/// @return Allocation from bs_frameArena() aligned to 16 bytes
+void* bs_frameAlloc(bs_U64 size);
+
+/// @brief Allocator of fixed size units, freed units are reused before new chunks are allocated.
+bs_Pool bs_pool(bs_U32 unit_size, bs_U32 units_per_chunk);
+void* bs_poolAlloc(bs_Pool* pool);
+void bs_poolFree(bs_Pool* pool, void* p);
+void bs_freePool(bs_Pool* pool);
+
 void* bs_bufferAppend(bs_Buffer* buf, void* data);
 void* bs_bufferData(bs_Buffer* buf, bs_U32 offset);
 void bs_bufferAppendRange(bs_Buffer* buf, void* data, size_t num_units);
+/// @brief Makes room for num_units more units, growing the capacity by half or by the increment, whichever is larger.
+/// Throws if the buffer would hold more than max_units.
 void bs_bufferResizeCheck(bs_Buffer* buf, bs_U32 num_units);
+/// @brief Grows the capacity to exactly capacity units if it's smaller, for buffers whose final size is known up front.
+void bs_bufferReserve(bs_Buffer* buf, bs_U32 capacity);
+/// @brief Shrinks the capacity to num_units, freeing the data of an empty buffer.
+void bs_bufferShrink(bs_Buffer* buf);
 bs_Buffer bs_buffer(bs_U32 unit_size, bs_U32 increment, bs_U32 pre_malloc, bs_U32 max_units);
+/// @brief Like bs_buffer() with its data allocated through an allocator, which has to outlive it.
+bs_Buffer bs_bufferWith(bs_Allocator* allocator, bs_U32 unit_size, bs_U32 increment, bs_U32 pre_alloc, bs_U32 max_units);
+/// @brief Frees the data of a buffer through its allocator and empties it.
+void bs_freeBuffer(bs_Buffer* buf);
 bs_Buffer bs_singleUnitBuffer(void* data, bs_U32 unit_size);
 
+bs_U64 bs_hash(const void* data, bs_U64 size);
+
 bs_U8 bs_memU8 (void *data, bs_U32 offset);
 bs_U16 bs_memU16(void *data, bs_U32 offset);
 bs_U32 bs_memU32(void *data, bs_U32 offset);
@@ -40,6 +109,14 @@ int bs_memcmpU32(const void *a, const void *b);
 
 char* bs_replaceFirstSubstring(const char *str, const char *old_str, const char *new_str);
 char* bs_loadFile(const char *path, int *content_len);
+
+/// @brief Maps a file read only instead of copying it into the heap, pages are read in as they're touched
+/// and can be dropped again under memory pressure. Pointers into the mapping stay valid until bs_unmapFile().
+/// Unlike bs_loadFile() the data isn't null terminated.
+/// @param hints BS_MAP_ flags, how the file is going to be read
+bs_MappedFile bs_mapFile(const char* path, bs_U32 hints);
+/// @brief Releases a file from bs_mapFile() or bs_mapAsset().
+void bs_unmapFile(bs_MappedFile* file);
 void bs_appendToFile(const char *filepath, const char *data);
 void bs_writeToFile(const char *filepath, const char *data);
 void bs_writeBuffer(const char* file_path, void* buffer, bs_U64 size);
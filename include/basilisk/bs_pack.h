@@ -0,0 +1,39 @@
+#ifndef BS_PACK_H
+#define BS_PACK_H
+
+#include <bs_types.h>
+
+// "BSPK"
+#define BS_PACK_MAGIC 0x4B505342
+#define BS_PACK_VERSION 1
+#define BS_PACK_EMPTY_BUCKET 0xFFFFFFFF
+#define BS_MAX_PACKS 8
+
+// bs_PackEntry compression
+#define BS_PACK_RAW 0
+#define BS_PACK_LZ4 1
+
+// bs_mountPack() flags
+// checks the CRC of uncompressed entries on every lookup as well, compressed ones are always checked
+#define BS_PACK_VERIFY 0x01
+
+/// @brief Maps a pack written by "bspack" and validates its tables, loaders look names up in it before the file system.
+/// Packs mounted later shadow earlier ones. Mount before anything loads in the background, lookups aren't locked.
+void bs_mountPack(const char* path, bs_U32 flags);
+
+/// @brief Unmaps every pack, called by bs_cleanup(). Pointers into them are invalid afterwards.
+void bs_unmountPacks();
+
+/// @brief Looks a file up in the mounted packs, names are the paths given to bspack, '\' and a leading "./" are ignored.
+/// Uncompressed entries point straight into the pack, compressed ones are decompressed into the heap.
+/// Doesn't throw, so it can run in jobs.
+/// @return False if no pack holds the file or its entry is corrupt
+bool bs_packFile(const char* name, bs_MappedFile* file);
+
+/// @return True if a mounted pack holds the file, nothing is read or decompressed
+bool bs_inPack(const char* name);
+
+/// @brief bs_packFile(), or bs_mapFile() of the loose file if no pack holds it. Released with bs_unmapFile().
+bs_MappedFile bs_mapAsset(const char* path, bs_U32 hints);
+
+#endif // BS_PACK_H
@@ -0,0 +1,45 @@
+#ifndef BS_PROFILER_H
+#define BS_PROFILER_H
+
+#include <bs_types.h>
+
+#define BS_PROFILER_MAX_DEPTH 32
+#define BS_PROFILER_HISTORY 64
+
+/// @brief Creates the timestamp query pool, called by bs_ini() when bs_Config.profile is set.
+void bs_prepareProfiler();
+
+/// @brief Destroys the query pool.
+void bs_freeProfiler();
+
+/// @brief Starts recording the scopes of a frame, called by bs_render() after the command buffer begins.
+/// Resolves the frame that last used the same frame in flight slot, its fence has been waited on so this never stalls.
+void bs_profileFrameBegin(void* command_buffer);
+
+/// @brief Closes scopes left open, called by bs_render() before the command buffer ends.
+void bs_profileFrameEnd();
+
+/// @brief Opens a scope on the calling thread, nested scopes show up as children.
+/// Writes a gpu timestamp into the command buffer the thread is recording, secondaries of bs_recordJobs() included.
+/// Only scopes between bs_profileFrameBegin() and bs_profileFrameEnd() are recorded, other calls are ignored.
+/// @param name Has to outlive the profiler, usually a string literal
+void bs_profileBegin(const char* name);
+
+/// @brief Nests the scopes job threads open from here on under the main thread's innermost scope.
+/// Called by bs_recordJobs() before its jobs run.
+void bs_profileDispatch();
+
+/// @brief Closes the innermost open scope.
+void bs_profileEnd();
+
+/// @brief The most recently resolved frame, NULL if profiling is disabled or nothing resolved yet.
+bs_ProfileFrame* bs_profileFrame();
+
+/// @brief Prints a hierarchical breakdown of the most recently resolved frame.
+void bs_printProfile();
+
+/// @brief Writes the last BS_PROFILER_HISTORY resolved frames as Chrome trace event JSON.
+/// Cpu scopes are on the thread of their job thread index, gpu scopes on thread BS_MAX_JOB_THREADS, open in chrome://tracing or Perfetto.
+void bs_saveProfileTrace(const char* path);
+
+#endif // BS_PROFILER_H
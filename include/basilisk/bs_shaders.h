@@ -8,12 +8,20 @@
 #define BS_SPACE_ENTITIES 1
 #define BS_SPACE_GLOBALS 2
 #define BS_SPACE_IMAGES 3
-#define BS_SPACE_RESERVED_04 4
-#define BS_SPACE_RESERVED_05 5
+#define BS_SPACE_VTEX_PAGES 4
+#define BS_SPACE_VTEX_FEEDBACK 5
 #define BS_SPACE_RESERVED_06 6
 #define BS_SPACE_RESERVED_07 7
 #define BS_SPACE_RESERVED_08 8
 
+#define BS_MAX_SPACES 16
+// descriptor set the shader spaces are bound to, its buffers use dynamic offsets
+#define BS_SPACE_SET 0
+// descriptor set of the bindless image table, see bs_bindlessLayout()
+#define BS_BINDLESS_SET 1
+#define BS_BINDLESS_SAMPLERS 0
+#define BS_BINDLESS_IMAGES 1
+
 typedef enum bs_SpaceType bs_SpaceType;
 
 enum bs_SpaceType {
@@ -21,14 +29,70 @@ enum bs_SpaceType {
 	BS_STD430
 };
 
+#define BS_PIPELINE_CACHE_PATH "pipeline_cache.bin"
+
+/// @brief Creates the pipeline cache every pipeline is compiled through, called by bs_ini().
+/// Data from a different driver, vendor or device is discarded.
+/// @param path File written by bs_savePipelineCache(), the cache starts empty if it doesn't exist or is NULL
+void bs_preparePipelineCache(const char* path);
+
+/// @brief Writes the pipeline cache to disk, called when bs_run() returns.
+void bs_savePipelineCache(const char* path);
+
+/// @brief Destroys the pipeline cache.
+void bs_freePipelineCache();
+
+/// @brief The VkPipelineCache used by bs_pipeline().
+void* bs_vkPipelineCache();
+
 /// @brief Creates a pipeline from a vertex shader and fragment shader.
+/// Pipelines are shared, calling this again with the same shaders and renderer returns the existing one.
 /// @param renderer Pointer to a rendererer created with bs_renderer()
 /// @param vs Pointer to a vertex shader created with bs_vertexShader()
 /// @param fs Pointer to a fragment shader created with bs_fragmentShader()
 /// @return 
 bs_Pipeline bs_pipeline(bs_Renderer* renderer, bs_VertexShader* vs, bs_FragmentShader* fs);
 
+/// @brief Like bs_pipeline() but compiles on a worker thread and returns right away.
+/// Batches using the pipeline draw with the fallback pipeline, or not at all, until it is ready.
+/// @return A pipeline that may not be ready yet, see bs_pipelineReady()
+bs_Pipeline bs_pipelineAsync(bs_Renderer* renderer, bs_VertexShader* vs, bs_FragmentShader* fs);
+
+/// @brief Whether the pipeline finished compiling.
+bool bs_pipelineReady(bs_Pipeline* pipeline);
+
+/// @brief Whether compiling the pipeline failed, it will never become ready.
+bool bs_pipelineFailed(bs_Pipeline* pipeline);
+
+/// @brief Sets the pipeline drawn with while a pipeline is still compiling.
+/// It's only used for pipelines with the same vertex attributes.
+/// @param pipeline Fallback pipeline, NULL skips draws of pipelines that aren't ready
+void bs_fallbackPipeline(bs_Pipeline* pipeline);
+
+/// @brief The VkPipeline to draw with, the fallback if the pipeline isn't ready.
+/// @return NULL if there's nothing to draw with
+void* bs_pipelineState(bs_Pipeline* pipeline);
+
+/// @brief Binds the shader spaces the pipeline uses at the offsets of the current frame.
+/// @return The VkPipelineLayout of the pipeline bs_pipelineState() returns, push constants are written through it
+void* bs_bindPipelineLayout(void* command_buffer, bs_Pipeline* pipeline);
+
+/// @brief The VkPipelineLayout built from the descriptor bindings and push constants of the pipeline's shaders.
+void* bs_vkPipelineLayout(bs_Pipeline* pipeline);
+
+/// @brief The VkDescriptorSetLayout of a set used by the pipeline's shaders.
+/// @return NULL if the shaders don't use the set
+void* bs_vkDescriptorSetLayout(bs_Pipeline* pipeline, bs_U32 set);
+
+/// @brief Number of bs_pipelineAsync() compiles that haven't finished.
+bs_U32 bs_pendingPipelines();
+
+/// @brief Number of bs_pipelineAsync() compiles that failed.
+bs_U32 bs_failedPipelines();
+
 /// @brief Creates a SPIR-V vertex shader.
+/// Inputs are matched to vertex attributes by name ("bs_Position", "bs_Texture", ...),
+/// inputs of shaders without debug names are expected at the location of their bs_AttributeType.
 /// @param path Path to the compiled .spv
 /// @return 
 bs_VertexShader
@@ -44,4 +108,14 @@ bs_fragmentShader(
 	const char* path
 );
 
+/// @brief Releases a vertex shader, the shader module is destroyed once every shader loaded from the same file is released.
+/// Pipelines created from the shader stay valid.
+void bs_releaseVertexShader(bs_VertexShader* vs);
+
+/// @brief Releases a fragment shader, see bs_releaseVertexShader().
+void bs_releaseFragmentShader(bs_FragmentShader* fs);
+
+/// @brief Destroys every pipeline and the shader modules that are still loaded, called by bs_cleanup().
+void bs_freePipelines();
+
 #endif // BS_SHADERS_H
\ No newline at end of file
@@ -0,0 +1,13 @@
+#ifndef BS_SPIRV_H
+#define BS_SPIRV_H
+
+#include <bs_types.h>
+
+/// @brief Reflects the entry point, inputs, descriptor bindings and push constants of a SPIR-V module in one pass.
+/// Inputs named like the vertex attributes ("bs_Position", "bs_Texture", ...) are matched to them by name.
+/// @param code SPIR-V words, 4 byte aligned
+/// @param size Size of the code in bytes
+/// @param reflection Filled with the results
+void bs_reflectSpirv(const void* code, bs_U64 size, bs_ShaderReflection* reflection);
+
+#endif // BS_SPIRV_H
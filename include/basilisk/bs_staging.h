@@ -0,0 +1,61 @@
+#ifndef BS_STAGING_H
+#define BS_STAGING_H
+
+#include <bs_types.h>
+
+#define BS_STAGING_SIZE (32 * 1024 * 1024)
+#define BS_STAGING_SUBMITS 4
+#define BS_STAGING_CALLBACKS 4
+
+/// @brief Creates the persistently mapped staging ring, called by bs_ini().
+/// @param size Size of the ring in bytes
+void bs_prepareStaging(bs_U64 size);
+
+/// @brief Destroys the staging ring, waits for any pending uploads first.
+void bs_freeStaging();
+
+/// @brief Copies data into the staging ring and records a copy into a device buffer.
+/// The copy is not submitted until bs_flushUploads() is called.
+/// @param dst_buffer Destination VkBuffer, needs VK_BUFFER_USAGE_TRANSFER_DST_BIT
+/// @param dst_offset Offset into the destination buffer in bytes
+/// @param data Source data
+/// @param size Number of bytes to copy
+void bs_stagingUpload(void* dst_buffer, bs_U64 dst_offset, const void* data, bs_U64 size);
+
+/// @brief Copies data into the staging ring for commands recorded by the caller, such as buffer to image copies.
+/// The range stays valid until the upload recording it has been submitted and finished.
+/// @param data Source data
+/// @param size Number of bytes, at most half the ring
+/// @param alignment Alignment of the offset, raised to 16
+/// @return Offset into bs_stagingBuffer()
+bs_U64 bs_stagingWrite(const void* data, bs_U64 size, bs_U64 alignment);
+
+/// @return The VkCommandBuffer uploads are currently recorded into, recording is started if it wasn't.
+/// It's submitted to bs_vkTransferQueue(), so only copies and transfer stage barriers can go into it
+void* bs_uploadCommandBuffer();
+
+/// @return The VkCommandBuffer submitted to the graphics queue right after the copies of the current upload, for blits and
+/// barriers into shader stages. The same as bs_uploadCommandBuffer() when the device has no separate transfer queue
+void* bs_uploadGraphicsCommandBuffer();
+
+/// @return The VkBuffer of the staging ring
+void* bs_stagingBuffer();
+
+/// @return The id bs_flushUploads() will return for what is being recorded right now
+bs_U64 bs_recordingUploadId();
+
+/// @brief Adds a function called with bs_uploadCommandBuffer() right before every submit.
+/// Used to record commands for data written with bs_stagingWrite() in batches, it runs whenever the ring fills up too.
+void bs_stagingFlushCallback(void (*callback)(void* command_buffer));
+
+/// @brief Submits every upload recorded since the last flush in one submit.
+/// @return Upload id which can be passed to bs_uploadComplete() or bs_waitUpload(), 0 if nothing was recorded
+bs_U64 bs_flushUploads();
+
+/// @brief Checks if an upload submitted by bs_flushUploads() has finished on the GPU.
+bool bs_uploadComplete(bs_U64 id);
+
+/// @brief Blocks until an upload submitted by bs_flushUploads() has finished on the GPU.
+void bs_waitUpload(bs_U64 id);
+
+#endif // BS_STAGING_H
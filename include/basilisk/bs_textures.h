@@ -3,39 +3,102 @@
 
 #include <bs_types.h>
 
+#define BS_TEXTURE_ERR_FILE 1
+#define BS_TEXTURE_ERR_CORRUPT 2
+#define BS_TEXTURE_ERR_UNSUPPORTED 3
+
+#define BS_FOURCC(a, b, c, d) ((bs_U32)(a) | ((bs_U32)(b) << 8) | ((bs_U32)(c) << 16) | ((bs_U32)(d) << 24))
+
+#define BS_IMAGE_LOADING 0
+#define BS_IMAGE_READY 1
+#define BS_IMAGE_FAILED 2
+
+// decoded bytes uploaded per frame by bs_streamImages(), at least one image is uploaded regardless
+#define BS_STREAM_BYTES_PER_FRAME (16 * 1024 * 1024)
+
 void bs_saveTexture32(const char *name, unsigned char *data, int w, int h);
 
+/// @brief Creates the image list and the white 1x1 image at slot 0, which untextured vertices sample.
 void bs_pushImageBuffers();
-void bs_pushImages();
+/// @brief Loads an image file into a mipmapped texture and puts it in the bindless table, see bs_textureFile().
+/// @param path Image file, NULL for a white 1x1 image
+/// @param num_frames Unused
 bs_Image* bs_image(char* path, bs_U32 num_frames);
 bs_Image* bs_imageTtfAtlas(int dim, bs_U8* data);
 bs_Image* bs_getLastImage();
-void bs_pushImages();
+/// @brief Frees the bindless slot and texture of an image, cancels it if it's still loading.
+void bs_freeImage(bs_Image* image);
+
+/// @brief Loads an image file in the background, it's read with bs_readAsync(), decoded on a worker thread and uploaded by bs_streamImages().
+/// Until it's ready the image uses the white image at slot 0.
+/// @param path Image file, copied
+/// @param priority Queued loads with a higher priority are decoded first, e.g. the negated camera distance or the requested mip level
+bs_Image* bs_imageAsync(const char* path, float priority);
+
+/// @brief Changes the priority of an image that is still queued.
+void bs_imagePriority(bs_Image* image, float priority);
+
+/// @return True once the image is in the bindless table, its buffer_location is valid from then on
+bool bs_imageReady(bs_Image* image);
+
+/// @return Number of images queued, being read or being decoded
+bs_U32 bs_pendingImages();
+
+/// @brief Starts reads and decodes of the highest priority loads and uploads finished ones, called by bs_render() before tick.
+/// Slots of the images uploaded here can be drawn with in the same frame.
+void bs_streamImages();
+
+/// @brief Creates a sampled 2D image and its view, contents are undefined until bs_textureUpload().
+/// @param format VkFormat
+/// @param mip_levels Number of mip levels, 0 for a full chain down to 1x1. Lowered to 1 if the format can't be blitted with linear filtering
+void bs_texture(bs_Texture* texture, bs_vec2 dim, bs_U32 format, bs_U32 mip_levels);
+
+/// @brief Writes the first mip level through the staging ring, the remaining levels are generated with vkCmdBlitImage.
+/// Transitions, copies and blits of every texture uploaded before the next bs_flushUploads() are recorded in one batch.
+/// @param data Tightly packed texels of the first level, split into several copies if it doesn't fit into half of BS_STAGING_SIZE
+void bs_textureUpload(bs_Texture* texture, const void* data);
+
+/// @brief Like bs_textureUpload() but with the first num_levels levels given, the rest are generated.
+/// Compressed textures can't be blitted, every level has to be given.
+/// @param data Levels back to back, largest first
+void bs_textureUploadLevels(bs_Texture* texture, const void* data, bs_U32 num_levels);
+
+/// @brief Destroys a texture once its upload and every frame in flight that could sample it are done.
+void bs_freeTexture(bs_Texture* texture);
+
+/// @brief Destroys the textures the current frame slot freed last time around, called once its fence has been waited on.
+void bs_recycleTextures();
+
+/// @brief Destroys every image and freed texture, called by bs_cleanup().
+void bs_freeTextures();
+
+/// @brief Decodes a PNG into texture->data as RGBA8, freed with free().
+/// @return lodepng error code, 0 on success
+bs_U32 bs_textureDataFile(bs_Texture* texture, const char *path, bool update_dimensions);
 
-void bs_texture(bs_Texture* texture, bs_vec2 dim, int type);
-bs_U32 bs_textureDataFile(const char *path, bool update_dimensions);
-void bs_pushTexture(int internal_format, int format, int type);
-void bs_textureMinMag(int min_filter, int mag_filter);
+/// @brief Reads a DDS, KTX2 or PNG file into texture->data, freed with free().
+/// DDS and KTX2 files holding BC1-BC7 data are used as is with every mip level they contain,
+/// PNGs are decoded to RGBA8 with mip_levels 1. Doesn't throw, so it can run in jobs.
+/// @return 0 on success or one of the BS_TEXTURE_ERR_ codes
+bs_U32 bs_textureFile(bs_Texture* texture, const char* path);
 
-void bs_selectTexture(bs_Texture* texture, bs_U32 tex_unit);
+/// @brief bs_textureFile() of a file that's already in memory, e.g. read with bs_readAsync().
+bs_U32 bs_textureMemory(bs_Texture* texture, const bs_U8* file, bs_U64 size);
 
-void bs_textureArray(bs_Texture* tex, bs_vec2 max_dim, int num_textures);
-bs_U32 bs_textureArrayAppendPNG(const char *path);
+/// @return Size of a texel of an uncompressed VkFormat in bytes
+bs_U32 bs_texelSize(bs_U32 format);
 
-void bs_linearFiltering();
-void bs_nearestFiltering();
+/// @return Size of a mip level in bytes, block compressed formats round up to whole 4x4 blocks
+bs_U64 bs_levelSize(bs_U32 format, bs_U32 w, bs_U32 h);
 
-void bs_depthStencil(bs_Texture* texture, bs_vec2 dim, bs_U8* data);
-void bs_depth(bs_Texture* texture, bs_vec2 dim, bs_U8* data);
+void bs_depthStencil(bs_Texture* texture, bs_vec2 dim);
+void bs_depth(bs_Texture* texture, bs_vec2 dim);
 void bs_textureR(bs_Texture* texture, bs_vec2 dim, bs_U8* data);
 void bs_textureRG(bs_Texture* texture, bs_vec2 dim, bs_U8* data);
-void bs_textureRGB(bs_Texture* texture, bs_vec2 dim, bs_U8* data);
-void bs_textureRGB16f(bs_Texture* texture, bs_vec2 dim, bs_U8* data);
-void bs_textureRGB32f(bs_Texture* texture, bs_vec2 dim, bs_U8* data);
 void bs_textureRGBA(bs_Texture* texture, bs_vec2 dim, bs_U8* data);
 void bs_textureRGBA16f(bs_Texture* texture, bs_vec2 dim, bs_U8* data);
 void bs_textureRGBA32f(bs_Texture* texture, bs_vec2 dim, bs_U8* data);
 void bs_texture_11_11_10(bs_Texture* texture, bs_vec2 dim, bs_U8* data);
 void bs_textureR16U(bs_Texture* texture, bs_vec2 dim, bs_U8* data);
 
-#endif // BS_TEXTURES_H
\ No newline at end of file
+#endif // BS_TEXTURES_H
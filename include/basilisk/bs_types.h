@@ -7,6 +7,10 @@
 
 #define BS_MAX_ATTACHMENTS 8
 #define BS_MAX_TEXTURES 8
+#define BS_PROFILER_MAX_SCOPES 256
+#define BS_MAX_SHADER_INPUTS 16
+#define BS_MAX_SHADER_BINDINGS 32
+#define BS_MAX_DESCRIPTOR_SETS 4
 
 // CGLM Alignment
 #if defined(_MSC_VER)
@@ -53,8 +57,30 @@ typedef struct bs_uvec4 bs_uvec4;
 // Wnd
 typedef struct bs_Error bs_Error;
 typedef struct bs_ErrorData bs_ErrorData;
+typedef struct bs_Config bs_Config;
+typedef struct bs_FrameStats bs_FrameStats;
 // Mem
 typedef struct bs_Buffer bs_Buffer;
+typedef struct bs_Allocator bs_Allocator;
+typedef struct bs_MappedFile bs_MappedFile;
+typedef struct bs_PackHeader bs_PackHeader;
+typedef struct bs_PackEntry bs_PackEntry;
+typedef struct bs_AllocStats bs_AllocStats;
+typedef struct bs_ArenaBlock bs_ArenaBlock;
+typedef struct bs_Arena bs_Arena;
+typedef struct bs_ArenaMark bs_ArenaMark;
+typedef struct bs_Pool bs_Pool;
+// Vram
+typedef struct bs_VramAllocation bs_VramAllocation;
+typedef struct bs_VramStats bs_VramStats;
+// Jobs
+typedef struct bs_JobCounter bs_JobCounter;
+// Io
+typedef struct bs_IoFile bs_IoFile;
+typedef struct bs_IoRequest bs_IoRequest;
+// Profiler
+typedef struct bs_ProfileScope bs_ProfileScope;
+typedef struct bs_ProfileFrame bs_ProfileFrame;
 // Shaders
 typedef struct bs_ShaderMaterial bs_ShaderMaterial;
 typedef struct bs_ShaderEntity bs_ShaderEntity;
@@ -67,11 +93,14 @@ typedef struct bs_ComputeShader bs_ComputeShader;
 typedef struct bs_VertexShader bs_VertexShader;
 typedef struct bs_Attribute bs_Attribute;
 typedef struct bs_Pipeline bs_Pipeline;
+typedef struct bs_ShaderInput bs_ShaderInput;
+typedef struct bs_ShaderBinding bs_ShaderBinding;
+typedef struct bs_ShaderReflection bs_ShaderReflection;
 // Textures
 typedef struct bs_Texture bs_Texture;
 typedef struct bs_TextureFunc bs_TextureFunc;
-typedef struct bs_ImageShaderData bs_ImageShaderData;
 typedef struct bs_Image bs_Image;
+typedef struct bs_VirtualTexture bs_VirtualTexture;
 // Core
 typedef struct bs_RenderData bs_RenderData;
 typedef struct bs_Framebuffer bs_Framebuffer;
@@ -105,6 +134,7 @@ typedef struct bs_JsonField bs_JsonField;
 typedef struct bs_JsonString bs_JsonString;
 typedef struct bs_JsonArray bs_JsonArray;
 typedef struct bs_JsonToken bs_JsonToken;
+typedef struct bs_JsonKey bs_JsonKey;
 typedef struct bs_Json bs_Json;
 typedef struct bs_JsonValue bs_JsonValue;
 
@@ -451,30 +481,55 @@ struct bs_RenderData {
     bs_U32 num_textures;
 };
 
-struct bs_Texture {
-    bs_ivec3 frame;
-    int num_frames;
+struct bs_VramAllocation {
+    void* memory;
+    bs_U64 offset;
+    bs_U64 size;
+
+    // persistently mapped pointer to offset, NULL if not host visible
+    void* mapped;
+
+    bs_U32 pool;
+    bs_U32 block;
+};
 
+struct bs_Texture {
     int w, h;
-    float texw, texh;
 
-    int type;
-    int attachment;
+    // VkFormat
+    bs_U32 format;
+    bs_U32 mip_levels;
 
-    unsigned int id;
-    unsigned int unit;
+    // VkImage and VkImageView
+    void* image;
+    void* view;
+    bs_VramAllocation allocation;
 
-    unsigned char *data;
-};
+    // upload writing the texture, see bs_uploadComplete()
+    bs_U64 upload;
 
-struct bs_ImageShaderData {
-    bs_U64 handle;
-    bs_vec2 coords;
+    unsigned char *data;
 };
 
 struct bs_Image {
-    bs_ImageShaderData* data;
+    bs_Texture texture;
+    // slot in the bindless table, what the bs_Image vertex attribute holds
     bs_U32 buffer_location;
+
+    // BS_IMAGE_LOADING, BS_IMAGE_READY or BS_IMAGE_FAILED
+    bs_U32 state;
+    // streaming request while loading, see bs_imageAsync()
+    void* load;
+};
+
+struct bs_VirtualTexture {
+    bs_U32 id;
+    // index of its first entry in the page table space, levels follow each other finest first
+    bs_U32 first_entry;
+    bs_U32 num_entries;
+
+    bs_U32 w, h;
+    bs_U32 num_levels;
 };
 
 struct bs_Buffer {
@@ -484,28 +539,229 @@ struct bs_Buffer {
 
     bs_U32 max_units;
     bs_U32 increment;
+    bs_U32 flags;
 
     bs_U8* data;
+    // NULL for the heap
+    bs_Allocator* allocator;
+};
+
+struct bs_MappedFile {
+    // read only, NULL for an empty file
+    const bs_U8* data;
+    bs_U64 size;
+
+    // BS_FILE_, what bs_unmapFile() has to release
+    bs_U32 source;
+};
+
+// layout of .bspk packs, little endian. Entry data follows the header, then the entries, buckets and names
+struct bs_PackHeader {
+    bs_U32 magic;
+    bs_U32 version;
+    bs_U32 num_entries;
+    // power of two, open addressing with linear probing on the name hash
+    bs_U32 num_buckets;
+
+    bs_U64 entries_offset;
+    bs_U64 buckets_offset;
+    bs_U64 names_offset;
+    bs_U64 names_size;
+};
+
+struct bs_PackEntry {
+    // bs_hash() of the name
+    bs_U64 hash;
+    bs_U64 offset;
+    bs_U64 size;
+    bs_U64 raw_size;
+
+    bs_U32 name_offset;
+    bs_U32 name_len;
+    // of the uncompressed data
+    bs_U32 crc;
+    bs_U32 compression;
+};
+
+struct bs_AllocStats {
+    bs_U64 num_allocs;
+    bs_U64 num_frees;
+    bs_U64 total_bytes;
+
+    // the heap doesn't know what bs_free() releases, so these stay 0 for it
+    bs_U64 used_bytes;
+    bs_U64 peak_bytes;
+};
+
+// allocates when p is NULL, frees when new_size is 0, otherwise resizes p keeping its first min(old_size, new_size) bytes
+typedef void* (*bs_AllocFn)(bs_Allocator* allocator, void* p, bs_U64 old_size, bs_U64 new_size);
+
+// the first member of every allocator, so bs_AllocFn can cast it back to its owner
+struct bs_Allocator {
+    bs_AllocFn fn;
+    bs_AllocStats stats;
+};
+
+struct bs_ArenaBlock {
+    bs_ArenaBlock* prev;
+    bs_U64 size;
+    bs_U64 used;
+};
+
+struct bs_Arena {
+    bs_Allocator allocator;
+
+    // newest block, earlier ones are linked through prev
+    bs_ArenaBlock* block;
+    bs_U64 block_size;
+
+    // can be grown or freed in place
+    bs_U8* last;
+};
+
+struct bs_ArenaMark {
+    bs_ArenaBlock* block;
+    bs_U64 used;
+};
+
+struct bs_Pool {
+    bs_Allocator allocator;
+
+    bs_U32 unit_size;
+    bs_U32 units_per_chunk;
+
+    // free units and chunks are linked through their first pointer
+    void* free_units;
+    void* chunks;
+};
+
+struct bs_VramStats {
+    bs_U32 num_blocks;
+    bs_U32 num_dedicated;
+    bs_U32 num_allocations;
+
+    bs_U64 block_bytes;
+    bs_U64 used_bytes;
+};
+
+struct bs_JobCounter {
+    volatile bs_I32 pending;
+};
+
+struct bs_IoFile {
+    // file descriptor or HANDLE, -1 when closed
+    bs_I64 handle;
+    bs_U64 size;
+};
+
+struct bs_IoRequest {
+    // opened by bs_readAsync() and closed once the read completed, ignored if file is set
+    const char* path;
+    // opened with bs_openIo(), has to stay open until the read completed
+    bs_IoFile* file;
+    bs_U64 offset;
+    // 0 reads from offset to the end of the file
+    bs_U64 size;
+    // NULL allocates size bytes, the caller frees them with bs_free()
+    bs_U8* dst;
+
+    // runs on the main thread in bs_pollIo() or bs_waitIo(), can be NULL to poll state instead
+    void (*callback)(bs_IoRequest* request);
+    void* user;
+
+    // BS_IO_
+    volatile bs_I32 state;
+    bs_U64 bytes_read;
+
+    // internal
+    bs_IoFile opened;
+};
+
+// times are in milliseconds, starts are relative to the start of the frame
+struct bs_ProfileScope {
+    const char* name;
+    bs_U32 depth;
+    // job thread index of the thread that recorded it, scopes of different threads overlap
+    bs_U32 thread;
+
+    double cpu_start;
+    double cpu_time;
+
+    // negative when the scope had no gpu timestamps
+    double gpu_start;
+    double gpu_time;
+};
+
+struct bs_ProfileFrame {
+    bs_U64 frame_num;
+
+    // seconds, same clock as bs_time()
+    double cpu_begin;
+    double cpu_time;
+    double gpu_time;
+
+    bs_ProfileScope scopes[BS_PROFILER_MAX_SCOPES];
+    bs_U32 num_scopes;
 };
 
 struct bs_Pipeline {
     bs_VertexShader* vs;
 
+    // NULL until a pipeline from bs_pipelineAsync() finished compiling, see bs_pipelineState()
     void* state;
+    // registry entry the pipeline is shared through
+    void* entry;
 };
 
 struct bs_GeometryShader {
     bs_U32 id;
 };
 
+struct bs_ShaderInput {
+    bs_U32 location;
+    // VkFormat of the variable as declared in the shader
+    bs_U32 format;
+    // bs_AttributeType, BS_NUM_ATTRIBUTES if it isn't one
+    bs_U32 attribute;
+    // false for stripped shaders without OpName debug info
+    bool named;
+};
+
+struct bs_ShaderBinding {
+    bs_U32 set;
+    bs_U32 binding;
+    // VkDescriptorType
+    bs_U32 type;
+    // 0 for runtime sized arrays
+    bs_U32 count;
+    // VkShaderStageFlags
+    bs_U32 stages;
+};
+
+struct bs_ShaderReflection {
+    // VkShaderStageFlags of the entry point
+    bs_U32 stage;
+
+    bs_ShaderInput inputs[BS_MAX_SHADER_INPUTS];
+    bs_U32 num_inputs;
+
+    bs_ShaderBinding bindings[BS_MAX_SHADER_BINDINGS];
+    bs_U32 num_bindings;
+
+    bs_U32 push_constant_size;
+};
+
 struct bs_FragmentShader {
     bs_U32 id;
     void* module;
+
+    const bs_ShaderReflection* reflection;
 };
 
 struct bs_Attribute {
     bs_U8 format;
     bs_U8 size;
+    bs_U8 location;
 };
 
 struct bs_VertexShader {
@@ -517,6 +773,8 @@ struct bs_VertexShader {
     bs_U32 attribs;
 
     void* module;
+
+    const bs_ShaderReflection* reflection;
 };
 
 struct bs_ComputeShader {
@@ -537,12 +795,12 @@ struct bs_ShaderEntity {
 };
 
 struct bs_ShaderSpace {
-    bs_U32 accessor;
     bs_U32 bind_point;
+    // bs_SpaceType
+    bs_U32 type;
 
-    bs_U32 gl_type;
-
-    bs_Buffer buf;
+    bs_U32 unit_size;
+    bs_U32 num_units;
 };
 
 struct bs_Shader {
@@ -588,6 +846,7 @@ struct bs_Renderer {
 struct bs_BatchPart {
     bs_U32 offset;
     bs_U32 num;
+    bs_I32 base_vertex;
 };
 
 struct bs_Batch {
@@ -604,6 +863,15 @@ struct bs_Batch {
     bs_U32 VAO, VBO, EBO;
 
     void* vbuffer, *ibuffer;
+    bs_VramAllocation vertex_alloc, index_alloc;
+
+    // static batches live in the shared geometry buffers, see bs_staticBatch()
+    bool shared;
+    bs_U32 base_vertex;
+    bs_U32 first_index;
+    // bytes reserved in the shared buffers, given back when the batch is pushed again
+    bs_U32 shared_vertex_size;
+    bs_U32 shared_index_size;
 };
 
 struct bs_Quad {
@@ -894,17 +1162,34 @@ struct bs_JsonToken {
     int offset;
     int len;
     bs_U8 type;
+    // tokens from an opening bracket to its closing one, 0 for every other token
+    int end;
+};
+
+// slot of the (object, key) table, value tokens follow their key and its ':'
+struct bs_JsonKey {
+    // opening brace of the object, NULL for an empty slot
+    bs_JsonToken* object;
+    bs_JsonToken* key;
+    bs_U32 hash;
 };
 
 struct bs_Json {
+    // lexed copy of raw, syntax tokens point into a table of their own
     char* token_data;
-    int token_len;
 
     bs_JsonToken* tokens;
     int num_tokens;
 
     char* raw;
     int raw_len;
+
+    // tokens and parsed arrays, NULL for the heap
+    bs_Allocator* allocator;
+
+    // built by bs_lexJson() and shared with the objects parsed out of it, open addressing with a power of two slots
+    bs_JsonKey* keys;
+    bs_U32 num_keys;
 };
 
 struct bs_JsonValue {
@@ -961,6 +1246,62 @@ struct bs_PerformanceData {
     bs_I64 start, end;
 };
 
+// Values match VkPresentModeKHR
+typedef enum {
+    BS_PRESENT_IMMEDIATE = 0,
+    BS_PRESENT_MAILBOX = 1,
+    BS_PRESENT_FIFO = 2,
+    BS_PRESENT_FIFO_RELAXED = 3
+} bs_PresentMode;
+
+#define BS_MAX_PRESENT_MODES 4
+
+// Initialized by:
+// bs_defaultConfig()
+struct bs_Config {
+    // 1 - BS_MAX_FRAMES_IN_FLIGHT
+    bs_U32 frames_in_flight;
+
+    // tried in order, fifo is always supported and used when none of them are
+    bs_PresentMode present_modes[BS_MAX_PRESENT_MODES];
+    bs_U32 num_present_modes;
+
+    // clamped to the surface limits, 2 by default, 0 picks one more than the surface minimum
+    bs_U32 swapchain_images;
+
+    // renders into offscreen images, no window or surface is created
+    bool headless;
+    // frames bs_run() renders in headless mode, 0 runs until bs_exit()
+    bs_U32 headless_frames;
+    // receives the BGRA8 pixels of every headless frame once the gpu finished it, can be NULL
+    void (*readback)(const bs_U8* pixels, bs_U32 width, bs_U32 height, bs_U64 frame_num);
+
+    // records cpu and gpu timestamps for bs_profileBegin() scopes, see bs_profiler.h
+    bool profile;
+
+    // threads running jobs including the main thread, 0 uses one per core
+    bs_U32 job_threads;
+
+    // loaded by bs_ini() and saved when bs_run() returns, NULL disables persistence
+    const char* pipeline_cache;
+};
+
+// Over the last BS_FRAME_STATS_WINDOW frames, in milliseconds
+struct bs_FrameStats {
+    bs_U32 num_frames;
+
+    double avg_frame;
+    double min_frame;
+    double max_frame;
+    // standard deviation of the frame time
+    double jitter;
+
+    // time blocked on the frame fence, high when the gpu is the bottleneck
+    double avg_fence_wait;
+    // time blocked acquiring a swapchain image, high when presentation is the bottleneck
+    double avg_acquire_wait;
+};
+
 struct bs_Plane {
     bs_vec3 point;
     bs_vec3 normal;
@@ -0,0 +1,32 @@
+#ifndef BS_VRAM_H
+#define BS_VRAM_H
+
+#include <bs_types.h>
+
+#define BS_VRAM_BLOCK_SIZE (64 * 1024 * 1024)
+
+/// @brief Finds a memory type index matching a type filter and property flags.
+/// @param filter memoryTypeBits from VkMemoryRequirements
+/// @param properties Required VkMemoryPropertyFlags
+bs_U32 bs_vramMemoryType(bs_U32 filter, bs_U32 properties);
+
+/// @brief Suballocates device memory out of a large per memory type block.
+/// Host visible memory is persistently mapped, see bs_VramAllocation.mapped.
+/// @param size Size in bytes
+/// @param alignment Required alignment of the offset
+/// @param type_filter memoryTypeBits from VkMemoryRequirements
+/// @param properties Required VkMemoryPropertyFlags
+/// @param optimal True for optimally tiled images, kept in separate blocks to satisfy bufferImageGranularity
+/// @return The allocation, bind with vkBind*Memory(memory, offset)
+bs_VramAllocation bs_vramAlloc(bs_U64 size, bs_U64 alignment, bs_U32 type_filter, bs_U32 properties, bool optimal);
+
+/// @brief Returns a range allocated with bs_vramAlloc() to its block.
+void bs_vramFree(bs_VramAllocation* allocation);
+
+/// @brief Usage statistics over every memory type.
+bs_VramStats bs_vramStats();
+
+/// @brief Frees every block, called on shutdown.
+void bs_freeVram();
+
+#endif // BS_VRAM_H
@@ -0,0 +1,51 @@
+#ifndef BS_VTEX_H
+#define BS_VTEX_H
+
+#include <bs_types.h>
+
+// texels of a page without its border, pages in the atlas are BS_VTEX_PAGE_SIZE + 2 * BS_VTEX_BORDER wide
+#define BS_VTEX_PAGE_SIZE 128
+#define BS_VTEX_BORDER 4
+#define BS_VTEX_MAX_LEVELS 16
+#define BS_VTEX_MAX_TEXTURES 64
+
+// page reads in flight, each holds one page of texels
+#define BS_VTEX_MAX_LOADS 32
+#define BS_VTEX_UPLOADS_PER_FRAME 16
+
+// page table entries as shaders read them from BS_SPACE_VTEX_PAGES
+#define BS_VTEX_ENTRY_X(entry) ((entry) & 0x3FF)
+#define BS_VTEX_ENTRY_Y(entry) (((entry) >> 10) & 0x3FF)
+#define BS_VTEX_ENTRY_LEVEL(entry) (((entry) >> 20) & 0x1F)
+#define BS_VTEX_ENTRY_VALID (1u << 30)
+
+/// @brief Creates the page atlas and the page table and feedback spaces.
+/// Shaders look up entry first_entry + level offset + page index in BS_SPACE_VTEX_PAGES, which maps to the
+/// closest resident level, sample the atlas through its bindless slot, and set bit (entry index) of BS_SPACE_VTEX_FEEDBACK
+/// with atomicOr for the page they wanted.
+/// @param max_entries Page table entries over every virtual texture
+/// @param atlas_pages Pages per side of the atlas, at most 1024. Lowered to what fits maxImageDimension2D
+void bs_prepareVirtualTextures(bs_U32 max_entries, bs_U32 atlas_pages);
+
+/// @brief Opens a page file written by "bscook in.png out.bsvt vtex", nothing is read until pages are requested.
+/// The coarsest level is loaded right away and never evicted, it's what every page falls back to.
+bs_VirtualTexture bs_virtualTexture(const char* path);
+
+/// @return Bindless slot of the page atlas
+bs_U32 bs_vtexAtlasSlot();
+
+/// @return Number of pages in the atlas that hold a page
+bs_U32 bs_residentPages();
+
+/// @brief Reads the feedback of the frame whose slot is about to be reused, touches or requests its pages,
+/// uploads finished reads over the least recently used pages and starts new reads. Called by bs_render() before tick.
+void bs_updateVirtualTextures();
+
+/// @brief Makes the feedback written by this frame's shaders visible to bs_updateVirtualTextures() once the frame's fence
+/// has been waited on. Called by bs_render() after tick, when every render pass of the frame has been recorded.
+void bs_recordFeedbackBarrier(void* command_buffer);
+
+/// @brief Destroys the atlas and closes every virtual texture, called by bs_cleanup().
+void bs_freeVirtualTextures();
+
+#endif // BS_VTEX_H
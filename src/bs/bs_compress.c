@@ -0,0 +1,211 @@
+#include <bs_types.h>
+#include <bs_compress.h>
+
+#include <string.h>
+
+// - crc -
+// reflected polynomial 0xEDB88320, precomputed so jobs can checksum without any setup
+static const bs_U32 crc_table[256] = {
+    0x00000000, 0x77073096, 0xEE0E612C, 0x990951BA, 0x076DC419, 0x706AF48F, 0xE963A535, 0x9E6495A3,
+    0x0EDB8832, 0x79DCB8A4, 0xE0D5E91E, 0x97D2D988, 0x09B64C2B, 0x7EB17CBD, 0xE7B82D07, 0x90BF1D91,
+    0x1DB71064, 0x6AB020F2, 0xF3B97148, 0x84BE41DE, 0x1ADAD47D, 0x6DDDE4EB, 0xF4D4B551, 0x83D385C7,
+    0x136C9856, 0x646BA8C0, 0xFD62F97A, 0x8A65C9EC, 0x14015C4F, 0x63066CD9, 0xFA0F3D63, 0x8D080DF5,
+    0x3B6E20C8, 0x4C69105E, 0xD56041E4, 0xA2677172, 0x3C03E4D1, 0x4B04D447, 0xD20D85FD, 0xA50AB56B,
+    0x35B5A8FA, 0x42B2986C, 0xDBBBC9D6, 0xACBCF940, 0x32D86CE3, 0x45DF5C75, 0xDCD60DCF, 0xABD13D59,
+    0x26D930AC, 0x51DE003A, 0xC8D75180, 0xBFD06116, 0x21B4F4B5, 0x56B3C423, 0xCFBA9599, 0xB8BDA50F,
+    0x2802B89E, 0x5F058808, 0xC60CD9B2, 0xB10BE924, 0x2F6F7C87, 0x58684C11, 0xC1611DAB, 0xB6662D3D,
+    0x76DC4190, 0x01DB7106, 0x98D220BC, 0xEFD5102A, 0x71B18589, 0x06B6B51F, 0x9FBFE4A5, 0xE8B8D433,
+    0x7807C9A2, 0x0F00F934, 0x9609A88E, 0xE10E9818, 0x7F6A0DBB, 0x086D3D2D, 0x91646C97, 0xE6635C01,
+    0x6B6B51F4, 0x1C6C6162, 0x856530D8, 0xF262004E, 0x6C0695ED, 0x1B01A57B, 0x8208F4C1, 0xF50FC457,
+    0x65B0D9C6, 0x12B7E950, 0x8BBEB8EA, 0xFCB9887C, 0x62DD1DDF, 0x15DA2D49, 0x8CD37CF3, 0xFBD44C65,
+    0x4DB26158, 0x3AB551CE, 0xA3BC0074, 0xD4BB30E2, 0x4ADFA541, 0x3DD895D7, 0xA4D1C46D, 0xD3D6F4FB,
+    0x4369E96A, 0x346ED9FC, 0xAD678846, 0xDA60B8D0, 0x44042D73, 0x33031DE5, 0xAA0A4C5F, 0xDD0D7CC9,
+    0x5005713C, 0x270241AA, 0xBE0B1010, 0xC90C2086, 0x5768B525, 0x206F85B3, 0xB966D409, 0xCE61E49F,
+    0x5EDEF90E, 0x29D9C998, 0xB0D09822, 0xC7D7A8B4, 0x59B33D17, 0x2EB40D81, 0xB7BD5C3B, 0xC0BA6CAD,
+    0xEDB88320, 0x9ABFB3B6, 0x03B6E20C, 0x74B1D29A, 0xEAD54739, 0x9DD277AF, 0x04DB2615, 0x73DC1683,
+    0xE3630B12, 0x94643B84, 0x0D6D6A3E, 0x7A6A5AA8, 0xE40ECF0B, 0x9309FF9D, 0x0A00AE27, 0x7D079EB1,
+    0xF00F9344, 0x8708A3D2, 0x1E01F268, 0x6906C2FE, 0xF762575D, 0x806567CB, 0x196C3671, 0x6E6B06E7,
+    0xFED41B76, 0x89D32BE0, 0x10DA7A5A, 0x67DD4ACC, 0xF9B9DF6F, 0x8EBEEFF9, 0x17B7BE43, 0x60B08ED5,
+    0xD6D6A3E8, 0xA1D1937E, 0x38D8C2C4, 0x4FDFF252, 0xD1BB67F1, 0xA6BC5767, 0x3FB506DD, 0x48B2364B,
+    0xD80D2BDA, 0xAF0A1B4C, 0x36034AF6, 0x41047A60, 0xDF60EFC3, 0xA867DF55, 0x316E8EEF, 0x4669BE79,
+    0xCB61B38C, 0xBC66831A, 0x256FD2A0, 0x5268E236, 0xCC0C7795, 0xBB0B4703, 0x220216B9, 0x5505262F,
+    0xC5BA3BBE, 0xB2BD0B28, 0x2BB45A92, 0x5CB36A04, 0xC2D7FFA7, 0xB5D0CF31, 0x2CD99E8B, 0x5BDEAE1D,
+    0x9B64C2B0, 0xEC63F226, 0x756AA39C, 0x026D930A, 0x9C0906A9, 0xEB0E363F, 0x72076785, 0x05005713,
+    0x95BF4A82, 0xE2B87A14, 0x7BB12BAE, 0x0CB61B38, 0x92D28E9B, 0xE5D5BE0D, 0x7CDCEFB7, 0x0BDBDF21,
+    0x86D3D2D4, 0xF1D4E242, 0x68DDB3F8, 0x1FDA836E, 0x81BE16CD, 0xF6B9265B, 0x6FB077E1, 0x18B74777,
+    0x88085AE6, 0xFF0F6A70, 0x66063BCA, 0x11010B5C, 0x8F659EFF, 0xF862AE69, 0x616BFFD3, 0x166CCF45,
+    0xA00AE278, 0xD70DD2EE, 0x4E048354, 0x3903B3C2, 0xA7672661, 0xD06016F7, 0x4969474D, 0x3E6E77DB,
+    0xAED16A4A, 0xD9D65ADC, 0x40DF0B66, 0x37D83BF0, 0xA9BCAE53, 0xDEBB9EC5, 0x47B2CF7F, 0x30B5FFE9,
+    0xBDBDF21C, 0xCABAC28A, 0x53B39330, 0x24B4A3A6, 0xBAD03605, 0xCDD70693, 0x54DE5729, 0x23D967BF,
+    0xB3667A2E, 0xC4614AB8, 0x5D681B02, 0x2A6F2B94, 0xB40BBE37, 0xC30C8EA1, 0x5A05DF1B, 0x2D02EF8D
+};
+
+bs_U32 bs_crc32(bs_U32 crc, const void* data, bs_U64 size) {
+    const bs_U8* bytes = data;
+    crc = ~crc;
+
+    for(bs_U64 i = 0; i < size; i++) {
+        crc = crc_table[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    }
+
+    return ~crc;
+}
+
+// - lz4 -
+// sequences are a token of 4 bit literal and match lengths, the literals, a 2 byte offset and length extensions.
+// the last 5 bytes are always literals and no match starts in the last 12
+#define BS_LZ4_MIN_MATCH 4
+#define BS_LZ4_LAST_LITERALS 5
+#define BS_LZ4_MF_LIMIT 12
+#define BS_LZ4_MAX_OFFSET 65535
+#define BS_LZ4_HASH_BITS 16
+
+static bs_U32 bs_lz4Read32(const bs_U8* p) {
+    bs_U32 value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static bs_U32 bs_lz4Hash(bs_U32 sequence) {
+    return (sequence * 2654435761u) >> (32 - BS_LZ4_HASH_BITS);
+}
+
+static bs_U8* bs_lz4Length(bs_U8* op, bs_U64 length) {
+    for(; length >= 255; length -= 255) {
+        *op++ = 255;
+    }
+
+    *op++ = (bs_U8)length;
+    return op;
+}
+
+static bs_U8* bs_lz4Sequence(bs_U8* op, const bs_U8* literals, bs_U64 num_literals, bs_U32 offset, bs_U64 match_len) {
+    bs_U8* token = op++;
+    *token = (bs_U8)((num_literals >= 15 ? 15 : num_literals) << 4);
+    if(num_literals >= 15) {
+        op = bs_lz4Length(op, num_literals - 15);
+    }
+
+    memcpy(op, literals, num_literals);
+    op += num_literals;
+
+    // the last sequence has no match
+    if(match_len == 0) {
+        return op;
+    }
+
+    *op++ = (bs_U8)(offset & 0xFF);
+    *op++ = (bs_U8)(offset >> 8);
+
+    match_len -= BS_LZ4_MIN_MATCH;
+    *token |= (bs_U8)(match_len >= 15 ? 15 : match_len);
+    if(match_len >= 15) {
+        op = bs_lz4Length(op, match_len - 15);
+    }
+
+    return op;
+}
+
+bs_U64 bs_lz4Bound(bs_U64 size) {
+    return size + size / 255 + 16;
+}
+
+// greedy with a single hash table of the last position of every 4 byte sequence
+bs_U64 bs_lz4Compress(const void* src, bs_U64 size, void* dst) {
+    static bs_U32 table[1 << BS_LZ4_HASH_BITS];
+
+    const bs_U8* base = src;
+    const bs_U8* ip = base;
+    const bs_U8* anchor = base;
+    const bs_U8* end = base + size;
+    bs_U8* op = dst;
+
+    if(size > BS_LZ4_MF_LIMIT) {
+        const bs_U8* mf_limit = end - BS_LZ4_MF_LIMIT;
+        const bs_U8* match_limit = end - BS_LZ4_LAST_LITERALS;
+        memset(table, 0, sizeof(table));
+
+        while(ip < mf_limit) {
+            bs_U32 sequence = bs_lz4Read32(ip);
+            bs_U32 h = bs_lz4Hash(sequence);
+            const bs_U8* ref = base + table[h];
+            table[h] = (bs_U32)(ip - base);
+
+            if(ref >= ip || ip - ref > BS_LZ4_MAX_OFFSET || bs_lz4Read32(ref) != sequence) {
+                ip++;
+                continue;
+            }
+
+            const bs_U8* match_end = ip + BS_LZ4_MIN_MATCH;
+            const bs_U8* ref_end = ref + BS_LZ4_MIN_MATCH;
+            while(match_end < match_limit && *match_end == *ref_end) {
+                match_end++;
+                ref_end++;
+            }
+
+            while(ip > anchor && ref > base && ip[-1] == ref[-1]) {
+                ip--;
+                ref--;
+            }
+
+            op = bs_lz4Sequence(op, anchor, ip - anchor, (bs_U32)(ip - ref), match_end - ip);
+            ip = anchor = match_end;
+        }
+    }
+
+    op = bs_lz4Sequence(op, anchor, end - anchor, 0, 0);
+    return op - (bs_U8*)dst;
+}
+
+static bool bs_lz4ReadLength(const bs_U8** ip, const bs_U8* end, bs_U64* length) {
+    bs_U8 b;
+    do {
+        if(*ip >= end) return false;
+        b = *(*ip)++;
+        *length += b;
+    } while(b == 255);
+
+    return true;
+}
+
+bool bs_lz4Decompress(const void* src, bs_U64 src_size, void* dst, bs_U64 dst_size) {
+    const bs_U8* ip = src;
+    const bs_U8* in_end = ip + src_size;
+    bs_U8* op = dst;
+    bs_U8* out_end = op + dst_size;
+
+    while(ip < in_end) {
+        bs_U8 token = *ip++;
+
+        bs_U64 num_literals = token >> 4;
+        if(num_literals == 15 && !bs_lz4ReadLength(&ip, in_end, &num_literals)) return false;
+        if(num_literals > (bs_U64)(in_end - ip) || num_literals > (bs_U64)(out_end - op)) return false;
+
+        memcpy(op, ip, num_literals);
+        ip += num_literals;
+        op += num_literals;
+
+        if(ip == in_end) break;
+        if(in_end - ip < 2) return false;
+
+        bs_U32 offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if(offset == 0 || offset > (bs_U64)(op - (bs_U8*)dst)) return false;
+
+        bs_U64 match_len = token & 15;
+        if(match_len == 15 && !bs_lz4ReadLength(&ip, in_end, &match_len)) return false;
+        match_len += BS_LZ4_MIN_MATCH;
+        if(match_len > (bs_U64)(out_end - op)) return false;
+
+        // overlapping matches repeat the last offset bytes, so they're copied forwards a byte at a time
+        const bs_U8* match = op - offset;
+        if(offset >= match_len) {
+            memcpy(op, match, match_len);
+            op += match_len;
+        } else {
+            for(bs_U64 i = 0; i < match_len; i++) *op++ = *match++;
+        }
+    }
+
+    return op == out_end;
+}
@@ -4,6 +4,10 @@
 #include <bs_mem.h>
 #include <bs_shaders.h>
 #include <bs_ini.h>
+#include <bs_staging.h>
+#include <bs_vram.h>
+#include <bs_jobs.h>
+#include <bs_profiler.h>
 
 #include <stdio.h>
 #include <string.h>
@@ -16,7 +20,7 @@
 
 // - batches -
 bs_BatchPart bs_batchRange(bs_U32 offset, bs_U32 num) {
-    return (bs_BatchPart){ offset, num };
+    return (bs_BatchPart){ offset, num, 0 };
 }
 
 int bs_batchSize(bs_Batch* batch) {
@@ -101,7 +105,7 @@ bs_BatchPart bs_pushQuad(bs_Batch* batch, bs_Quad quad, bs_RGBA color, bs_Image*
     bs_pushVertex(batch, quad.c, quad.cc, bs_v3s(0.0), color, bs_iv4s(0), bs_v4s(0), ent, img);
     bs_pushVertex(batch, quad.d, quad.cd, bs_v3s(0.0), color, bs_iv4s(0), bs_v4s(0), ent, img);
 
-    return (bs_BatchPart) { batch->index_buf.num_units, batch->index_buf.num_units };
+    return (bs_BatchPart) { batch->index_buf.num_units, batch->index_buf.num_units, 0 };
 }
 
 bs_BatchPart bs_pushTriangle(bs_Batch* batch, bs_vec3 a, bs_vec3 b, bs_vec3 c, bs_RGBA color, bs_ShaderEntity* shader_entity) {
@@ -114,7 +118,7 @@ bs_BatchPart bs_pushTriangle(bs_Batch* batch, bs_vec3 a, bs_vec3 b, bs_vec3 c, b
     bs_pushVertex(batch, b, bs_v2(1.0, 0.0), bs_v3s(0.0), color, bs_iv4s(0), bs_v4s(0.0), entity, 0);
     bs_pushVertex(batch, c, bs_v2(0.0, 1.0), bs_v3s(0.0), color, bs_iv4s(0), bs_v4s(0.0), entity, 0);
 
-    return (bs_BatchPart){ batch->index_buf.num_units, batch->index_buf.num_units };
+    return (bs_BatchPart){ batch->index_buf.num_units, batch->index_buf.num_units, 0 };
 }
 
 bs_Batch bs_batch(bs_Pipeline* pipeline) {
@@ -128,144 +132,459 @@ bs_Batch bs_batch(bs_Pipeline* pipeline) {
     batch.vertex_buf = bs_buffer(batch.pipeline.vs->attrib_size_bytes, BS_BATCH_INCR_BY, 0, 0);
     batch.index_buf  = bs_buffer(sizeof(bs_U32), BS_BATCH_INCR_BY, 0, 0);
 
+    // every vertex and index pushed writes all of its bytes
+    batch.vertex_buf.flags |= BS_BUFFER_NO_ZERO_FILL;
+    batch.index_buf.flags |= BS_BUFFER_NO_ZERO_FILL;
+
     return batch;
 }
 
-static bs_U32 bs_queryMemoryType(uint32_t filter, VkMemoryPropertyFlags props) {
-    VkPhysicalDeviceMemoryProperties mem_props;
-    vkGetPhysicalDeviceMemoryProperties(bs_vkPhysicalDevice(), &mem_props);
-
-    for (uint32_t i = 0; i < mem_props.memoryTypeCount; i++) {
-        if ((filter & (1 << i)) && (mem_props.memoryTypes[i].propertyFlags & props) == props) {
-            return i;
-        }
-    }
-
-    bs_throw("Failed to find memory type");
+bs_Batch bs_staticBatch(bs_Pipeline* pipeline) {
+    bs_Batch batch = bs_batch(pipeline);
+    batch.shared = true;
+    return batch;
 }
 
-void bs_prepareBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer* buffer, VkDeviceMemory* buffer_mem) {
+typedef struct {
+    bs_U32 offset;
+    bs_U32 size;
+} bs_SharedRange;
+
+// one device local vertex and index buffer shared by every static batch
+static struct {
+    VkBuffer vbuffer, ibuffer;
+    bs_VramAllocation vertex_alloc, index_alloc;
+
+    bs_U32 vertex_capacity, index_capacity;
+    bs_U32 vertex_used, index_used;
+
+    // bs_SharedRange, bytes below *_used that were given back by pushing a batch again
+    bs_Buffer free_vertices, free_indices;
+    // bs_SharedRange, given back while a frame in flight could still draw from them
+    bs_Buffer retired_vertices[BS_MAX_FRAMES_IN_FLIGHT];
+    bs_Buffer retired_indices[BS_MAX_FRAMES_IN_FLIGHT];
+} shared = { 0 };
+
+// the vertex/index buffers and pipeline last bound to the command buffer the thread records into
+static BS_THREAD_LOCAL struct {
+    void* pipeline;
+    void* layout;
+    void* vbuffer;
+    void* ibuffer;
+} bound = { 0 };
+
+void bs_prepareBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer* buffer, bs_VramAllocation* allocation) {
     VkBufferCreateInfo buffer_i = { 0 };
     buffer_i.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
     buffer_i.size = size;
     buffer_i.usage = usage;
     buffer_i.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
+    // copied on the transfer queue while the graphics queue reads other ranges, exclusive
+    // ownership would have to go back and forth for every upload submit
+    bs_U32 families[] = { bs_vkGraphicsFamily(), bs_vkTransferFamily() };
+    if(families[0] != families[1] && (usage & (VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT))) {
+        buffer_i.sharingMode = VK_SHARING_MODE_CONCURRENT;
+        buffer_i.queueFamilyIndexCount = 2;
+        buffer_i.pQueueFamilyIndices = families;
+    }
+
     BS_VK_ERR(vkCreateBuffer(bs_vkDevice(), &buffer_i, NULL, buffer), "Failed to create buffer");
 
     VkMemoryRequirements mem_req;
     vkGetBufferMemoryRequirements(bs_vkDevice(), *buffer, &mem_req);
 
-    VkMemoryAllocateInfo alloc_i = { 0 };
-    alloc_i.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    alloc_i.allocationSize = mem_req.size;
-    alloc_i.memoryTypeIndex = bs_queryMemoryType(mem_req.memoryTypeBits, properties);
+    *allocation = bs_vramAlloc(mem_req.size, mem_req.alignment, mem_req.memoryTypeBits, properties, false);
+    vkBindBufferMemory(bs_vkDevice(), *buffer, allocation->memory, allocation->offset);
+}
+
+void bs_sharedGeometry(bs_U32 vertex_bytes, bs_U32 index_bytes) {
+    if(shared.vbuffer != VK_NULL_HANDLE) {
+        bs_throw("Shared geometry buffers already exist");
+    }
+
+    bs_prepareBuffer(
+        vertex_bytes,
+        VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        &shared.vbuffer, &shared.vertex_alloc
+    );
+
+    bs_prepareBuffer(
+        index_bytes,
+        VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        &shared.ibuffer, &shared.index_alloc
+    );
+
+    shared.vertex_capacity = vertex_bytes;
+    shared.index_capacity = index_bytes;
+
+    shared.free_vertices = bs_buffer(sizeof(bs_SharedRange), 16, 0, 0);
+    shared.free_indices = bs_buffer(sizeof(bs_SharedRange), 16, 0, 0);
+    for(bs_U32 i = 0; i < BS_MAX_FRAMES_IN_FLIGHT; i++) {
+        shared.retired_vertices[i] = bs_buffer(sizeof(bs_SharedRange), 16, 0, 0);
+        shared.retired_indices[i] = bs_buffer(sizeof(bs_SharedRange), 16, 0, 0);
+    }
+}
+
+// first fit from the given back ranges, then the end of the used bytes. UINT32_MAX when neither has room
+static bs_U32 bs_sharedAlloc(bs_Buffer* free_ranges, bs_U32* used, bs_U32 capacity, bs_U32 size, bs_U32 alignment) {
+    for(bs_U32 i = 0; i < free_ranges->num_units; i++) {
+        bs_SharedRange* range = bs_bufferData(free_ranges, i);
+        bs_U32 offset = (range->offset + alignment - 1) / alignment * alignment;
+        bs_U32 end = range->offset + range->size;
+        if(offset > end || size > end - offset) continue;
+
+        // the few bytes skipped for alignment are dropped with the front of the range
+        range->offset = offset + size;
+        range->size = end - range->offset;
+        if(range->size == 0) {
+            *range = *(bs_SharedRange*)bs_bufferData(free_ranges, --free_ranges->num_units);
+        }
 
-    BS_VK_ERR(vkAllocateMemory(bs_vkDevice(), &alloc_i, NULL, buffer_mem), "Failed to allocate buffer memory");
+        return offset;
+    }
+
+    bs_U32 offset = (*used + alignment - 1) / alignment * alignment;
+    if(offset > capacity || size > capacity - offset) {
+        return UINT32_MAX;
+    }
 
-    vkBindBufferMemory(bs_vkDevice(), *buffer, *buffer_mem, 0);
+    *used = offset + size;
+    return offset;
 }
 
-void bs_copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size) {
-    VkCommandBufferAllocateInfo alloc_i = { 0 };
-    alloc_i.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    alloc_i.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    alloc_i.commandPool = bs_vkCmdPool();
-    alloc_i.commandBufferCount = 1;
+static void bs_pushSharedBatch(bs_Batch* batch, bs_U32 vertex_size, bs_U32 index_size) {
+    if(shared.vbuffer == VK_NULL_HANDLE) {
+        bs_sharedGeometry(BS_SHARED_VERTEX_SIZE, BS_SHARED_INDEX_SIZE);
+    }
 
-    VkCommandBuffer command_buffer;
-    vkAllocateCommandBuffers(bs_vkDevice(), &alloc_i, &command_buffer);
+    // vertexOffset in vkCmdDrawIndexed counts vertices, so the start has to be a multiple of the stride
+    bs_U32 stride = batch->vertex_buf.unit_size;
 
-    VkCommandBufferBeginInfo begin_i = { 0 };
-    begin_i.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-    begin_i.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    // pushed before, its old bytes are given back once no frame in flight can be drawing them
+    if(batch->vbuffer == shared.vbuffer) {
+        bs_U32 frame = bs_frameData()->swapchain_frame;
+        bs_SharedRange vertices = { batch->base_vertex * stride, batch->shared_vertex_size };
+        bs_SharedRange indices = { batch->first_index * sizeof(bs_U32), batch->shared_index_size };
+        if(vertices.size > 0) bs_bufferAppend(shared.retired_vertices + frame, &vertices);
+        if(indices.size > 0) bs_bufferAppend(shared.retired_indices + frame, &indices);
 
-    vkBeginCommandBuffer(command_buffer, &begin_i);
+        batch->vbuffer = batch->ibuffer = NULL;
+        batch->shared_vertex_size = batch->shared_index_size = 0;
+    }
 
-    VkBufferCopy region = { 0 };
-    region.size = size;
-    vkCmdCopyBuffer(command_buffer, srcBuffer, dstBuffer, 1, &region);
-    vkEndCommandBuffer(command_buffer);
+    bs_U32 vertex_offset = bs_sharedAlloc(&shared.free_vertices, &shared.vertex_used, shared.vertex_capacity, vertex_size, stride);
+    if(vertex_offset == UINT32_MAX) {
+        bs_throw("Shared geometry buffers are full");
+    }
 
-    VkSubmitInfo submit_i = { 0 };
-    submit_i.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    submit_i.commandBufferCount = 1;
-    submit_i.pCommandBuffers = &command_buffer;
+    bs_U32 index_offset = bs_sharedAlloc(&shared.free_indices, &shared.index_used, shared.index_capacity, index_size, sizeof(bs_U32));
+    if(index_offset == UINT32_MAX) {
+        bs_SharedRange vertices = { vertex_offset, vertex_size };
+        bs_bufferAppend(&shared.free_vertices, &vertices);
+        bs_throw("Shared geometry buffers are full");
+    }
+
+    bs_stagingUpload(shared.vbuffer, vertex_offset, batch->vertex_buf.data, vertex_size);
+    bs_stagingUpload(shared.ibuffer, index_offset, batch->index_buf.data, index_size);
 
-    vkQueueSubmit(bs_vkGraphicsQueue(), 1, &submit_i, VK_NULL_HANDLE);
-    vkQueueWaitIdle(bs_vkGraphicsQueue());
-    vkFreeCommandBuffers(bs_vkDevice(), bs_vkCmdPool(), 1, &command_buffer);
+    batch->vbuffer = shared.vbuffer;
+    batch->ibuffer = shared.ibuffer;
+    batch->base_vertex = vertex_offset / stride;
+    batch->first_index = index_offset / sizeof(bs_U32);
+    batch->shared_vertex_size = vertex_size;
+    batch->shared_index_size = index_size;
+}
+
+void bs_recycleSharedGeometry() {
+    if(shared.vbuffer == VK_NULL_HANDLE) {
+        return;
+    }
+
+    // the fence of this frame covers every draw that could still read what it retired
+    bs_U32 frame = bs_frameData()->swapchain_frame;
+    bs_Buffer* vertices = shared.retired_vertices + frame;
+    bs_Buffer* indices = shared.retired_indices + frame;
+    if(vertices->num_units > 0) bs_bufferAppendRange(&shared.free_vertices, vertices->data, vertices->num_units);
+    if(indices->num_units > 0) bs_bufferAppendRange(&shared.free_indices, indices->data, indices->num_units);
+    vertices->num_units = 0;
+    indices->num_units = 0;
 }
 
 void bs_pushBatch(bs_Batch* batch) {
     bs_U32 vertex_size = batch->vertex_buf.num_units * batch->vertex_buf.unit_size;
     bs_U32 index_size = batch->index_buf.num_units * batch->index_buf.unit_size;
 
-    // staging buffer
-    VkBuffer staging_buffer = VK_NULL_HANDLE;
-    VkDeviceMemory staging_memory = VK_NULL_HANDLE;
-
-    bs_prepareBuffer(
-        vertex_size,
-        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 
-        &staging_buffer, &staging_memory
-    );
-
-    void* data;
-    vkMapMemory(bs_vkDevice(), staging_memory, 0, vertex_size, 0, &data);
-    memcpy(data, batch->vertex_buf.data, vertex_size);
-    vkUnmapMemory(bs_vkDevice(), staging_memory);
+    if(batch->shared) {
+        bs_pushSharedBatch(batch, vertex_size, index_size);
+        return;
+    }
 
     // vertex buffer
     VkBuffer vertex_buffer = VK_NULL_HANDLE;
-    VkDeviceMemory vertex_memory = VK_NULL_HANDLE;
 
     bs_prepareBuffer(
         vertex_size, 
         VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
         VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-        &vertex_buffer, &vertex_memory
+        &vertex_buffer, &batch->vertex_alloc
     );
 
-    bs_copyBuffer(staging_buffer, vertex_buffer, vertex_size);
-
     // index buffer
     VkBuffer index_buffer = VK_NULL_HANDLE;
-    VkDeviceMemory index_memory = VK_NULL_HANDLE;
-
-    vkMapMemory(bs_vkDevice(), staging_memory, 0, index_size, 0, &data);
-    memcpy(data, batch->index_buf.data, (size_t) index_size);
-    vkUnmapMemory(bs_vkDevice(), staging_memory);
 
     bs_prepareBuffer(
         index_size, 
         VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, 
         VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 
-        &index_buffer, &index_memory
+        &index_buffer, &batch->index_alloc
     );
 
-    bs_copyBuffer(staging_buffer, index_buffer, index_size);
-    vkDestroyBuffer(bs_vkDevice(), staging_buffer, NULL);
-    vkFreeMemory(bs_vkDevice(), staging_memory, NULL);
+    // the copies are submitted together with every other pending upload by bs_flushUploads()
+    bs_stagingUpload(vertex_buffer, 0, batch->vertex_buf.data, vertex_size);
+    bs_stagingUpload(index_buffer, 0, batch->index_buf.data, index_size);
 
     batch->vbuffer = vertex_buffer;
     batch->ibuffer = index_buffer;
 }
 
-void bs_selectBatch(bs_Batch* batch) {
+static void bs_bindState(VkCommandBuffer command_buffer, bs_Pipeline* source, void* pipeline, void* vbuffer, void* ibuffer) {
     VkDeviceSize offsets[] = { 0 };
 
-    VkCommandBuffer command_buffer = bs_vkHandle(bs_handleOffsets()->command_buffers + bs_frameData()->swapchain_frame);
+    // static batches share buffers, so in most cases only the pipeline changes
+    if(bound.pipeline != pipeline) {
+        vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+        bound.pipeline = pipeline;
+        bound.layout = bs_bindPipelineLayout(command_buffer, source);
+    }
+
+    if(bound.vbuffer != vbuffer) {
+        vkCmdBindVertexBuffers(command_buffer, 0, 1, (VkBuffer*)&vbuffer, offsets);
+        bound.vbuffer = vbuffer;
+    }
 
-    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, batch->pipeline.state);
-    vkCmdBindVertexBuffers(command_buffer, 0, 1, &batch->vbuffer, offsets);
-    vkCmdBindIndexBuffer(command_buffer, batch->ibuffer, 0, VK_INDEX_TYPE_UINT32);
+    if(bound.ibuffer != ibuffer) {
+        vkCmdBindIndexBuffer(command_buffer, ibuffer, 0, VK_INDEX_TYPE_UINT32);
+        bound.ibuffer = ibuffer;
+    }
+}
+
+// records the queued indirect draws of the thread, true if there were any. Defined with the rest of the indirect path
+static bool bs_flushIndirect(VkCommandBuffer command_buffer);
+
+// a batch scope runs from bs_selectBatch() to the next one or the end of the render pass
+static BS_THREAD_LOCAL bool batch_scope = false;
+// the selected batch has no pipeline to draw with yet
+static BS_THREAD_LOCAL bool skip_draws = false;
+
+static void bs_endBatchScope() {
+    if(batch_scope) {
+        bs_profileEnd();
+        batch_scope = false;
+    }
+}
+
+void bs_selectBatch(bs_Batch* batch) {
+    bs_endBatchScope();
+    bs_profileBegin("batch");
+    batch_scope = true;
+
+    // indirect draws queued so far go first, they'd end up behind everything drawn from here on otherwise
+    VkCommandBuffer command_buffer = bs_vkCmdBuffer();
+    bs_flushIndirect(command_buffer);
+
+    void* pipeline = bs_pipelineState(&batch->pipeline);
+    skip_draws = pipeline == NULL;
+    if(skip_draws) return;
+
+    bs_bindState(command_buffer, &batch->pipeline, pipeline, batch->vbuffer, batch->ibuffer);
+}
+
+void bs_pushConstants(const void* data, bs_U32 offset, bs_U32 size) {
+    if(skip_draws || bound.layout == NULL) return;
+    vkCmdPushConstants(bs_vkCmdBuffer(), bound.layout, VK_SHADER_STAGE_ALL_GRAPHICS, offset, size, data);
 }
 
 void bs_renderBatch(bs_Batch* batch, bs_BatchPart range, bs_RenderType render_type) {
-    bs_U32 offset = bs_handleOffsets()->command_buffers + bs_frameData()->swapchain_frame;
-    vkCmdDrawIndexed(bs_vkHandle(offset), range.num, 1, range.offset, 0, 0);
+    if(skip_draws) return;
+    VkCommandBuffer command_buffer = bs_vkCmdBuffer();
+
+    // indirect draws queued since the batch was selected bind their own state, the batch's is bound again after them
+    if(bs_flushIndirect(command_buffer)) {
+        bs_bindState(command_buffer, &batch->pipeline, bs_pipelineState(&batch->pipeline), batch->vbuffer, batch->ibuffer);
+    }
+
+    vkCmdDrawIndexed(command_buffer, range.num, 1, batch->first_index + range.offset, batch->base_vertex + range.base_vertex, 0);
+}
+
+// - indirect draws -
+typedef struct {
+    // the first batch of the group, its shader spaces are bound with the pipeline
+    bs_Pipeline source;
+
+    void* pipeline;
+    void* vbuffer;
+    void* ibuffer;
+
+    // VkDrawIndexedIndirectCommand, emptied every render pass
+    bs_Buffer commands;
+} bs_IndirectGroup;
+
+// draws are grouped by the state they need bound, every group is written into the per frame indirect
+// buffer and drawn with a single call at the next bind, direct draw or the end of the render pass
+static struct {
+    VkBuffer buffers[BS_MAX_FRAMES_IN_FLIGHT];
+    bs_VramAllocation allocations[BS_MAX_FRAMES_IN_FLIGHT];
+
+    // commands written this frame, threads recording secondaries reserve ranges atomically
+    volatile bs_I32 used;
+    bs_U64 frame_num;
+
+    bool first_instance;
+    bs_U32 max_draw_count;
+} indirect = { 0 };
+
+// every recording thread collects its own groups
+static BS_THREAD_LOCAL struct {
+    bs_Buffer groups;
+    bs_U32 last_group;
+    // commands over every group that haven't been recorded yet
+    bs_U32 num_pending;
+} thread_indirect = { 0 };
+
+static void bs_prepareIndirect() {
+    VkPhysicalDeviceFeatures* features = bs_vkFeatures();
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(bs_vkPhysicalDevice(), &properties);
+
+    // firstInstance has to be 0 in the buffer without drawIndirectFirstInstance, so every command becomes a direct draw.
+    // without multiDrawIndirect the commands are still read from the buffer, one per call
+    indirect.first_instance = features->drawIndirectFirstInstance;
+    indirect.max_draw_count = features->multiDrawIndirect ? properties.limits.maxDrawIndirectCount : 1;
+
+    for(int i = 0; i < bs_framesInFlight(); i++) {
+        bs_prepareBuffer(
+            BS_MAX_INDIRECT_DRAWS * sizeof(VkDrawIndexedIndirectCommand),
+            VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            indirect.buffers + i, indirect.allocations + i
+        );
+    }
+}
+
+// called from the main thread before anything is recorded into a render pass
+static void bs_beginIndirect() {
+    if(indirect.buffers[0] == VK_NULL_HANDLE) {
+        bs_prepareIndirect();
+    }
+
+    // the slot of this frame was waited on before recording, so its buffer is free to overwrite
+    if(indirect.frame_num != bs_frameData()->frame_num) {
+        indirect.frame_num = bs_frameData()->frame_num;
+        indirect.used = 0;
+    }
+}
+
+static bs_IndirectGroup* bs_indirectGroup(bs_Pipeline* source, void* pipeline, void* vbuffer, void* ibuffer) {
+    bs_Buffer* groups = &thread_indirect.groups;
+    bs_IndirectGroup* group = NULL;
+
+    if(groups->unit_size == 0) {
+        *groups = bs_buffer(sizeof(bs_IndirectGroup), 8, 8, 0);
+    }
+
+    if(thread_indirect.last_group < groups->num_units) {
+        group = bs_bufferData(groups, thread_indirect.last_group);
+        if(group->pipeline == pipeline && group->vbuffer == vbuffer && group->ibuffer == ibuffer) {
+            return group;
+        }
+    }
+
+    for(bs_U32 i = 0; i < groups->num_units; i++) {
+        group = bs_bufferData(groups, i);
+        if(group->pipeline == pipeline && group->vbuffer == vbuffer && group->ibuffer == ibuffer) {
+            thread_indirect.last_group = i;
+            return group;
+        }
+    }
+
+    thread_indirect.last_group = groups->num_units;
+
+    group = bs_bufferAppend(groups, NULL);
+    group->source = *source;
+    group->pipeline = pipeline;
+    group->vbuffer = vbuffer;
+    group->ibuffer = ibuffer;
+    group->commands = bs_buffer(sizeof(VkDrawIndexedIndirectCommand), 256, 256, 0);
+
+    return group;
+}
+
+void bs_renderBatchIndirect(bs_Batch* batch, bs_BatchPart range, bs_U32 instance) {
+    void* pipeline = bs_pipelineState(&batch->pipeline);
+    if(pipeline == NULL) return;
+
+    bs_IndirectGroup* group = bs_indirectGroup(&batch->pipeline, pipeline, batch->vbuffer, batch->ibuffer);
+
+    VkDrawIndexedIndirectCommand* command = bs_bufferAppend(&group->commands, NULL);
+    command->indexCount = range.num;
+    command->instanceCount = 1;
+    command->firstIndex = batch->first_index + range.offset;
+    command->vertexOffset = batch->base_vertex + range.base_vertex;
+    command->firstInstance = instance;
+    thread_indirect.num_pending++;
+}
+
+static bool bs_flushIndirect(VkCommandBuffer command_buffer) {
+    bs_Buffer* groups = &thread_indirect.groups;
+    if(thread_indirect.num_pending == 0) {
+        return false;
+    }
+
+    thread_indirect.num_pending = 0;
+
+    bs_WindowFrame* frame = bs_frameData();
+    VkBuffer buffer = indirect.buffers[frame->swapchain_frame];
+    VkDrawIndexedIndirectCommand* mapped = indirect.allocations[frame->swapchain_frame].mapped;
+    bs_U32 stride = sizeof(VkDrawIndexedIndirectCommand);
+
+    for(bs_U32 i = 0; i < groups->num_units; i++) {
+        bs_IndirectGroup* group = bs_bufferData(groups, i);
+        bs_U32 num_commands = group->commands.num_units;
+        if(num_commands == 0) continue;
+
+        bs_bindState(command_buffer, &group->source, group->pipeline, group->vbuffer, group->ibuffer);
+
+        if(!indirect.first_instance) {
+            for(bs_U32 j = 0; j < num_commands; j++) {
+                VkDrawIndexedIndirectCommand* command = bs_bufferData(&group->commands, j);
+                vkCmdDrawIndexed(command_buffer, command->indexCount, 1, command->firstIndex, command->vertexOffset, command->firstInstance);
+            }
+
+            group->commands.num_units = 0;
+            continue;
+        }
+
+        bs_U32 start = bs_atomicAdd(&indirect.used, num_commands) - num_commands;
+        if(start + num_commands > BS_MAX_INDIRECT_DRAWS) {
+            bs_throw("Too many indirect draws in one frame");
+        }
+
+        memcpy(mapped + start, group->commands.data, num_commands * stride);
+
+        for(bs_U32 first = 0; first < num_commands; first += indirect.max_draw_count) {
+            bs_U32 num = num_commands - first;
+            if(num > indirect.max_draw_count) num = indirect.max_draw_count;
+
+            vkCmdDrawIndexedIndirect(command_buffer, buffer, (start + first) * stride, num, stride);
+        }
+
+        group->commands.num_units = 0;
+    }
+
+    return true;
 }
 
 // - renderer -
@@ -297,7 +616,8 @@ void bs_pushRenderer(bs_Renderer* renderer) {
         attachment->stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
         attachment->stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
         attachment->initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-        attachment->finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+        // headless frames are copied out instead of presented
+        attachment->finalLayout = bs_headless() ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 
         switch(renderer->attachments[i].type) {
             // todo check if formats are supported
@@ -330,6 +650,20 @@ void bs_pushRenderer(bs_Renderer* renderer) {
     render_pass_ci.subpassCount = 1;
     render_pass_ci.pSubpasses = &subpass;
 
+    // headless frames are copied out after the render pass, the copy has to wait for the color writes
+    VkSubpassDependency readback_dependency = { 0 };
+    readback_dependency.srcSubpass = 0;
+    readback_dependency.dstSubpass = VK_SUBPASS_EXTERNAL;
+    readback_dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    readback_dependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    readback_dependency.dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    readback_dependency.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+    if(bs_headless()) {
+        render_pass_ci.dependencyCount = 1;
+        render_pass_ci.pDependencies = &readback_dependency;
+    }
+
     BS_VK_ERR(vkCreateRenderPass(bs_vkDevice(), &render_pass_ci, NULL, &renderer->render_pass), "Failed to create render pass");
 
     // framebuffer
@@ -350,8 +684,11 @@ void bs_pushRenderer(bs_Renderer* renderer) {
     }
 }
 
-void bs_selectRenderer(bs_Renderer* renderer) {
-    VkCommandBuffer command_buffer = bs_vkHandle(bs_handleOffsets()->command_buffers + bs_frameData()->swapchain_frame);
+static void bs_beginRenderPass(bs_Renderer* renderer, VkSubpassContents contents) {
+    VkCommandBuffer command_buffer = bs_vkCmdBuffer();
+
+    memset(&bound, 0, sizeof(bound));
+    bs_beginIndirect();
 
     VkRenderPassBeginInfo render_pass_i = { 0 };
     render_pass_i.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
@@ -363,8 +700,11 @@ void bs_selectRenderer(bs_Renderer* renderer) {
     VkClearValue clear_color = {{{ 0.0f, 0.0f, 0.0f, 1.0f }}};
     render_pass_i.clearValueCount = 1;
     render_pass_i.pClearValues = &clear_color;
-    vkCmdBeginRenderPass(command_buffer, &render_pass_i, VK_SUBPASS_CONTENTS_INLINE);
+    vkCmdBeginRenderPass(command_buffer, &render_pass_i, contents);
+}
 
+// dynamic state isn't inherited by secondary command buffers, so every one of them sets it again
+static void bs_setViewport(VkCommandBuffer command_buffer, bs_Renderer* renderer) {
     VkViewport viewport = { 0 };
     viewport.x = 0.0f;
     viewport.y = 0.0f;
@@ -380,7 +720,141 @@ void bs_selectRenderer(bs_Renderer* renderer) {
     vkCmdSetScissor(command_buffer, 0, 1, &scissor);
 }
 
+void bs_selectRenderer(bs_Renderer* renderer) {
+    bs_profileBegin("renderer");
+    bs_beginRenderPass(renderer, VK_SUBPASS_CONTENTS_INLINE);
+    bs_setViewport(bs_vkCmdBuffer(), renderer);
+}
+
 void bs_commitRenderer(bs_Renderer* renderer) {
-    VkCommandBuffer command_buffer = bs_vkHandle(bs_handleOffsets()->command_buffers + bs_frameData()->swapchain_frame);
+    VkCommandBuffer command_buffer = bs_vkCmdBuffer();
+    bs_endBatchScope();
+    bs_flushIndirect(command_buffer);
     vkCmdEndRenderPass(command_buffer);
+    bs_profileEnd();
+}
+
+// - multithreaded recording -
+// secondary command buffers come from one pool per thread and frame in flight, so threads
+// never share a pool and a pool is reset once the fence of its frame has been waited on
+typedef struct {
+    VkCommandPool pool;
+    bs_Buffer command_buffers;
+    bs_U32 used;
+    bs_U64 frame_num;
+} bs_Recorder;
+
+static bs_Recorder recorders[BS_MAX_JOB_THREADS][BS_MAX_FRAMES_IN_FLIGHT] = { 0 };
+
+typedef struct {
+    bs_Renderer* renderer;
+    VkFramebuffer framebuffer;
+
+    bs_JobFn job;
+    void* param;
+
+    VkCommandBuffer* command_buffers;
+} bs_RecordJobs;
+
+static VkCommandBuffer bs_recorderCommandBuffer() {
+    bs_WindowFrame* frame = bs_frameData();
+    bs_Recorder* recorder = &recorders[bs_jobThreadIndex()][frame->swapchain_frame];
+
+    if(recorder->pool == VK_NULL_HANDLE) {
+        VkCommandPoolCreateInfo pool_ci = { 0 };
+        pool_ci.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        pool_ci.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+        pool_ci.queueFamilyIndex = bs_vkGraphicsFamily();
+
+        BS_VK_ERR(vkCreateCommandPool(bs_vkDevice(), &pool_ci, NULL, &recorder->pool), "Failed to create a recording command pool");
+
+        recorder->command_buffers = bs_buffer(sizeof(VkCommandBuffer), 8, 8, 0);
+        recorder->frame_num = frame->frame_num;
+    } else if(recorder->frame_num != frame->frame_num) {
+        vkResetCommandPool(bs_vkDevice(), recorder->pool, 0);
+        recorder->frame_num = frame->frame_num;
+        recorder->used = 0;
+    }
+
+    if(recorder->used == recorder->command_buffers.num_units) {
+        VkCommandBufferAllocateInfo alloc_i = { 0 };
+        alloc_i.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        alloc_i.commandPool = recorder->pool;
+        alloc_i.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+        alloc_i.commandBufferCount = 1;
+
+        VkCommandBuffer command_buffer = VK_NULL_HANDLE;
+        BS_VK_ERR(vkAllocateCommandBuffers(bs_vkDevice(), &alloc_i, &command_buffer), "Failed to allocate secondary command buffer");
+        bs_bufferAppend(&recorder->command_buffers, &command_buffer);
+    }
+
+    return *(VkCommandBuffer*)bs_bufferData(&recorder->command_buffers, recorder->used++);
+}
+
+static void bs_recordJob(void* param, bs_U32 index) {
+    bs_RecordJobs* record = param;
+    VkCommandBuffer command_buffer = bs_recorderCommandBuffer();
+
+    VkCommandBufferInheritanceInfo inheritance_i = { 0 };
+    inheritance_i.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritance_i.renderPass = record->renderer->render_pass;
+    inheritance_i.subpass = 0;
+    inheritance_i.framebuffer = record->framebuffer;
+
+    VkCommandBufferBeginInfo begin_i = { 0 };
+    begin_i.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    begin_i.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+    begin_i.pInheritanceInfo = &inheritance_i;
+
+    BS_VK_ERR(vkBeginCommandBuffer(command_buffer, &begin_i), "Failed to begin secondary recording");
+
+    // everything the job calls records into the secondary command buffer
+    bs_setVkCmdBuffer(command_buffer);
+    memset(&bound, 0, sizeof(bound));
+    bs_setViewport(command_buffer, record->renderer);
+
+    record->job(record->param, index);
+
+    bs_endBatchScope();
+    bs_flushIndirect(command_buffer);
+    bs_setVkCmdBuffer(NULL);
+
+    BS_VK_ERR(vkEndCommandBuffer(command_buffer), "Failed to record secondary commands");
+    record->command_buffers[index] = command_buffer;
+}
+
+void bs_recordJobs(bs_Renderer* renderer, bs_JobFn job, void* param, bs_U32 num_jobs) {
+    VkCommandBuffer command_buffer = bs_vkCmdBuffer();
+    bs_profileBegin("renderer");
+    bs_beginRenderPass(renderer, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+
+    bs_RecordJobs record = { 0 };
+    record.renderer = renderer;
+    record.framebuffer = bs_vkHandle(renderer->handle + bs_swapchainImage());
+    record.job = job;
+    record.param = param;
+    record.command_buffers = bs_alloc(num_jobs * sizeof(VkCommandBuffer));
+
+    bs_profileDispatch();
+    bs_runJobs(bs_recordJob, &record, num_jobs);
+
+    // executed in job order, whichever thread finished first doesn't matter
+    vkCmdExecuteCommands(command_buffer, num_jobs, record.command_buffers);
+    vkCmdEndRenderPass(command_buffer);
+    bs_profileEnd();
+
+    bs_free(record.command_buffers);
+}
+
+void bs_freeRecorders() {
+    for(int i = 0; i < BS_MAX_JOB_THREADS; i++) {
+        for(int j = 0; j < BS_MAX_FRAMES_IN_FLIGHT; j++) {
+            bs_Recorder* recorder = &recorders[i][j];
+            if(recorder->pool == VK_NULL_HANDLE) continue;
+
+            vkDestroyCommandPool(bs_vkDevice(), recorder->pool, NULL);
+            bs_free(recorder->command_buffers.data);
+            memset(recorder, 0, sizeof(bs_Recorder));
+        }
+    }
 }
\ No newline at end of file
@@ -0,0 +1,504 @@
+#include <bs_types.h>
+#include <bs_ini.h>
+#include <bs_mem.h>
+#include <bs_vram.h>
+#include <bs_descriptors.h>
+
+#include <string.h>
+
+#include <vulkan.h>
+
+void bs_prepareBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer* buffer, bs_VramAllocation* allocation);
+
+typedef struct {
+    bool used;
+    bs_U32 type;
+    bs_U32 unit_size;
+    bs_U32 num_units;
+
+    // latest contents, slots are brought up to date from here when their frame comes around
+    bs_U8* shadow;
+
+    VkBuffer buffer;
+    bs_VramAllocation allocation;
+    VkDeviceSize slot_size;
+
+    // bytes changed since each slot was last written, begin == end when clean
+    bs_U32 dirty_begin[BS_MAX_FRAMES_IN_FLIGHT];
+    bs_U32 dirty_end[BS_MAX_FRAMES_IN_FLIGHT];
+} bs_SpaceSlot;
+
+typedef struct {
+    VkDescriptorSetLayout set_layout;
+    bs_ShaderBinding bindings[BS_MAX_SHADER_BINDINGS];
+    bs_U32 num_bindings;
+    void** out_set;
+} bs_SpaceSetRequest;
+
+static struct {
+    // VkDescriptorPool, sets are allocated from the last one
+    bs_Buffer pools;
+
+    bs_SpaceSlot spaces[BS_MAX_SPACES];
+    // bs_SpaceSetRequest, sets waiting on a space that doesn't exist yet
+    bs_Buffer requests;
+} descriptors = { 0 };
+
+static struct {
+    VkDescriptorSetLayout set_layout;
+    VkDescriptorPool pool;
+    VkDescriptorSet set;
+    VkSampler samplers[BS_NUM_BINDLESS_SAMPLERS];
+    bs_U32 capacity;
+
+    // slots below next_slot that were freed, popped before next_slot grows
+    bs_U32* free_slots;
+    bs_U32 num_free;
+    bs_U32 next_slot;
+    // one bit per slot, set while an image holds it
+    bs_U32* occupied;
+
+    // slots freed while a frame in flight could still sample them, recycled once its fence is waited on
+    bs_Buffer retired[BS_MAX_FRAMES_IN_FLIGHT];
+} bindless = { 0 };
+
+// - pools -
+static VkDescriptorPool bs_descriptorPool() {
+    VkDescriptorPoolSize sizes[] = {
+        { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, BS_DESCRIPTOR_POOL_SETS },
+        { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, BS_DESCRIPTOR_POOL_SETS * 2 },
+        { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, BS_DESCRIPTOR_POOL_SETS },
+        { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, BS_DESCRIPTOR_POOL_SETS * 2 },
+        { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, BS_DESCRIPTOR_POOL_SETS * 4 },
+        { VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, BS_DESCRIPTOR_POOL_SETS },
+        { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, BS_DESCRIPTOR_POOL_SETS },
+        { VK_DESCRIPTOR_TYPE_SAMPLER, BS_DESCRIPTOR_POOL_SETS },
+    };
+
+    VkDescriptorPoolCreateInfo pool_ci = { 0 };
+    pool_ci.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    pool_ci.maxSets = BS_DESCRIPTOR_POOL_SETS;
+    pool_ci.poolSizeCount = sizeof(sizes) / sizeof(VkDescriptorPoolSize);
+    pool_ci.pPoolSizes = sizes;
+
+    VkDescriptorPool pool = VK_NULL_HANDLE;
+    BS_VK_ERR(vkCreateDescriptorPool(bs_vkDevice(), &pool_ci, NULL, &pool), "Failed to create descriptor pool");
+
+    if(descriptors.pools.unit_size == 0) {
+        descriptors.pools = bs_buffer(sizeof(VkDescriptorPool), 4, 4, 0);
+    }
+
+    bs_bufferAppend(&descriptors.pools, &pool);
+    return pool;
+}
+
+void* bs_allocDescriptorSet(void* set_layout) {
+    VkDescriptorPool pool = descriptors.pools.num_units == 0 ? bs_descriptorPool() : *(VkDescriptorPool*)bs_bufferData(&descriptors.pools, descriptors.pools.num_units - 1);
+
+    VkDescriptorSetAllocateInfo alloc_i = { 0 };
+    alloc_i.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    alloc_i.descriptorPool = pool;
+    alloc_i.descriptorSetCount = 1;
+    alloc_i.pSetLayouts = (VkDescriptorSetLayout*)&set_layout;
+
+    VkDescriptorSet set = VK_NULL_HANDLE;
+    VkResult result = vkAllocateDescriptorSets(bs_vkDevice(), &alloc_i, &set);
+
+    // the pool is exhausted, older pools are never revisited since sets aren't freed individually
+    if(result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL) {
+        alloc_i.descriptorPool = bs_descriptorPool();
+        result = vkAllocateDescriptorSets(bs_vkDevice(), &alloc_i, &set);
+    }
+
+    BS_VK_ERR(result, "Failed to allocate descriptor set");
+    return set;
+}
+
+// - shader spaces -
+static bool bs_writeSpaceSet(bs_SpaceSetRequest* request) {
+    VkDescriptorBufferInfo infos[BS_MAX_SHADER_BINDINGS];
+    VkWriteDescriptorSet writes[BS_MAX_SHADER_BINDINGS];
+
+    for(bs_U32 i = 0; i < request->num_bindings; i++) {
+        if(request->bindings[i].binding >= BS_MAX_SPACES || !descriptors.spaces[request->bindings[i].binding].used) {
+            return false;
+        }
+    }
+
+    VkDescriptorSet set = bs_allocDescriptorSet(request->set_layout);
+
+    for(bs_U32 i = 0; i < request->num_bindings; i++) {
+        const bs_ShaderBinding* binding = request->bindings + i;
+        bs_SpaceSlot* space = descriptors.spaces + binding->binding;
+
+        infos[i].buffer = space->buffer;
+        infos[i].offset = 0;
+        infos[i].range = (VkDeviceSize)space->unit_size * space->num_units;
+
+        memset(writes + i, 0, sizeof(VkWriteDescriptorSet));
+        writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[i].dstSet = set;
+        writes[i].dstBinding = binding->binding;
+        writes[i].descriptorCount = 1;
+        writes[i].descriptorType = binding->type;
+        writes[i].pBufferInfo = infos + i;
+    }
+
+    vkUpdateDescriptorSets(bs_vkDevice(), request->num_bindings, writes, 0, NULL);
+    *request->out_set = set;
+    return true;
+}
+
+void bs_requestSpaceSet(void* set_layout, const bs_ShaderBinding* bindings, bs_U32 num_bindings, void** out_set) {
+    bs_SpaceSetRequest request = { 0 };
+    request.set_layout = set_layout;
+    request.num_bindings = num_bindings;
+    request.out_set = out_set;
+    memcpy(request.bindings, bindings, num_bindings * sizeof(bs_ShaderBinding));
+
+    *out_set = NULL;
+    if(bs_writeSpaceSet(&request)) {
+        return;
+    }
+
+    if(descriptors.requests.unit_size == 0) {
+        descriptors.requests = bs_buffer(sizeof(bs_SpaceSetRequest), 8, 8, 0);
+    }
+
+    bs_bufferAppend(&descriptors.requests, &request);
+}
+
+bs_Space bs_shaderSpace(bs_Buffer buf, bs_U32 bind_point, bs_SpaceType type) {
+    if(bind_point >= BS_MAX_SPACES) {
+        bs_throw("Shader space bind point is past BS_MAX_SPACES");
+    }
+
+    bs_SpaceSlot* space = descriptors.spaces + bind_point;
+    if(space->used) {
+        bs_throw("Shader space already exists");
+    }
+
+    bs_U32 num_units = buf.capacity > buf.num_units ? buf.capacity : buf.num_units;
+    if(buf.max_units > num_units) num_units = buf.max_units;
+    if(num_units == 0 || buf.unit_size == 0) {
+        bs_throw("Shader space is empty");
+    }
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(bs_vkPhysicalDevice(), &properties);
+
+    VkDeviceSize alignment = type == BS_STD140 ? properties.limits.minUniformBufferOffsetAlignment : properties.limits.minStorageBufferOffsetAlignment;
+    VkDeviceSize size = (VkDeviceSize)num_units * buf.unit_size;
+
+    space->used = true;
+    space->type = type;
+    space->unit_size = buf.unit_size;
+    space->num_units = num_units;
+    space->slot_size = (size + alignment - 1) / alignment * alignment;
+
+    bs_prepareBuffer(
+        space->slot_size * bs_framesInFlight(),
+        type == BS_STD140 ? VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT : VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        &space->buffer, &space->allocation
+    );
+
+    space->shadow = bs_alloc(size);
+    memset(space->shadow, 0, size);
+    if(buf.data != NULL) {
+        memcpy(space->shadow, buf.data, (size_t)buf.num_units * buf.unit_size);
+    }
+
+    // every slot starts out with the full contents
+    for(bs_U32 i = 0; i < bs_framesInFlight(); i++) {
+        memcpy((bs_U8*)space->allocation.mapped + space->slot_size * i, space->shadow, size);
+        space->dirty_begin[i] = space->dirty_end[i] = 0;
+    }
+
+    // sets that were only waiting on this space can be written now
+    for(bs_U32 i = 0; i < descriptors.requests.num_units;) {
+        bs_SpaceSetRequest* request = bs_bufferData(&descriptors.requests, i);
+
+        if(bs_writeSpaceSet(request)) {
+            *request = *(bs_SpaceSetRequest*)bs_bufferData(&descriptors.requests, descriptors.requests.num_units - 1);
+            descriptors.requests.num_units--;
+        } else {
+            i++;
+        }
+    }
+
+    bs_Space handle = { 0 };
+    handle.bind_point = bind_point;
+    handle.type = type;
+    handle.unit_size = buf.unit_size;
+    handle.num_units = num_units;
+    return handle;
+}
+
+void bs_updateShaderSpace(bs_Space* space, void* data, bs_U32 offset, bs_U32 num_units) {
+    bs_SpaceSlot* slot = descriptors.spaces + space->bind_point;
+    if(!slot->used || offset + num_units > slot->num_units) {
+        bs_throw("Shader space update is out of range");
+    }
+
+    bs_U32 begin = offset * slot->unit_size;
+    bs_U32 end = begin + num_units * slot->unit_size;
+    memcpy(slot->shadow + begin, data, end - begin);
+
+    for(bs_U32 i = 0; i < bs_framesInFlight(); i++) {
+        if(slot->dirty_begin[i] == slot->dirty_end[i]) {
+            slot->dirty_begin[i] = begin;
+            slot->dirty_end[i] = end;
+            continue;
+        }
+
+        if(begin < slot->dirty_begin[i]) slot->dirty_begin[i] = begin;
+        if(end > slot->dirty_end[i]) slot->dirty_end[i] = end;
+    }
+}
+
+void bs_flushShaderSpaces() {
+    bs_U32 frame = bs_frameData()->swapchain_frame;
+
+    for(bs_U32 i = 0; i < BS_MAX_SPACES; i++) {
+        bs_SpaceSlot* space = descriptors.spaces + i;
+        if(!space->used || space->dirty_begin[frame] == space->dirty_end[frame]) continue;
+
+        // the fence of this slot has been waited on, so the gpu is done reading it
+        bs_U8* dst = (bs_U8*)space->allocation.mapped + space->slot_size * frame;
+        memcpy(dst + space->dirty_begin[frame], space->shadow + space->dirty_begin[frame], space->dirty_end[frame] - space->dirty_begin[frame]);
+
+        space->dirty_begin[frame] = space->dirty_end[frame] = 0;
+    }
+}
+
+void* bs_shaderSpaceFrame(bs_Space* space, bs_U32 frame) {
+    bs_SpaceSlot* slot = descriptors.spaces + space->bind_point;
+    return (bs_U8*)slot->allocation.mapped + slot->slot_size * frame;
+}
+
+void bs_spaceOffsets(const bs_ShaderBinding* bindings, bs_U32 num_bindings, bs_U32* offsets) {
+    bs_U32 frame = bs_frameData()->swapchain_frame;
+
+    for(bs_U32 i = 0; i < num_bindings; i++) {
+        offsets[i] = (bs_U32)(descriptors.spaces[bindings[i].binding].slot_size * frame);
+    }
+}
+
+// - bindless images -
+static void bs_createBindless() {
+    VkPhysicalDeviceDescriptorIndexingFeatures* features = bs_vkIndexingFeatures();
+    if(!features->runtimeDescriptorArray || !features->descriptorBindingPartiallyBound || !features->descriptorBindingVariableDescriptorCount ||
+       !features->descriptorBindingSampledImageUpdateAfterBind || !features->descriptorBindingUpdateUnusedWhilePending ||
+       !features->shaderSampledImageArrayNonUniformIndexing) {
+        bs_throw("Bindless images need descriptor indexing, which the device doesn't support");
+    }
+
+    VkPhysicalDeviceDescriptorIndexingProperties indexing_properties = { 0 };
+    indexing_properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES;
+
+    VkPhysicalDeviceProperties2 properties = { 0 };
+    properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+    properties.pNext = &indexing_properties;
+    vkGetPhysicalDeviceProperties2(bs_vkPhysicalDevice(), &properties);
+
+    bindless.capacity = BS_MAX_BINDLESS_IMAGES;
+    if(indexing_properties.maxDescriptorSetUpdateAfterBindSampledImages < bindless.capacity) bindless.capacity = indexing_properties.maxDescriptorSetUpdateAfterBindSampledImages;
+    if(indexing_properties.maxPerStageDescriptorUpdateAfterBindSampledImages < bindless.capacity) bindless.capacity = indexing_properties.maxPerStageDescriptorUpdateAfterBindSampledImages;
+
+    VkSamplerCreateInfo sampler_ci = { 0 };
+    sampler_ci.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    sampler_ci.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    sampler_ci.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    sampler_ci.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    sampler_ci.maxLod = VK_LOD_CLAMP_NONE;
+
+    sampler_ci.magFilter = sampler_ci.minFilter = VK_FILTER_NEAREST;
+    sampler_ci.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    BS_VK_ERR(vkCreateSampler(bs_vkDevice(), &sampler_ci, NULL, bindless.samplers + BS_SAMPLER_NEAREST), "Failed to create sampler");
+
+    sampler_ci.magFilter = sampler_ci.minFilter = VK_FILTER_LINEAR;
+    sampler_ci.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    BS_VK_ERR(vkCreateSampler(bs_vkDevice(), &sampler_ci, NULL, bindless.samplers + BS_SAMPLER_LINEAR), "Failed to create sampler");
+
+    VkDescriptorSetLayoutBinding bindings[2] = { 0 };
+    bindings[0].binding = BS_BINDLESS_SAMPLERS;
+    bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
+    bindings[0].descriptorCount = BS_NUM_BINDLESS_SAMPLERS;
+    bindings[0].stageFlags = VK_SHADER_STAGE_ALL_GRAPHICS;
+    bindings[0].pImmutableSamplers = bindless.samplers;
+
+    bindings[1].binding = BS_BINDLESS_IMAGES;
+    bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+    bindings[1].descriptorCount = bindless.capacity;
+    bindings[1].stageFlags = VK_SHADER_STAGE_ALL_GRAPHICS;
+
+    // slots that were never written are fine as long as they aren't sampled, and slots
+    // no pending frame samples can be written while other slots are being read
+    VkDescriptorBindingFlags binding_flags[2] = {
+        0,
+        VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+        VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT | VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT
+    };
+
+    VkDescriptorSetLayoutBindingFlagsCreateInfo flags_ci = { 0 };
+    flags_ci.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+    flags_ci.bindingCount = 2;
+    flags_ci.pBindingFlags = binding_flags;
+
+    VkDescriptorSetLayoutCreateInfo set_layout_ci = { 0 };
+    set_layout_ci.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    set_layout_ci.pNext = &flags_ci;
+    set_layout_ci.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+    set_layout_ci.bindingCount = 2;
+    set_layout_ci.pBindings = bindings;
+    BS_VK_ERR(vkCreateDescriptorSetLayout(bs_vkDevice(), &set_layout_ci, NULL, &bindless.set_layout), "Failed to create bindless set layout");
+
+    VkDescriptorPoolSize sizes[] = {
+        { VK_DESCRIPTOR_TYPE_SAMPLER, BS_NUM_BINDLESS_SAMPLERS },
+        { VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, bindless.capacity },
+    };
+
+    VkDescriptorPoolCreateInfo pool_ci = { 0 };
+    pool_ci.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    pool_ci.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+    pool_ci.maxSets = 1;
+    pool_ci.poolSizeCount = sizeof(sizes) / sizeof(VkDescriptorPoolSize);
+    pool_ci.pPoolSizes = sizes;
+    BS_VK_ERR(vkCreateDescriptorPool(bs_vkDevice(), &pool_ci, NULL, &bindless.pool), "Failed to create bindless descriptor pool");
+
+    VkDescriptorSetVariableDescriptorCountAllocateInfo count_i = { 0 };
+    count_i.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_VARIABLE_DESCRIPTOR_COUNT_ALLOCATE_INFO;
+    count_i.descriptorSetCount = 1;
+    count_i.pDescriptorCounts = &bindless.capacity;
+
+    VkDescriptorSetAllocateInfo alloc_i = { 0 };
+    alloc_i.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    alloc_i.pNext = &count_i;
+    alloc_i.descriptorPool = bindless.pool;
+    alloc_i.descriptorSetCount = 1;
+    alloc_i.pSetLayouts = &bindless.set_layout;
+    BS_VK_ERR(vkAllocateDescriptorSets(bs_vkDevice(), &alloc_i, &bindless.set), "Failed to allocate bindless descriptor set");
+
+    bindless.free_slots = bs_alloc(bindless.capacity * sizeof(bs_U32));
+    bindless.occupied = bs_alloc((bindless.capacity + 31) / 32 * sizeof(bs_U32));
+    memset(bindless.occupied, 0, (bindless.capacity + 31) / 32 * sizeof(bs_U32));
+    for(bs_U32 i = 0; i < BS_MAX_FRAMES_IN_FLIGHT; i++) {
+        bindless.retired[i] = bs_buffer(sizeof(bs_U32), 64, 0, 0);
+    }
+}
+
+void* bs_bindlessLayout() {
+    if(bindless.set_layout == VK_NULL_HANDLE) {
+        bs_createBindless();
+    }
+
+    return bindless.set_layout;
+}
+
+void* bs_bindlessSet() {
+    return bindless.set;
+}
+
+static bool bs_bindlessOccupied(bs_U32 slot) {
+    return slot < bindless.next_slot && (bindless.occupied[slot / 32] & (1u << (slot % 32))) != 0;
+}
+
+void bs_updateBindlessImage(bs_U32 slot, void* image_view) {
+    if(!bs_bindlessOccupied(slot)) {
+        bs_throw("Bindless image slot is not allocated");
+    }
+
+    VkDescriptorImageInfo image_i = { 0 };
+    image_i.imageView = image_view;
+    image_i.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    VkWriteDescriptorSet write = { 0 };
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = bindless.set;
+    write.dstBinding = BS_BINDLESS_IMAGES;
+    write.dstArrayElement = slot;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+    write.pImageInfo = &image_i;
+
+    vkUpdateDescriptorSets(bs_vkDevice(), 1, &write, 0, NULL);
+}
+
+bs_U32 bs_bindlessImage(void* image_view) {
+    bs_bindlessLayout();
+
+    bs_U32 slot = 0;
+    if(bindless.num_free > 0) {
+        slot = bindless.free_slots[--bindless.num_free];
+    } else if(bindless.next_slot < bindless.capacity) {
+        slot = bindless.next_slot++;
+    } else {
+        bs_throw("Bindless image table is full");
+    }
+
+    bindless.occupied[slot / 32] |= 1u << (slot % 32);
+    bs_updateBindlessImage(slot, image_view);
+    return slot;
+}
+
+void bs_freeBindlessImage(bs_U32 slot) {
+    // a second free would hand the slot out twice once both copies are recycled
+    if(!bs_bindlessOccupied(slot)) {
+        bs_throw("Bindless image slot is not allocated or was already freed");
+    }
+
+    bindless.occupied[slot / 32] &= ~(1u << (slot % 32));
+    bs_bufferAppend(bindless.retired + bs_frameData()->swapchain_frame, &slot);
+}
+
+void bs_recycleBindlessImages() {
+    if(bindless.set == VK_NULL_HANDLE) {
+        return;
+    }
+
+    bs_Buffer* retired = bindless.retired + bs_frameData()->swapchain_frame;
+    memcpy(bindless.free_slots + bindless.num_free, retired->data, retired->num_units * sizeof(bs_U32));
+    bindless.num_free += retired->num_units;
+    retired->num_units = 0;
+}
+
+bs_U32 bs_bindlessCapacity() {
+    bs_bindlessLayout();
+    return bindless.capacity;
+}
+
+void bs_freeDescriptors() {
+    if(bindless.set_layout != VK_NULL_HANDLE) {
+        vkDestroyDescriptorPool(bs_vkDevice(), bindless.pool, NULL);
+        vkDestroyDescriptorSetLayout(bs_vkDevice(), bindless.set_layout, NULL);
+        for(bs_U32 i = 0; i < BS_NUM_BINDLESS_SAMPLERS; i++) {
+            vkDestroySampler(bs_vkDevice(), bindless.samplers[i], NULL);
+        }
+
+        for(bs_U32 i = 0; i < BS_MAX_FRAMES_IN_FLIGHT; i++) {
+            bs_free(bindless.retired[i].data);
+        }
+
+        bs_free(bindless.free_slots);
+        bs_free(bindless.occupied);
+        memset(&bindless, 0, sizeof(bindless));
+    }
+
+    for(bs_U32 i = 0; i < descriptors.pools.num_units; i++) {
+        vkDestroyDescriptorPool(bs_vkDevice(), *(VkDescriptorPool*)bs_bufferData(&descriptors.pools, i), NULL);
+    }
+
+    for(bs_U32 i = 0; i < BS_MAX_SPACES; i++) {
+        bs_SpaceSlot* space = descriptors.spaces + i;
+        if(!space->used) continue;
+
+        vkDestroyBuffer(bs_vkDevice(), space->buffer, NULL);
+        bs_vramFree(&space->allocation);
+        bs_free(space->shadow);
+    }
+
+    bs_free(descriptors.pools.data);
+    bs_free(descriptors.requests.data);
+    memset(&descriptors, 0, sizeof(descriptors));
+}
@@ -1,18 +1,37 @@
+#ifdef _WIN32
 #include <windows.h>
+#else
+#include <time.h>
+#endif
+
 #include <stdio.h>
 #include <stdbool.h>
+#include <string.h>
 #include <assert.h>
+#include <math.h>
 
 #include <vulkan.h>
 
 #include <glfw/glfw3.h>
+#ifdef _WIN32
 #include <glfw/glfw3native.h>
+#endif
 
 #include <bs_types.h>
 #include <bs_math.h>
 #include <bs_ini.h>
 #include <bs_mem.h>
 #include <bs_shaders.h>
+#include <bs_descriptors.h>
+#include <bs_textures.h>
+#include <bs_staging.h>
+#include <bs_vram.h>
+#include <bs_jobs.h>
+#include <bs_profiler.h>
+#include <bs_vtex.h>
+#include <bs_pack.h>
+#include <bs_io.h>
+#include <bs_core.h>
 
 bs_HandleOffsets handle_offsets = { 0 };
 
@@ -25,11 +44,57 @@ struct {
 bs_WindowFrame frame = { 0 };
 bs_WindowFrame last_frame = { 0 };
 
+bs_Config config = { 0 };
+double start_time = 0.0;
+
+// headless mode renders into these instead of swapchain images, one per frame in flight
+struct {
+    VkImage images[BS_MAX_FRAMES_IN_FLIGHT];
+    bs_VramAllocation image_allocations[BS_MAX_FRAMES_IN_FLIGHT];
+
+    VkBuffer readback[BS_MAX_FRAMES_IN_FLIGHT];
+    bs_VramAllocation readback_allocations[BS_MAX_FRAMES_IN_FLIGHT];
+
+    // set once a frame was submitted into the slot and not handed to config.readback yet
+    bool pending[BS_MAX_FRAMES_IN_FLIGHT];
+    bs_U64 frame_nums[BS_MAX_FRAMES_IN_FLIGHT];
+
+    bool quit;
+} offscreen = { 0 };
+
+// rolling window of frame timings, see bs_frameStats()
+struct {
+    double frame_time[BS_FRAME_STATS_WINDOW];
+    double fence_wait[BS_FRAME_STATS_WINDOW];
+    double acquire_wait[BS_FRAME_STATS_WINDOW];
+
+    bs_U32 head;
+    bs_U32 num;
+} pacing = { 0 };
+
 
 bs_WindowFrame* bs_frameData() {
     return &frame;
 }
 
+// seconds from an arbitrary point, glfw can't be used as it isn't initialized in headless mode
+double bs_time() {
+#ifdef _WIN32
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart / frequency.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+#endif
+}
+
+bool bs_headless() {
+    return config.headless;
+}
+
 void bs_throw(const char* message) {
 	printf("%s\n", message);
 	exit(1);
@@ -44,11 +109,13 @@ VkInstance instance = VK_NULL_HANDLE;
 VkSurfaceKHR surface = VK_NULL_HANDLE;
 
 VkPhysicalDeviceFeatures device_features = {0};
+VkPhysicalDeviceDescriptorIndexingFeatures indexing_features = {0};
 VkPhysicalDevice physical_device = VK_NULL_HANDLE;
 VkDevice device = VK_NULL_HANDLE;
 
 VkQueue present_queue = VK_NULL_HANDLE;
 VkQueue graphics_queue = VK_NULL_HANDLE;
+VkQueue transfer_queue = VK_NULL_HANDLE;
 
 VkFence* render_fences = NULL;
 VkSwapchainKHR swapchain = VK_NULL_HANDLE;
@@ -65,8 +132,6 @@ bs_U32 num_swapchain_imgs = 0;
 VkFormat swapchain_img_format;
 VkCommandPool command_pool;
 
-#define BS_MAX_FRAMES_IN_FLIGHT 2
-
 bs_Buffer vk_handles = { 0 };
 bs_U32 current_swapchain_img = 0;
 
@@ -78,6 +143,10 @@ typedef struct {
 
     uint32_t present_family;
     bool present_family_is_valid;
+
+    // a family that only copies, uploads run on it next to rendering
+    uint32_t transfer_family;
+    bool transfer_family_is_valid;
 } QueueFamilyIndices;
 QueueFamilyIndices queue_family_indices;
 
@@ -123,6 +192,41 @@ void* bs_vkGraphicsQueue() {
     return (void*)graphics_queue;
 }
 
+bs_U32 bs_vkGraphicsFamily() {
+    return queue_family_indices.graphics_family;
+}
+
+void* bs_vkTransferQueue() {
+    return (void*)transfer_queue;
+}
+
+bs_U32 bs_vkTransferFamily() {
+    return queue_family_indices.transfer_family;
+}
+
+// set while a job records into a secondary command buffer, see bs_recordJobs()
+static BS_THREAD_LOCAL void* thread_command_buffer = NULL;
+
+void* bs_vkCmdBuffer() {
+    if(thread_command_buffer != NULL) {
+        return thread_command_buffer;
+    }
+
+    return bs_vkHandle(handle_offsets.command_buffers + frame.swapchain_frame);
+}
+
+void bs_setVkCmdBuffer(void* command_buffer) {
+    thread_command_buffer = command_buffer;
+}
+
+void* bs_vkFeatures() {
+    return (void*)&device_features;
+}
+
+void* bs_vkIndexingFeatures() {
+    return (void*)&indexing_features;
+}
+
 void* bs_swapchainImgViews() {
     return (void*)swapchain_img_views;
 }
@@ -164,15 +268,47 @@ void bs_cleanupSwapChain() {
         vkDestroyImageView(device, swapchain_img_views[i], NULL);
     }
 
-    vkDestroySwapchainKHR(device, swapchain, NULL);
+    if(swapchain != VK_NULL_HANDLE) {
+        vkDestroySwapchainKHR(device, swapchain, NULL);
+    }
+}
+
+void bs_freeOffscreen() {
+    for(int i = 0; i < config.frames_in_flight; i++) {
+        if(offscreen.images[i] != VK_NULL_HANDLE) {
+            vkDestroyImage(device, offscreen.images[i], NULL);
+            bs_vramFree(offscreen.image_allocations + i);
+        }
+
+        if(offscreen.readback[i] != VK_NULL_HANDLE) {
+            vkDestroyBuffer(device, offscreen.readback[i], NULL);
+            bs_vramFree(offscreen.readback_allocations + i);
+        }
+    }
+
+    memset(&offscreen, 0, sizeof(offscreen));
 }
 
 void bs_cleanup() {
+    // waits on its page reads, so it goes before the job threads
+    bs_freeVirtualTextures();
+    bs_freeIo();
+    bs_freeJobs();
+    bs_freeRecorders();
+    bs_freeProfiler();
+    bs_freePipelines();
+    bs_freeTextures();
+    bs_freeDescriptors();
+    bs_freePipelineCache();
+    bs_freeStaging();
     bs_cleanupSwapChain();
+    bs_freeOffscreen();
+    bs_freeArena(bs_frameArena());
+    bs_unmountPacks();
 
     vkDestroyPipelineLayout(device, pipeline_layout, NULL);
 
-    for (size_t i = 0; i < BS_MAX_FRAMES_IN_FLIGHT; i++) {
+    for (size_t i = 0; i < config.frames_in_flight; i++) {
         vkDestroySemaphore(device, render_semaphores[i], NULL);
         vkDestroySemaphore(device, swapchain_semaphores[i], NULL);
         vkDestroyFence(device, render_fences[i], NULL);
@@ -180,13 +316,18 @@ void bs_cleanup() {
 
     // vkDestroyCommandPool(device, cmd_pool, NULL);
 
+    bs_freeVram();
+
     vkDestroyDevice(device, NULL);
 
     if (enable_validation_layers) {
         // DestroyDebugUtilsMessengerEXT(instance, debug_messenger, NULL);
     }
 
-    vkDestroySurfaceKHR(instance, surface, NULL);
+    if(surface != VK_NULL_HANDLE) {
+        vkDestroySurfaceKHR(instance, surface, NULL);
+    }
+
     vkDestroyInstance(instance, NULL);
 
     //glfwDestroyWindow(window);
@@ -197,6 +338,7 @@ QueueFamilyIndices bs_findQueueFamilies() {
     QueueFamilyIndices indices;
     indices.graphics_family_is_valid = false;
     indices.present_family_is_valid = false;
+    indices.transfer_family_is_valid = false;
     indices.family_count = 2;
 
     uint32_t num_families;
@@ -211,6 +353,15 @@ QueueFamilyIndices bs_findQueueFamilies() {
             indices.present_family_is_valid = true;
         }
 
+        VkQueueFlags copy_only = queue_families[i].queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT | VK_QUEUE_TRANSFER_BIT);
+        if(copy_only == VK_QUEUE_TRANSFER_BIT && !indices.transfer_family_is_valid) {
+            indices.transfer_family = i;
+            indices.transfer_family_is_valid = true;
+        }
+
+        // there is nothing to present to
+        if(config.headless) continue;
+
         VkBool32 present_support = false;
         vkGetPhysicalDeviceSurfaceSupportKHR(physical_device, i, surface, &present_support);
         if(present_support) {
@@ -221,6 +372,17 @@ QueueFamilyIndices bs_findQueueFamilies() {
 
     //free(queue_families);
 
+    if(config.headless) {
+        indices.present_family = indices.graphics_family;
+    }
+
+    // without one, uploads stay on the graphics queue
+    if(indices.transfer_family_is_valid) {
+        indices.family_count = 3;
+    } else {
+        indices.transfer_family = indices.graphics_family;
+    }
+
     return indices;
 }
 
@@ -260,12 +422,16 @@ bool bs_checkValidationLayerSupport() {
 // initialization
 void bs_prepareInstance() {
     if(enable_validation_layers && !bs_checkValidationLayerSupport()) {
+        // common on ci and render nodes, run without them rather than without an instance
         printf("The validation layers requested are not available!\n");
-        return;
+        enable_validation_layers = false;
     }
 
 	int num_extensions = 0;
-	const char** extensions = glfwGetRequiredInstanceExtensions(&num_extensions);
+	const char** extensions = NULL;
+    if(!config.headless) {
+        extensions = glfwGetRequiredInstanceExtensions(&num_extensions);
+    }
 
     VkApplicationInfo app_i = {0};
     app_i.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
@@ -317,11 +483,27 @@ void bs_selectPhysicalDevice() {
     }
 }
 
+static bool bs_deviceExtensionSupported(const char* name) {
+    uint32_t num_extensions;
+    vkEnumerateDeviceExtensionProperties(physical_device, NULL, &num_extensions, NULL);
+
+    VkExtensionProperties* extensions = malloc(num_extensions * sizeof(VkExtensionProperties));
+    vkEnumerateDeviceExtensionProperties(physical_device, NULL, &num_extensions, extensions);
+
+    bool found = false;
+    for(uint32_t i = 0; i < num_extensions && !found; i++) {
+        found = strcmp(name, extensions[i].extensionName) == 0;
+    }
+
+    free(extensions);
+    return found;
+}
+
 void bs_prepareLogicalDevice() {
     queue_family_indices = bs_findQueueFamilies(physical_device);
 
     VkDeviceQueueCreateInfo* queue_cis = malloc(queue_family_indices.family_count * sizeof(VkDeviceQueueCreateInfo));
-    uint32_t uq_families[] = { queue_family_indices.graphics_family, queue_family_indices.present_family };
+    uint32_t uq_families[4] = { queue_family_indices.graphics_family, queue_family_indices.present_family, queue_family_indices.transfer_family };
     uint32_t num_uq_families = queue_family_indices.family_count;
 
     // remove dupes
@@ -349,16 +531,60 @@ void bs_prepareLogicalDevice() {
         queue_cis[i] = queue_ci;
     }
 
-	const char* extensions[] = {
-        "VK_KHR_swapchain"
-    };
+	const char* extensions[3];
+    bs_U32 num_extensions = 0;
+
+    if(!config.headless) {
+        extensions[num_extensions++] = "VK_KHR_swapchain";
+    }
+
+    // optional, bs_renderBatchIndirect() falls back to direct draws without them
+    VkPhysicalDeviceFeatures supported_features;
+    vkGetPhysicalDeviceFeatures(physical_device, &supported_features);
+    device_features.multiDrawIndirect = supported_features.multiDrawIndirect;
+    device_features.drawIndirectFirstInstance = supported_features.drawIndirectFirstInstance;
+
+    // optional, bindless images need descriptor indexing which is core since 1.2
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physical_device, &properties);
+
+    bool core_indexing = properties.apiVersion >= VK_API_VERSION_1_2;
+    bool extension_indexing = !core_indexing && bs_deviceExtensionSupported("VK_EXT_descriptor_indexing") && bs_deviceExtensionSupported("VK_KHR_maintenance3");
+
+    VkPhysicalDeviceDescriptorIndexingFeatures supported_indexing = { 0 };
+    supported_indexing.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+
+    // the struct is only known to devices that have descriptor indexing, left all false otherwise
+    if(core_indexing || extension_indexing) {
+        VkPhysicalDeviceFeatures2 features2 = { 0 };
+        features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        features2.pNext = &supported_indexing;
+        vkGetPhysicalDeviceFeatures2(physical_device, &features2);
+    }
+
+    indexing_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+    indexing_features.runtimeDescriptorArray = supported_indexing.runtimeDescriptorArray;
+    indexing_features.descriptorBindingPartiallyBound = supported_indexing.descriptorBindingPartiallyBound;
+    indexing_features.descriptorBindingVariableDescriptorCount = supported_indexing.descriptorBindingVariableDescriptorCount;
+    indexing_features.descriptorBindingSampledImageUpdateAfterBind = supported_indexing.descriptorBindingSampledImageUpdateAfterBind;
+    indexing_features.descriptorBindingUpdateUnusedWhilePending = supported_indexing.descriptorBindingUpdateUnusedWhilePending;
+    indexing_features.shaderSampledImageArrayNonUniformIndexing = supported_indexing.shaderSampledImageArrayNonUniformIndexing;
+
+    if(extension_indexing && supported_indexing.runtimeDescriptorArray) {
+        extensions[num_extensions++] = "VK_KHR_maintenance3";
+        extensions[num_extensions++] = "VK_EXT_descriptor_indexing";
+    }
 
     VkDeviceCreateInfo ci = {0};
     ci.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    // chaining the features is only valid when descriptor indexing is core or its extension is enabled
+    if(core_indexing || (extension_indexing && supported_indexing.runtimeDescriptorArray)) {
+        ci.pNext = &indexing_features;
+    }
     ci.pQueueCreateInfos = queue_cis;
     ci.queueCreateInfoCount = num_uq_families;
     ci.pEnabledFeatures = &device_features;
-    ci.enabledExtensionCount = sizeof(extensions) / sizeof(const char *);
+    ci.enabledExtensionCount = num_extensions;
     ci.ppEnabledExtensionNames = extensions;
     if(enable_validation_layers) {
         ci.enabledLayerCount = sizeof(validation_layers) / sizeof(const char *);
@@ -373,6 +599,32 @@ void bs_prepareLogicalDevice() {
 
     vkGetDeviceQueue(device, queue_family_indices.present_family, 0, &present_queue);
     vkGetDeviceQueue(device, queue_family_indices.graphics_family, 0, &graphics_queue);
+    vkGetDeviceQueue(device, queue_family_indices.transfer_family, 0, &transfer_queue);
+}
+
+static bool bs_presentModeSupported(VkPresentModeKHR* modes, bs_U32 num_modes, bs_PresentMode mode) {
+    for(int i = 0; i < num_modes; i++) {
+        if(modes[i] == (VkPresentModeKHR)mode) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static bs_U32 bs_swapchainImageCount(VkSurfaceCapabilitiesKHR* capabilities) {
+    bs_U32 count = config.swapchain_images == 0 ? capabilities->minImageCount + 1 : config.swapchain_images;
+
+    if(count < capabilities->minImageCount) {
+        count = capabilities->minImageCount;
+    }
+
+    // a max of 0 means there is no limit
+    if(capabilities->maxImageCount != 0 && count > capabilities->maxImageCount) {
+        count = capabilities->maxImageCount;
+    }
+
+    return count;
 }
 
 void bs_prepareSwapchain() {
@@ -412,7 +664,7 @@ void bs_prepareSwapchain() {
     swapchain_ci.surface = surface;
 	swapchain_ci.imageArrayLayers = 1;
 	swapchain_ci.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
-    swapchain_ci.minImageCount = bs_clamp(2, capabilities.minImageCount, capabilities.maxImageCount);
+    swapchain_ci.minImageCount = bs_swapchainImageCount(&capabilities);
 	swapchain_ci.imageExtent.width = swapchain_extent.x;
 	swapchain_ci.imageExtent.height = swapchain_extent.y;
 	swapchain_ci.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
@@ -435,11 +687,13 @@ void bs_prepareSwapchain() {
 		}
 	}
 
-	for(int i = 0; i < num_modes; i++) {
-		if(modes[i] == VK_PRESENT_MODE_FIFO_KHR) {
-			// VK_PRESENT_MODE_FIFO_KHR = double buffering
-			// VK_PRESENT_MODE_MAILBOX_KHR = triple buffering
-			swapchain_ci.presentMode = VK_PRESENT_MODE_FIFO_KHR;
+	// VK_PRESENT_MODE_FIFO_KHR = vsync, the only mode every driver has to support
+	// VK_PRESENT_MODE_MAILBOX_KHR = vsync, newer frames replace queued ones
+	// VK_PRESENT_MODE_IMMEDIATE_KHR = no vsync, may tear
+	swapchain_ci.presentMode = VK_PRESENT_MODE_FIFO_KHR;
+	for(int i = 0; i < config.num_present_modes; i++) {
+		if(bs_presentModeSupported(modes, num_modes, config.present_modes[i])) {
+			swapchain_ci.presentMode = (VkPresentModeKHR)config.present_modes[i];
 			break;
 		}
 	}
@@ -485,16 +739,16 @@ void bs_prepareCommands() {
 
     BS_VK_ERR(vkCreateCommandPool(device, &pool_ci, NULL, &command_pool), "Failed to create a command pool");
 
-    bs_bufferResizeCheck(&vk_handles, BS_MAX_FRAMES_IN_FLIGHT);
+    bs_bufferResizeCheck(&vk_handles, config.frames_in_flight);
     handle_offsets.command_buffers = bs_handleOffset();
 
     VkCommandBufferAllocateInfo buffer_ci = { 0 };
     buffer_ci.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
     buffer_ci.commandPool = command_pool;
-    buffer_ci.commandBufferCount = BS_MAX_FRAMES_IN_FLIGHT;
+    buffer_ci.commandBufferCount = config.frames_in_flight;
     buffer_ci.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
     BS_VK_ERR(vkAllocateCommandBuffers(device, &buffer_ci, bs_vkHandleA(handle_offsets.command_buffers)), "Failed to allocate command buffers");
-    vk_handles.num_units += BS_MAX_FRAMES_IN_FLIGHT;
+    vk_handles.num_units += config.frames_in_flight;
 }
 
 void bs_prepareSynchronization() {
@@ -505,11 +759,11 @@ void bs_prepareSynchronization() {
     VkSemaphoreCreateInfo semaphore_ci = { 0 };
     semaphore_ci.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
-    swapchain_semaphores = malloc(BS_MAX_FRAMES_IN_FLIGHT * sizeof(VkSemaphore));
-    render_semaphores = malloc(BS_MAX_FRAMES_IN_FLIGHT * sizeof(VkSemaphore));
-    render_fences = malloc(BS_MAX_FRAMES_IN_FLIGHT * sizeof(VkFence));
+    swapchain_semaphores = malloc(config.frames_in_flight * sizeof(VkSemaphore));
+    render_semaphores = malloc(config.frames_in_flight * sizeof(VkSemaphore));
+    render_fences = malloc(config.frames_in_flight * sizeof(VkFence));
 
-    for(int i = 0; i < BS_MAX_FRAMES_IN_FLIGHT; i++) {
+    for(int i = 0; i < config.frames_in_flight; i++) {
         BS_VK_ERR(vkCreateFence(device, &fence_ci, NULL, render_fences + i), "Failed to create fence");
         BS_VK_ERR(vkCreateSemaphore(device, &semaphore_ci, NULL, swapchain_semaphores + i), "Failed to create semaphore");
         BS_VK_ERR(vkCreateSemaphore(device, &semaphore_ci, NULL, render_semaphores + i), "Failed to create semaphore");
@@ -532,10 +786,172 @@ void bs_recreateSwapchain() {
     bs_prepareImageViews();
 }
 
+static void bs_recordPacing(double fence_wait, double acquire_wait) {
+    // the first frame has no previous one to measure against
+    if(frame.frame_num == 0) {
+        return;
+    }
+
+    pacing.frame_time[pacing.head] = frame.delta_time * 1000.0;
+    pacing.fence_wait[pacing.head] = fence_wait * 1000.0;
+    pacing.acquire_wait[pacing.head] = acquire_wait * 1000.0;
+
+    pacing.head = (pacing.head + 1) % BS_FRAME_STATS_WINDOW;
+    if(pacing.num < BS_FRAME_STATS_WINDOW) {
+        pacing.num++;
+    }
+}
+
+bs_FrameStats bs_frameStats() {
+    bs_FrameStats stats = { 0 };
+    stats.num_frames = pacing.num;
+    if(pacing.num == 0) {
+        return stats;
+    }
+
+    stats.min_frame = pacing.frame_time[0];
+    for(int i = 0; i < pacing.num; i++) {
+        stats.avg_frame += pacing.frame_time[i];
+        stats.avg_fence_wait += pacing.fence_wait[i];
+        stats.avg_acquire_wait += pacing.acquire_wait[i];
+
+        if(pacing.frame_time[i] < stats.min_frame) stats.min_frame = pacing.frame_time[i];
+        if(pacing.frame_time[i] > stats.max_frame) stats.max_frame = pacing.frame_time[i];
+    }
+
+    stats.avg_frame /= pacing.num;
+    stats.avg_fence_wait /= pacing.num;
+    stats.avg_acquire_wait /= pacing.num;
+
+    double variance = 0.0;
+    for(int i = 0; i < pacing.num; i++) {
+        double diff = pacing.frame_time[i] - stats.avg_frame;
+        variance += diff * diff;
+    }
+
+    stats.jitter = sqrt(variance / pacing.num);
+    return stats;
+}
+
+void bs_prepareBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer* buffer, bs_VramAllocation* allocation);
+
+// stands in for the swapchain in headless mode, bs_prepareImageViews() and renderers use these like swapchain images
+void bs_prepareOffscreen() {
+    num_swapchain_imgs = config.frames_in_flight;
+    swapchain_imgs = malloc(num_swapchain_imgs * sizeof(VkImage));
+    swapchain_img_views = malloc(num_swapchain_imgs * sizeof(VkImageView));
+    swapchain_img_format = VK_FORMAT_B8G8R8A8_SRGB;
+    swapchain_extent = bs_iv2(frame.resolution.x, frame.resolution.y);
+
+    for(int i = 0; i < num_swapchain_imgs; i++) {
+        VkImageCreateInfo image_ci = { 0 };
+        image_ci.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        image_ci.imageType = VK_IMAGE_TYPE_2D;
+        image_ci.format = swapchain_img_format;
+        image_ci.extent.width = swapchain_extent.x;
+        image_ci.extent.height = swapchain_extent.y;
+        image_ci.extent.depth = 1;
+        image_ci.mipLevels = 1;
+        image_ci.arrayLayers = 1;
+        image_ci.samples = VK_SAMPLE_COUNT_1_BIT;
+        image_ci.tiling = VK_IMAGE_TILING_OPTIMAL;
+        image_ci.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+        image_ci.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        image_ci.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+        BS_VK_ERR(vkCreateImage(device, &image_ci, NULL, offscreen.images + i), "Failed to create offscreen image");
+
+        VkMemoryRequirements mem_req;
+        vkGetImageMemoryRequirements(device, offscreen.images[i], &mem_req);
+
+        offscreen.image_allocations[i] = bs_vramAlloc(mem_req.size, mem_req.alignment, mem_req.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true);
+        vkBindImageMemory(device, offscreen.images[i], offscreen.image_allocations[i].memory, offscreen.image_allocations[i].offset);
+
+        swapchain_imgs[i] = offscreen.images[i];
+
+        if(config.readback != NULL) {
+            bs_prepareBuffer(
+                swapchain_extent.x * swapchain_extent.y * 4,
+                VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                offscreen.readback + i, offscreen.readback_allocations + i
+            );
+        }
+    }
+}
+
+// the render pass leaves the image in VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL in headless mode,
+// its external dependency makes the color writes visible to the copy
+static void bs_copyOffscreen(VkCommandBuffer command_buffer, bs_U32 slot) {
+    VkBufferImageCopy region = { 0 };
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.layerCount = 1;
+    region.imageExtent.width = swapchain_extent.x;
+    region.imageExtent.height = swapchain_extent.y;
+    region.imageExtent.depth = 1;
+    vkCmdCopyImageToBuffer(command_buffer, offscreen.images[slot], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, offscreen.readback[slot], 1, &region);
+
+    VkMemoryBarrier barrier = { 0 };
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &barrier, 0, NULL, 0, NULL);
+}
+
+// expects the fence of the slot to be signaled
+static void bs_readbackOffscreen(bs_U32 slot) {
+    if(!offscreen.pending[slot]) return;
+    offscreen.pending[slot] = false;
+
+    if(config.readback != NULL) {
+        config.readback(offscreen.readback_allocations[slot].mapped, swapchain_extent.x, swapchain_extent.y, offscreen.frame_nums[slot]);
+    }
+}
+
+static void bs_present(VkSemaphore* wait_semaphores) {
+    VkSubpassDependency dependency = { 0 };
+    dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+    dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
+    VkRenderPassCreateInfo render_pass_info;
+    render_pass_info.dependencyCount = 1;
+    render_pass_info.pDependencies = &dependency;
+
+    VkSwapchainKHR swapchains[] = { swapchain };
+    VkPresentInfoKHR present_i = { 0 };
+    present_i.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+    present_i.waitSemaphoreCount = 1;
+    present_i.pWaitSemaphores = wait_semaphores;
+    present_i.swapchainCount = 1;
+    present_i.pSwapchains = swapchains;
+    present_i.pImageIndices = &current_swapchain_img;
+
+    VkResult result = vkQueuePresentKHR(present_queue, &present_i);
+    if(result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || window.resized) {
+        window.resized = false;
+        bs_recreateSwapchain();
+    } else if(result != VK_SUCCESS) {
+        bs_throw("Failed to acquire swapchain image");
+    }
+}
+
 void bs_render(void (*tick)()) {
+    double wait_start = bs_time();
     vkWaitForFences(device, 1, render_fences + frame.swapchain_frame, VK_TRUE, UINT64_MAX);
+    double fence_end = bs_time();
+
+    VkResult result = VK_SUCCESS;
+    if(config.headless) {
+        // the frame last rendered into this slot is done, hand it over before the image is reused
+        bs_readbackOffscreen(frame.swapchain_frame);
+        current_swapchain_img = frame.swapchain_frame;
+    } else {
+        result = vkAcquireNextImageKHR(device, swapchain, UINT64_MAX, swapchain_semaphores[frame.swapchain_frame], VK_NULL_HANDLE, &current_swapchain_img);
+    }
 
-    VkResult result = vkAcquireNextImageKHR(device, swapchain, UINT64_MAX, swapchain_semaphores[frame.swapchain_frame], VK_NULL_HANDLE, &current_swapchain_img);
+    bs_recordPacing(fence_end - wait_start, bs_time() - fence_end);
 
     if(result == VK_ERROR_OUT_OF_DATE_KHR) {
         bs_recreateSwapchain();
@@ -551,9 +967,26 @@ void bs_render(void (*tick)()) {
     VkCommandBufferBeginInfo ci = { 0 };
     ci.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
     BS_VK_ERR(vkBeginCommandBuffer(command_buffer, &ci), "Failed to begin recording");
+    bs_profileFrameBegin(command_buffer);
+
+    // the fence above covers every use of the slots this frame retired last time around
+    bs_recycleBindlessImages();
+    bs_recycleSharedGeometry();
+    bs_recycleTextures();
+    bs_arenaReset(bs_frameArena());
+    bs_pollIo();
+    bs_streamImages();
+    bs_updateVirtualTextures();
 
     tick();
 
+    bs_recordFeedbackBarrier(command_buffer);
+    bs_profileFrameEnd();
+
+    if(config.headless && config.readback != NULL) {
+        bs_copyOffscreen(command_buffer, frame.swapchain_frame);
+    }
+
     //vkCmdEndRenderPass(command_buffer);
     BS_VK_ERR(vkEndCommandBuffer(command_buffer), "Failed to record commands");
 
@@ -563,85 +996,113 @@ void bs_render(void (*tick)()) {
 
     VkSubmitInfo submit_i = { 0 };
     submit_i.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    submit_i.waitSemaphoreCount = 1;
+    submit_i.waitSemaphoreCount = config.headless ? 0 : 1;
     submit_i.pWaitSemaphores = wait_semaphores;
     submit_i.pSignalSemaphores = signal_semaphores;
-    submit_i.signalSemaphoreCount = 1;
+    submit_i.signalSemaphoreCount = config.headless ? 0 : 1;
     submit_i.pWaitDstStageMask = wait_stages;
     submit_i.commandBufferCount = 1;
     submit_i.pCommandBuffers = bs_vkHandleA(handle_offsets.command_buffers + frame.swapchain_frame);
 
-    BS_VK_ERR(vkQueueSubmit(graphics_queue, 1, &submit_i, render_fences[frame.swapchain_frame]), "Failed to submit queue");
-    VkSubpassDependency dependency = { 0 };
-    dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-    dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-    dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-    dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-
-    VkRenderPassCreateInfo render_pass_info;
-    render_pass_info.dependencyCount = 1;
-    render_pass_info.pDependencies = &dependency;
+    // uploads recorded before or during tick() have to land before the frame reads them
+    bs_flushUploads();
+    bs_flushShaderSpaces();
 
-    VkSwapchainKHR swapchains[] = { swapchain };
-    VkPresentInfoKHR present_i = { 0 };
-    present_i.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
-    present_i.waitSemaphoreCount = 1;
-    present_i.pWaitSemaphores = signal_semaphores;
-    present_i.swapchainCount = 1;
-    present_i.pSwapchains = swapchains;
-    present_i.pImageIndices = &current_swapchain_img;
+    BS_VK_ERR(vkQueueSubmit(graphics_queue, 1, &submit_i, render_fences[frame.swapchain_frame]), "Failed to submit queue");
 
-    result = vkQueuePresentKHR(present_queue, &present_i);
-    if(result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || window.resized) {
-        window.resized = false;
-        bs_recreateSwapchain();
-    } else if(result != VK_SUCCESS) {
-        bs_throw("Failed to acquire swapchain image");
+    if(config.headless) {
+        offscreen.pending[frame.swapchain_frame] = true;
+        offscreen.frame_nums[frame.swapchain_frame] = frame.frame_num;
+    } else {
+        bs_present(signal_semaphores);
     }
 
-    frame.swapchain_frame = (frame.swapchain_frame + 1) % BS_MAX_FRAMES_IN_FLIGHT;
+    frame.swapchain_frame = (frame.swapchain_frame + 1) % config.frames_in_flight;
+    frame.frame_num++;
 }
 
 static void bs_glfwResizeCallback(GLFWwindow* window, int width, int height);
+bs_Config bs_defaultConfig() {
+    bs_Config default_config = { 0 };
+    default_config.frames_in_flight = 2;
+    default_config.present_modes[0] = BS_PRESENT_FIFO;
+    default_config.num_present_modes = 1;
+    default_config.swapchain_images = 2;
+    default_config.pipeline_cache = BS_PIPELINE_CACHE_PATH;
+
+    return default_config;
+}
+
+bs_U32 bs_framesInFlight() {
+    return config.frames_in_flight;
+}
+
 void bs_ini(bs_U32 width, bs_U32 height, const char* name) {
+    bs_Config default_config = bs_defaultConfig();
+    bs_iniConfig(width, height, name, &default_config);
+}
+
+void bs_iniConfig(bs_U32 width, bs_U32 height, const char* name, bs_Config* user_config) {
+    config = *user_config;
+    config.frames_in_flight = bs_clamp(config.frames_in_flight, 1, BS_MAX_FRAMES_IN_FLIGHT);
+    config.num_present_modes = bs_min(config.num_present_modes, BS_MAX_PRESENT_MODES);
+
 	assert(CHAR_BIT * sizeof(float) == 32);
 	assert(CHAR_BIT * sizeof(char) == 8);
 
 	frame.resolution = bs_v2(width, height);
+    start_time = bs_time();
 
 	// glfw
-	if (!glfwInit()) {
-		bs_throw("Failed to initialize glfw");
-	}
+    if(!config.headless) {
+	    if (!glfwInit()) {
+		    bs_throw("Failed to initialize glfw");
+	    }
 
-	glfwSetErrorCallback(bs_glfwErrorCallback);
+	    glfwSetErrorCallback(bs_glfwErrorCallback);
 
-	glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+	    glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
 
-	window.glfw = glfwCreateWindow(frame.resolution.x, frame.resolution.y, name, NULL, NULL);
-	if (window.glfw == NULL) {
-		glfwTerminate();
-		bs_throw("Failed to create window");
-	}
+	    window.glfw = glfwCreateWindow(frame.resolution.x, frame.resolution.y, name, NULL, NULL);
+	    if (window.glfw == NULL) {
+		    glfwTerminate();
+		    bs_throw("Failed to create window");
+	    }
 
-	glfwSetKeyCallback(window.glfw, bs_glfwInputCallback);
-    glfwSetFramebufferSizeCallback(window.glfw, bs_glfwResizeCallback);
-	glfwSwapInterval(1);
+	    glfwSetKeyCallback(window.glfw, bs_glfwInputCallback);
+        glfwSetFramebufferSizeCallback(window.glfw, bs_glfwResizeCallback);
+	    glfwSwapInterval(1);
+    }
 
     vk_handles = bs_buffer(sizeof(void*), 16, 64, 0);
 
 	// vulkan
 	bs_prepareInstance();
 
-	BS_VK_ERR(glfwCreateWindowSurface(instance, window.glfw, NULL, &surface), "Failed to create surface");
+    if(!config.headless) {
+	    BS_VK_ERR(glfwCreateWindowSurface(instance, window.glfw, NULL, &surface), "Failed to create surface");
+    }
 
     bs_selectPhysicalDevice();
     bs_prepareLogicalDevice();
-    bs_prepareSwapchain();
+
+    if(config.headless) {
+        bs_prepareOffscreen();
+    } else {
+        bs_prepareSwapchain();
+    }
+
     bs_prepareImageViews();
     bs_prepareCommands();
     bs_prepareSynchronization();
+    bs_prepareStaging(BS_STAGING_SIZE);
+    bs_preparePipelineCache(config.pipeline_cache);
+    bs_prepareJobs(config.job_threads);
+    bs_prepareIo();
 
+    if(config.profile) {
+        bs_prepareProfiler();
+    }
 
     // vKDestroyPipelineLayout
     // vKDestroyRenderPass
@@ -649,7 +1110,32 @@ void bs_ini(bs_U32 width, bs_U32 height, const char* name) {
     // vkDestroyCommandPool
 }
 
+// renders config.headless_frames frames as fast as possible, every finished frame goes to config.readback
+static void bs_runHeadless(void (*tick)()) {
+    while(!offscreen.quit && (config.headless_frames == 0 || frame.frame_num < config.headless_frames)) {
+        frame.elapsed = bs_time() - start_time;
+        frame.delta_time = frame.elapsed - last_frame.elapsed;
+
+        bs_render(tick);
+
+        last_frame = frame;
+    }
+
+    vkDeviceWaitIdle(device);
+
+    // oldest slot first so frames arrive in order
+    for(int i = 0; i < config.frames_in_flight; i++) {
+        bs_readbackOffscreen((frame.swapchain_frame + i) % config.frames_in_flight);
+    }
+}
+
 void bs_run(void (*tick)()) {
+    if(config.headless) {
+        bs_runHeadless(tick);
+        bs_savePipelineCache(config.pipeline_cache);
+        return;
+    }
+
 	while (!glfwWindowShouldClose(window.glfw)) {
 
 		frame.elapsed = glfwGetTime();
@@ -664,6 +1150,7 @@ void bs_run(void (*tick)()) {
 		last_frame = frame;
 	}
 
+    bs_savePipelineCache(config.pipeline_cache);
 	glfwTerminate();
 }
 
@@ -672,6 +1159,11 @@ static void bs_glfwResizeCallback(GLFWwindow* glfw, int width, int height) {
 }
 
 void bs_exit() {
+    if(config.headless) {
+        offscreen.quit = true;
+        return;
+    }
+
 	glfwSetWindowShouldClose(window.glfw, GLFW_TRUE);
 }
 
@@ -703,6 +1195,7 @@ bool bs_keyUpOnce(bs_U32 code) {
 }
 
 void bs_wndTitle(const char* title) {
+    if(window.glfw == NULL) return;
 	glfwSetWindowTitle(window.glfw, title);
 }
 
@@ -718,6 +1211,7 @@ void bs_wndTitlef(const char* format, ...) {
 	va_end(argptr);
 }
 
+#ifdef _WIN32
 HWND bs_hwnd() {
 	return glfwGetWin32Window(window.glfw);
 }
@@ -734,4 +1228,25 @@ bs_PerformanceData bs_queryPerformance() {
 double bs_queryPerformanceResult(bs_PerformanceData data) {
 	QueryPerformanceCounter(&data.end);
 	return (double)(data.end - data.start) / data.frequency;
-}
\ No newline at end of file
+}
+#else
+static bs_I64 bs_nanoseconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (bs_I64)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+bs_PerformanceData bs_queryPerformance() {
+	bs_PerformanceData data = { 0 };
+
+    data.frequency = 1000000000;
+    data.start = bs_nanoseconds();
+
+	return data;
+}
+
+double bs_queryPerformanceResult(bs_PerformanceData data) {
+    data.end = bs_nanoseconds();
+	return (double)(data.end - data.start) / data.frequency;
+}
+#endif
\ No newline at end of file
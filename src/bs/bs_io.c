@@ -0,0 +1,476 @@
+#include <bs_types.h>
+#include <bs_ini.h>
+#include <bs_mem.h>
+#include <bs_jobs.h>
+#include <bs_io.h>
+
+#include <string.h>
+#include <stdint.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#endif
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define BS_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+#endif
+
+#ifdef BS_IO_URING
+// the rings are shared with the kernel, only the indices need ordering
+typedef struct {
+    int fd;
+    bs_U32 entries;
+
+    unsigned* sq_tail;
+    unsigned* sq_mask;
+    unsigned* sq_array;
+    struct io_uring_sqe* sqes;
+
+    unsigned* cq_head;
+    unsigned* cq_tail;
+    unsigned* cq_mask;
+    struct io_uring_cqe* cqes;
+
+    void* sq_ring;
+    void* cq_ring;
+    bs_U64 sq_ring_size;
+    bs_U64 cq_ring_size;
+
+    // written to the ring but not handed to the kernel yet
+    bs_U32 to_submit;
+    // handed to the kernel and not reaped yet
+    bs_U32 in_flight;
+} bs_Ring;
+#endif
+
+static struct {
+    bs_U32 backend;
+
+    // bs_IoRequest*, first in first out, waiting for room in BS_IO_QUEUE_DEPTH
+    bs_Buffer queued;
+    // bs_IoRequest*, started and not handed to their callback yet
+    bs_Buffer active;
+    bs_JobCounter reads;
+
+#ifdef BS_IO_URING
+    bs_Ring ring;
+#endif
+} io = { 0 };
+
+// - files -
+#ifdef _WIN32
+bool bs_openIo(bs_IoFile* file, const char* path) {
+    file->handle = -1;
+    file->size = 0;
+
+    HANDLE handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(handle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    if(!GetFileSizeEx(handle, &size)) {
+        CloseHandle(handle);
+        return false;
+    }
+
+    file->handle = (bs_I64)(intptr_t)handle;
+    file->size = size.QuadPart;
+    return true;
+}
+
+void bs_closeIo(bs_IoFile* file) {
+    if(file->handle != -1) {
+        CloseHandle((HANDLE)(intptr_t)file->handle);
+    }
+
+    file->handle = -1;
+}
+
+// the offset in the OVERLAPPED makes it positional, so threads can share a handle
+static bs_I64 bs_readAt(bs_IoFile* file, void* dst, bs_U64 offset, bs_U32 size) {
+    OVERLAPPED overlapped = { 0 };
+    overlapped.Offset = (DWORD)offset;
+    overlapped.OffsetHigh = (DWORD)(offset >> 32);
+
+    DWORD read = 0;
+    if(!ReadFile((HANDLE)(intptr_t)file->handle, dst, size, &read, &overlapped)) {
+        return GetLastError() == ERROR_HANDLE_EOF ? 0 : -1;
+    }
+
+    return read;
+}
+#else
+bool bs_openIo(bs_IoFile* file, const char* path) {
+    file->handle = -1;
+    file->size = 0;
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if(fd == -1) {
+        return false;
+    }
+
+    struct stat st;
+    if(fstat(fd, &st) != 0) {
+        close(fd);
+        return false;
+    }
+
+    file->handle = fd;
+    file->size = st.st_size;
+    return true;
+}
+
+void bs_closeIo(bs_IoFile* file) {
+    if(file->handle != -1) {
+        close((int)file->handle);
+    }
+
+    file->handle = -1;
+}
+
+static bs_I64 bs_readAt(bs_IoFile* file, void* dst, bs_U64 offset, bs_U32 size) {
+    ssize_t read;
+    do {
+        read = pread((int)file->handle, dst, size, offset);
+    } while(read == -1 && errno == EINTR);
+
+    return read;
+}
+#endif
+
+static bs_IoFile* bs_requestFile(bs_IoRequest* request) {
+    return request->file != NULL ? request->file : &request->opened;
+}
+
+// opens the file, fills in a size of 0 and allocates dst, doesn't throw so jobs can call it
+static bool bs_resolveRequest(bs_IoRequest* request) {
+    if(request->file == NULL && !bs_openIo(&request->opened, request->path)) {
+        return false;
+    }
+
+    bs_IoFile* file = bs_requestFile(request);
+    if(request->size == 0) {
+        if(request->offset > file->size) return false;
+        request->size = file->size - request->offset;
+    }
+
+    if(request->dst == NULL && request->size > 0) {
+        request->dst = bs_allocWith(NULL, request->size);
+    }
+
+    return true;
+}
+
+static bs_U32 bs_chunkSize(bs_IoRequest* request) {
+    bs_U64 remaining = request->size - request->bytes_read;
+    return remaining > BS_IO_MAX_CHUNK ? BS_IO_MAX_CHUNK : (bs_U32)remaining;
+}
+
+// - io_uring -
+#ifdef BS_IO_URING
+static bool bs_prepareRing() {
+    bs_Ring* ring = &io.ring;
+
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+
+    int fd = syscall(__NR_io_uring_setup, BS_IO_QUEUE_DEPTH, &params);
+    if(fd < 0) {
+        return false;
+    }
+
+    // IORING_OP_READ came with the same kernel, older ones fall back to the job threads
+    if(!(params.features & IORING_FEAT_RW_CUR_POS) || params.sq_entries < BS_IO_QUEUE_DEPTH) {
+        close(fd);
+        return false;
+    }
+
+    ring->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+
+    bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if(single_mmap && ring->cq_ring_size > ring->sq_ring_size) ring->sq_ring_size = ring->cq_ring_size;
+
+    ring->sq_ring = mmap(NULL, ring->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    ring->cq_ring = single_mmap ? ring->sq_ring : mmap(NULL, ring->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    ring->sqes = mmap(NULL, params.sq_entries * sizeof(struct io_uring_sqe), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+
+    if(ring->sq_ring == MAP_FAILED || ring->cq_ring == MAP_FAILED || ring->sqes == MAP_FAILED) {
+        if(ring->sqes != MAP_FAILED) munmap(ring->sqes, params.sq_entries * sizeof(struct io_uring_sqe));
+        if(ring->cq_ring != MAP_FAILED && !single_mmap) munmap(ring->cq_ring, ring->cq_ring_size);
+        if(ring->sq_ring != MAP_FAILED) munmap(ring->sq_ring, ring->sq_ring_size);
+        close(fd);
+        memset(ring, 0, sizeof(bs_Ring));
+        return false;
+    }
+
+    bs_U8* sq = ring->sq_ring;
+    ring->sq_tail = (unsigned*)(sq + params.sq_off.tail);
+    ring->sq_mask = (unsigned*)(sq + params.sq_off.ring_mask);
+    ring->sq_array = (unsigned*)(sq + params.sq_off.array);
+
+    bs_U8* cq = ring->cq_ring;
+    ring->cq_head = (unsigned*)(cq + params.cq_off.head);
+    ring->cq_tail = (unsigned*)(cq + params.cq_off.tail);
+    ring->cq_mask = (unsigned*)(cq + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+
+    ring->fd = fd;
+    ring->entries = params.sq_entries;
+    return true;
+}
+
+static void bs_freeRing() {
+    bs_Ring* ring = &io.ring;
+
+    munmap(ring->sqes, ring->entries * sizeof(struct io_uring_sqe));
+    if(ring->cq_ring != ring->sq_ring) munmap(ring->cq_ring, ring->cq_ring_size);
+    munmap(ring->sq_ring, ring->sq_ring_size);
+    close(ring->fd);
+    memset(ring, 0, sizeof(bs_Ring));
+}
+
+// requests have at most one read in flight, so BS_IO_QUEUE_DEPTH entries always have room for it
+static void bs_pushRingRead(bs_IoRequest* request) {
+    bs_Ring* ring = &io.ring;
+
+    unsigned tail = *ring->sq_tail;
+    unsigned index = tail & *ring->sq_mask;
+
+    struct io_uring_sqe* sqe = ring->sqes + index;
+    memset(sqe, 0, sizeof(struct io_uring_sqe));
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = (int)bs_requestFile(request)->handle;
+    sqe->off = request->offset + request->bytes_read;
+    sqe->addr = (bs_U64)(uintptr_t)(request->dst + request->bytes_read);
+    sqe->len = bs_chunkSize(request);
+    sqe->user_data = (bs_U64)(uintptr_t)request;
+
+    ring->sq_array[index] = index;
+    __atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    ring->to_submit++;
+    ring->in_flight++;
+}
+
+// one syscall submits every read pushed since the last one
+static void bs_enterRing(bs_U32 min_complete) {
+    bs_Ring* ring = &io.ring;
+    unsigned flags = min_complete > 0 ? IORING_ENTER_GETEVENTS : 0;
+
+    for(;;) {
+        int submitted = syscall(__NR_io_uring_enter, ring->fd, ring->to_submit, min_complete, flags, NULL, 0);
+        if(submitted >= 0) {
+            ring->to_submit -= submitted;
+            return;
+        }
+
+        // out of kernel resources, whatever is left goes with the next call once completions were reaped
+        if(errno == EAGAIN || errno == EBUSY) return;
+        if(errno != EINTR) bs_throw("Failed to submit reads to the io_uring");
+    }
+}
+
+static void bs_reapRing() {
+    bs_Ring* ring = &io.ring;
+    unsigned head = *ring->cq_head;
+
+    while(head != __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE)) {
+        struct io_uring_cqe* cqe = ring->cqes + (head & *ring->cq_mask);
+        bs_IoRequest* request = (bs_IoRequest*)(uintptr_t)cqe->user_data;
+        int result = cqe->res;
+        head++;
+        ring->in_flight--;
+
+        if(result == -EINTR || result == -EAGAIN) {
+            bs_pushRingRead(request);
+            continue;
+        }
+
+        // 0 is the end of the file before size bytes were read
+        if(result <= 0) {
+            request->state = BS_IO_FAILED;
+            continue;
+        }
+
+        request->bytes_read += result;
+        if(request->bytes_read < request->size) {
+            bs_pushRingRead(request);
+        } else {
+            request->state = BS_IO_DONE;
+        }
+    }
+
+    __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+}
+#endif
+
+// - jobs -
+static void bs_readJob(void* param, bs_U32 index) {
+    bs_IoRequest* request = param;
+    bool ok = bs_resolveRequest(request);
+
+    while(ok && request->bytes_read < request->size) {
+        bs_IoFile* file = bs_requestFile(request);
+        bs_I64 read = bs_readAt(file, request->dst + request->bytes_read, request->offset + request->bytes_read, bs_chunkSize(request));
+
+        ok = read > 0;
+        if(ok) request->bytes_read += read;
+    }
+
+    bs_atomicAdd(&request->state, ok ? BS_IO_DONE : BS_IO_FAILED);
+}
+
+// - queue -
+void bs_prepareIo() {
+    io.queued = bs_buffer(sizeof(bs_IoRequest*), 64, 64, 0);
+    io.active = bs_buffer(sizeof(bs_IoRequest*), 64, BS_IO_QUEUE_DEPTH, BS_IO_QUEUE_DEPTH);
+    io.backend = BS_IO_BACKEND_JOBS;
+
+#ifdef BS_IO_URING
+    if(bs_prepareRing()) {
+        io.backend = BS_IO_BACKEND_URING;
+    }
+#endif
+}
+
+bs_U32 bs_ioBackend() {
+    return io.backend;
+}
+
+void bs_readAsync(bs_IoRequest* request) {
+    request->state = BS_IO_PENDING;
+    request->bytes_read = 0;
+    request->opened.handle = -1;
+    bs_bufferAppend(&io.queued, &request);
+}
+
+static void bs_startRead(bs_IoRequest* request) {
+    bs_bufferAppend(&io.active, &request);
+
+    if(io.backend == BS_IO_BACKEND_JOBS) {
+        bs_pushBackgroundJob(bs_readJob, request, 0, &io.reads);
+        return;
+    }
+
+#ifdef BS_IO_URING
+    if(!bs_resolveRequest(request)) {
+        request->state = BS_IO_FAILED;
+    } else if(request->size == 0) {
+        request->state = BS_IO_DONE;
+    } else {
+        bs_pushRingRead(request);
+    }
+#endif
+}
+
+void bs_submitIo() {
+    bs_U32 started = 0;
+    while(started < io.queued.num_units && io.active.num_units < BS_IO_QUEUE_DEPTH) {
+        bs_startRead(*(bs_IoRequest**)bs_bufferData(&io.queued, started));
+        started++;
+    }
+
+    if(started > 0) {
+        io.queued.num_units -= started;
+        memmove(io.queued.data, bs_bufferData(&io.queued, started), io.queued.num_units * sizeof(bs_IoRequest*));
+    }
+
+#ifdef BS_IO_URING
+    if(io.backend == BS_IO_BACKEND_URING && io.ring.to_submit > 0) {
+        bs_enterRing(0);
+    }
+#endif
+}
+
+bs_U32 bs_pollIo() {
+    if(io.active.unit_size == 0) {
+        return 0;
+    }
+
+    bs_submitIo();
+
+#ifdef BS_IO_URING
+    if(io.backend == BS_IO_BACKEND_URING) {
+        bs_reapRing();
+        if(io.ring.to_submit > 0) bs_enterRing(0);
+    }
+#endif
+
+    bs_U32 completed = 0;
+    for(bs_U32 i = 0; i < io.active.num_units;) {
+        bs_IoRequest* request = *(bs_IoRequest**)bs_bufferData(&io.active, i);
+        if(bs_atomicLoad(&request->state) == BS_IO_PENDING) {
+            i++;
+            continue;
+        }
+
+        *(bs_IoRequest**)bs_bufferData(&io.active, i) = *(bs_IoRequest**)bs_bufferData(&io.active, io.active.num_units - 1);
+        io.active.num_units--;
+
+        // the request may be reused or freed by its callback
+        bs_closeIo(&request->opened);
+        if(request->callback != NULL) {
+            request->callback(request);
+        }
+
+        completed++;
+    }
+
+    // completions made room for queued reads, including the ones the callbacks queued
+    if(completed > 0) {
+        bs_submitIo();
+    }
+
+    return completed;
+}
+
+void bs_waitIo() {
+    while(io.queued.num_units > 0 || io.active.num_units > 0) {
+        bs_submitIo();
+
+#ifdef BS_IO_URING
+        if(io.backend == BS_IO_BACKEND_URING && io.ring.in_flight > 0) {
+            bs_enterRing(1);
+        }
+#endif
+
+        if(io.backend == BS_IO_BACKEND_JOBS) {
+            bs_waitJobs(&io.reads);
+        }
+
+        bs_pollIo();
+    }
+}
+
+bs_U32 bs_pendingIo() {
+    return io.queued.num_units + io.active.num_units;
+}
+
+void bs_freeIo() {
+    if(io.active.unit_size == 0) {
+        return;
+    }
+
+    bs_waitIo();
+
+#ifdef BS_IO_URING
+    if(io.backend == BS_IO_BACKEND_URING) {
+        bs_freeRing();
+    }
+#endif
+
+    bs_freeBuffer(&io.queued);
+    bs_freeBuffer(&io.active);
+    memset(&io, 0, sizeof(io));
+}
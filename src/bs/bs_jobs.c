@@ -0,0 +1,286 @@
+#include <bs_types.h>
+#include <bs_ini.h>
+#include <bs_jobs.h>
+
+#ifdef _WIN32
+#include <windows.h>
+
+typedef HANDLE bs_Thread;
+typedef SRWLOCK bs_Mutex;
+typedef CONDITION_VARIABLE bs_Cond;
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+typedef pthread_t bs_Thread;
+typedef pthread_mutex_t bs_Mutex;
+typedef pthread_cond_t bs_Cond;
+#endif
+
+typedef struct {
+    bs_JobFn fn;
+    void* param;
+    bs_U32 index;
+    bs_JobCounter* counter;
+} bs_Job;
+
+typedef struct {
+    bs_Job jobs[BS_JOB_QUEUE_SIZE];
+    bs_U32 head, tail;
+} bs_JobQueue;
+
+// rings of jobs behind a single lock, jobs are expected to be coarse (a few per thread per frame)
+// background jobs are only picked up by workers once the foreground ring is empty, so a thread
+// waiting on its own jobs never gets stuck running a long one
+static struct {
+    bs_Thread threads[BS_MAX_JOB_THREADS];
+    bs_U32 num_threads;
+
+    bs_Mutex mutex;
+    bs_Cond cond;
+
+    bs_JobQueue queue;
+    bs_JobQueue background;
+
+    bool quit;
+} jobs = { 0 };
+
+static BS_THREAD_LOCAL bs_U32 thread_index = 0;
+
+// - platform -
+#ifdef _WIN32
+static void bs_lock() { AcquireSRWLockExclusive(&jobs.mutex); }
+static void bs_unlock() { ReleaseSRWLockExclusive(&jobs.mutex); }
+static void bs_condWait() { SleepConditionVariableSRW(&jobs.cond, &jobs.mutex, INFINITE, 0); }
+static void bs_condSignal() { WakeConditionVariable(&jobs.cond); }
+static void bs_condBroadcast() { WakeAllConditionVariable(&jobs.cond); }
+static void bs_yield() { SwitchToThread(); }
+
+static bs_U32 bs_numCores() {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors;
+}
+
+bs_I32 bs_atomicAdd(volatile bs_I32* value, bs_I32 add) {
+    return InterlockedExchangeAdd((volatile LONG*)value, add) + add;
+}
+
+bs_I32 bs_atomicLoad(volatile bs_I32* value) {
+    return InterlockedCompareExchange((volatile LONG*)value, 0, 0);
+}
+#else
+static void bs_lock() { pthread_mutex_lock(&jobs.mutex); }
+static void bs_unlock() { pthread_mutex_unlock(&jobs.mutex); }
+static void bs_condWait() { pthread_cond_wait(&jobs.cond, &jobs.mutex); }
+static void bs_condSignal() { pthread_cond_signal(&jobs.cond); }
+static void bs_condBroadcast() { pthread_cond_broadcast(&jobs.cond); }
+static void bs_yield() { sched_yield(); }
+
+static bs_U32 bs_numCores() {
+    long num = sysconf(_SC_NPROCESSORS_ONLN);
+    return num < 1 ? 1 : num;
+}
+
+bs_I32 bs_atomicAdd(volatile bs_I32* value, bs_I32 add) {
+    return __atomic_add_fetch(value, add, __ATOMIC_SEQ_CST);
+}
+
+bs_I32 bs_atomicLoad(volatile bs_I32* value) {
+    return __atomic_load_n(value, __ATOMIC_SEQ_CST);
+}
+#endif
+
+// - queue -
+// expects the lock to be held
+static bool bs_popJob(bs_JobQueue* queue, bs_Job* job) {
+    if(queue->head == queue->tail) {
+        return false;
+    }
+
+    *job = queue->jobs[queue->tail % BS_JOB_QUEUE_SIZE];
+    queue->tail++;
+    return true;
+}
+
+static void bs_executeJob(bs_Job* job) {
+    job->fn(job->param, job->index);
+
+    if(job->counter != NULL) {
+        bs_atomicAdd(&job->counter->pending, -1);
+    }
+}
+
+static bool bs_runOneJob() {
+    bs_Job job;
+
+    bs_lock();
+    bool found = bs_popJob(&jobs.queue, &job);
+    bs_unlock();
+
+    if(found) {
+        bs_executeJob(&job);
+    }
+
+    return found;
+}
+
+static void bs_workerLoop(bs_U32 index) {
+    thread_index = index;
+
+    for(;;) {
+        bs_Job job;
+        bool found = false;
+
+        bs_lock();
+        while(!(found = bs_popJob(&jobs.queue, &job) || bs_popJob(&jobs.background, &job)) && !jobs.quit) {
+            bs_condWait();
+        }
+        bs_unlock();
+
+        // quitting and the queue is drained
+        if(!found) {
+            return;
+        }
+
+        bs_executeJob(&job);
+    }
+}
+
+#ifdef _WIN32
+static DWORD WINAPI bs_workerMain(LPVOID param) {
+    bs_workerLoop((bs_U32)(uintptr_t)param);
+    return 0;
+}
+#else
+static void* bs_workerMain(void* param) {
+    bs_workerLoop((bs_U32)(uintptr_t)param);
+    return NULL;
+}
+#endif
+
+void bs_prepareJobs(bs_U32 num_threads) {
+    if(num_threads == 0) {
+        num_threads = bs_numCores();
+    }
+
+    if(num_threads > BS_MAX_JOB_THREADS) {
+        num_threads = BS_MAX_JOB_THREADS;
+    }
+
+    jobs.num_threads = num_threads;
+    jobs.queue.head = jobs.queue.tail = 0;
+    jobs.background.head = jobs.background.tail = 0;
+    jobs.quit = false;
+
+#ifdef _WIN32
+    InitializeSRWLock(&jobs.mutex);
+    InitializeConditionVariable(&jobs.cond);
+#else
+    pthread_mutex_init(&jobs.mutex, NULL);
+    pthread_cond_init(&jobs.cond, NULL);
+#endif
+
+    // thread 0 is the main thread
+    for(bs_U32 i = 1; i < num_threads; i++) {
+#ifdef _WIN32
+        jobs.threads[i] = CreateThread(NULL, 0, bs_workerMain, (LPVOID)(uintptr_t)i, 0, NULL);
+        if(jobs.threads[i] == NULL) {
+            bs_throw("Failed to create worker thread");
+        }
+#else
+        if(pthread_create(jobs.threads + i, NULL, bs_workerMain, (void*)(uintptr_t)i) != 0) {
+            bs_throw("Failed to create worker thread");
+        }
+#endif
+    }
+}
+
+void bs_freeJobs() {
+    bs_lock();
+    jobs.quit = true;
+    bs_condBroadcast();
+    bs_unlock();
+
+    for(bs_U32 i = 1; i < jobs.num_threads; i++) {
+#ifdef _WIN32
+        WaitForSingleObject(jobs.threads[i], INFINITE);
+        CloseHandle(jobs.threads[i]);
+#else
+        pthread_join(jobs.threads[i], NULL);
+#endif
+    }
+
+#ifndef _WIN32
+    pthread_mutex_destroy(&jobs.mutex);
+    pthread_cond_destroy(&jobs.cond);
+#endif
+
+    jobs.num_threads = 0;
+}
+
+bs_U32 bs_numJobThreads() {
+    return jobs.num_threads == 0 ? 1 : jobs.num_threads;
+}
+
+bs_U32 bs_jobThreadIndex() {
+    return thread_index;
+}
+
+static void bs_queueJob(bs_JobQueue* queue, bs_JobFn fn, void* param, bs_U32 index, bs_JobCounter* counter) {
+    if(counter != NULL) {
+        bs_atomicAdd(&counter->pending, 1);
+    }
+
+    bs_Job job = { fn, param, index, counter };
+
+    // single threaded, nothing would ever pick the job up
+    if(jobs.num_threads <= 1) {
+        bs_executeJob(&job);
+        return;
+    }
+
+    for(;;) {
+        bs_lock();
+        if(queue->head - queue->tail < BS_JOB_QUEUE_SIZE) {
+            queue->jobs[queue->head % BS_JOB_QUEUE_SIZE] = job;
+            queue->head++;
+            bs_condSignal();
+            bs_unlock();
+            return;
+        }
+        bs_unlock();
+
+        // queue is full, help drain it
+        if(!bs_runOneJob()) {
+            bs_yield();
+        }
+    }
+}
+
+void bs_pushJob(bs_JobFn fn, void* param, bs_U32 index, bs_JobCounter* counter) {
+    bs_queueJob(&jobs.queue, fn, param, index, counter);
+}
+
+void bs_pushBackgroundJob(bs_JobFn fn, void* param, bs_U32 index, bs_JobCounter* counter) {
+    bs_queueJob(&jobs.background, fn, param, index, counter);
+}
+
+void bs_waitJobs(bs_JobCounter* counter) {
+    while(bs_atomicLoad(&counter->pending) > 0) {
+        if(!bs_runOneJob()) {
+            bs_yield();
+        }
+    }
+}
+
+void bs_runJobs(bs_JobFn fn, void* param, bs_U32 num_jobs) {
+    bs_JobCounter counter = { 0 };
+
+    for(bs_U32 i = 0; i < num_jobs; i++) {
+        bs_pushJob(fn, param, i, &counter);
+    }
+
+    bs_waitJobs(&counter);
+}
@@ -2,147 +2,359 @@
 #include <string.h>
 #include <stddef.h>
 #include <stdarg.h>
+#include <stdint.h>
 
 #include <bs_types.h>
 #include <bs_mem.h>
-#include <bs_wnd.h>
+#include <bs_ini.h>
+#include <bs_json.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// syntax tokens point in here rather than into raw, so the byte after a scalar can be overwritten with its terminator
+static const char json_syntax[] = "{\0}\0[\0]\0:\0,";
+
+static inline char* bs_getJsonToken(bs_Json* json, bs_JsonToken* tok) {
+	if (tok->type == BS_JSON_SYNTAX) {
+		return (char*)json_syntax + tok->offset;
+	}
 
-inline char* bs_getJsonToken(bs_Json* json, bs_JsonToken* tok) {
 	char* p = json->token_data + tok->offset;
 	return p;
 }
 
 // lexer
-char* bs_lexJsonString(char* raw, char** out, int* out_len) {
-	if (raw[0] == '\"') raw++;
-	else return raw;
-
-	const char* beginning = raw;
+#define BS_JSON_SPACE 0x01
+#define BS_JSON_STRUCTURAL 0x02
+
+static const bs_U8 json_classes[256] = {
+	[' '] = BS_JSON_SPACE, ['\t'] = BS_JSON_SPACE, ['\n'] = BS_JSON_SPACE, ['\r'] = BS_JSON_SPACE,
+	['{'] = BS_JSON_STRUCTURAL, ['}'] = BS_JSON_STRUCTURAL, ['['] = BS_JSON_STRUCTURAL,
+	[']'] = BS_JSON_STRUCTURAL, [':'] = BS_JSON_STRUCTURAL, [','] = BS_JSON_STRUCTURAL,
+};
+
+// a block is classified into one bit per byte at once, the scalar loops finish the bytes that don't fill a block
+#if defined(__AVX2__)
+#define BS_JSON_BLOCK 32
+typedef __m256i bs_JsonVec;
+#define BS_JSON_LOAD(p) _mm256_loadu_si256((const __m256i*)(p))
+#define BS_JSON_SET(c) _mm256_set1_epi8(c)
+#define BS_JSON_EQ(a, b) _mm256_cmpeq_epi8(a, b)
+#define BS_JSON_OR(a, b) _mm256_or_si256(a, b)
+#define BS_JSON_MOVEMASK(v) (bs_U32)_mm256_movemask_epi8(v)
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BS_JSON_BLOCK 16
+typedef __m128i bs_JsonVec;
+#define BS_JSON_LOAD(p) _mm_loadu_si128((const __m128i*)(p))
+#define BS_JSON_SET(c) _mm_set1_epi8(c)
+#define BS_JSON_EQ(a, b) _mm_cmpeq_epi8(a, b)
+#define BS_JSON_OR(a, b) _mm_or_si128(a, b)
+#define BS_JSON_MOVEMASK(v) (bs_U32)_mm_movemask_epi8(v)
+#endif
+
+#ifdef BS_JSON_BLOCK
+#define BS_JSON_FULL_MASK ((bs_U32)((1ull << BS_JSON_BLOCK) - 1))
+
+static inline bs_U32 bs_jsonFirstBit(bs_U32 mask) {
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return index;
+#else
+	return __builtin_ctz(mask);
+#endif
+}
+
+static inline bs_U32 bs_jsonSpaceMask(bs_JsonVec v) {
+	bs_JsonVec space = BS_JSON_OR(BS_JSON_EQ(v, BS_JSON_SET(' ')), BS_JSON_EQ(v, BS_JSON_SET('\n')));
+	bs_JsonVec control = BS_JSON_OR(BS_JSON_EQ(v, BS_JSON_SET('\r')), BS_JSON_EQ(v, BS_JSON_SET('\t')));
+	return BS_JSON_MOVEMASK(BS_JSON_OR(space, control));
+}
+
+// '[' and '{' as well as ']' and '}' only differ in 0x20, so setting it folds each pair into one compare
+static inline bs_U32 bs_jsonStructuralMask(bs_JsonVec v) {
+	bs_JsonVec folded = BS_JSON_OR(v, BS_JSON_SET(0x20));
+	bs_JsonVec brackets = BS_JSON_OR(BS_JSON_EQ(folded, BS_JSON_SET('{')), BS_JSON_EQ(folded, BS_JSON_SET('}')));
+	bs_JsonVec separators = BS_JSON_OR(BS_JSON_EQ(v, BS_JSON_SET(':')), BS_JSON_EQ(v, BS_JSON_SET(',')));
+	return BS_JSON_MOVEMASK(BS_JSON_OR(brackets, separators));
+}
+#endif
+
+// most tokens are followed by a single space or none, so the first byte is checked before a block is loaded
+static char* bs_skipJsonSpace(char* p, char* end) {
+	if (p < end && !(json_classes[(bs_U8)*p] & BS_JSON_SPACE)) {
+		return p;
+	}
 
-	while(raw[0] != '\0') {
-		if (raw[0] == '\"') {
-			*out = beginning;
-			*out_len += (raw - beginning);
+#ifdef BS_JSON_BLOCK
+	for (; end - p >= BS_JSON_BLOCK; p += BS_JSON_BLOCK) {
+		bs_U32 mask = ~bs_jsonSpaceMask(BS_JSON_LOAD(p)) & BS_JSON_FULL_MASK;
+		if (mask != 0) return p + bs_jsonFirstBit(mask);
+	}
+#endif
 
-			return raw + 1;
-		}
+	while (p < end && (json_classes[(bs_U8)*p] & BS_JSON_SPACE)) p++;
+	return p;
+}
 
-		raw++;
+// end of a number or word
+static char* bs_findJsonDelimiter(char* p, char* end) {
+#ifdef BS_JSON_BLOCK
+	for (; end - p >= BS_JSON_BLOCK; p += BS_JSON_BLOCK) {
+		bs_JsonVec v = BS_JSON_LOAD(p);
+		bs_U32 mask = bs_jsonSpaceMask(v) | bs_jsonStructuralMask(v);
+		if (mask != 0) return p + bs_jsonFirstBit(mask);
 	}
+#endif
 
-	bs_callErrorf(BS_ERROR_JSON_EXPECTED_CHAR, 2, "Expected end-of-string quote char");
-	return raw;
+	while (p < end && json_classes[(bs_U8)*p] == 0) p++;
+	return p;
 }
 
-char* bs_lexJsonNumber(char* raw, char** out, int* out_len) {
-	if ((raw[0] != '-') && (raw[0] < '0') && (raw[0] > '9')) {
-		return raw;
+static char* bs_findJsonByte(char* p, char* end, char c) {
+#ifdef BS_JSON_BLOCK
+	for (; end - p >= BS_JSON_BLOCK; p += BS_JSON_BLOCK) {
+		bs_U32 mask = BS_JSON_MOVEMASK(BS_JSON_EQ(BS_JSON_LOAD(p), BS_JSON_SET(c)));
+		if (mask != 0) return p + bs_jsonFirstBit(mask);
 	}
+#endif
+
+	while (p < end && *p != c) p++;
+	return p;
+}
 
-	const char* beginning = raw;
+// closing quote of a string starting at p, quotes after an odd number of backslashes are escaped
+static char* bs_findJsonQuote(char* p, char* end) {
+	char* begin = p;
 
-	while (raw[0] != '\0') {
-		if (strchr("e-.0123456789", raw[0]) == NULL) {
-			*out = beginning;
-			*out_len += (raw - beginning);
+	for (;;) {
+		p = bs_findJsonByte(p, end, '"');
+		if (p == end) return end;
 
-			return raw;
-		}
+		int backslashes = 0;
+		while (p - backslashes > begin && p[-backslashes - 1] == '\\') backslashes++;
+		if (backslashes % 2 == 0) return p;
 
-		raw++;
+		p++;
 	}
 }
 
-char* bs_lexJsonWord(char* raw, char** out, int* out_len, const char* word, int word_len, int remaining) {
-	if (remaining >= word_len && strncmp(raw, word, word_len) == 0) {
-		*out = raw;
-		*out_len += word_len;
+static void bs_pushJsonToken(bs_Json* json, bs_U32* capacity, bs_U8 type, int offset, int len) {
+	if ((bs_U32)json->num_tokens == *capacity) {
+		json->tokens = bs_reallocWith(json->allocator, json->tokens, *capacity * sizeof(bs_JsonToken), *capacity * 2 * sizeof(bs_JsonToken));
+		*capacity *= 2;
+	}
 
-		return raw + word_len;
+	bs_JsonToken* token = json->tokens + json->num_tokens++;
+	token->type = type;
+	token->offset = offset;
+	token->len = len;
+	token->end = 0;
+}
+
+static void bs_pushJsonSyntax(bs_Json* json, bs_U32* capacity, char c) {
+	int offset = 0;
+	switch (c) {
+	case '{': offset = 0; break;
+	case '}': offset = 2; break;
+	case '[': offset = 4; break;
+	case ']': offset = 6; break;
+	case ':': offset = 8; break;
+	case ',': offset = 10; break;
 	}
 
-	return raw;
+	bs_pushJsonToken(json, capacity, BS_JSON_SYNTAX, offset, 1);
 }
 
-static bs_U32 bs_calculateNumTokens(bs_Json* json) {
-	char* raw = json->raw;
-	int len = 0;
-	while (raw[0] != '\0') {
-		int remaining = raw - json->raw;
-		char* tok = NULL;
-		char* prev = raw;
-
-		if ((prev != (raw = bs_lexJsonString(raw, &tok, &len))) ||
-			(prev != (raw = bs_lexJsonNumber(raw, &tok, &len))) ||
-			(prev != (raw = bs_lexJsonWord(raw, &tok, &len, "true", 4, remaining))) ||
-			(prev != (raw = bs_lexJsonWord(raw, &tok, &len, "false", 5, remaining))) ||
-			(prev != (raw = bs_lexJsonWord(raw, &tok, &len, "null", 4, remaining)))
-		) {
-			json->num_tokens++;
-		}
-		else if (strchr("{[\":,]}", raw[0]) != NULL) {
-			json->num_tokens++;
-			len++;
-			raw++;
-		}
-		else raw++;
+// index
+// objects with up to this many members are searched in place, their tokens are next to each other
+// while a table of every key in the file isn't
+#define BS_JSON_SEARCHED_MEMBERS 16
+
+static bool bs_isJsonSyntax(bs_Json* json, bs_JsonToken* token, char c) {
+	return token->type == BS_JSON_SYNTAX && bs_getJsonToken(json, token)[0] == c;
+}
+
+static bool bs_isJsonOpen(bs_Json* json, bs_JsonToken* token) {
+	return bs_isJsonSyntax(json, token, '{') || bs_isJsonSyntax(json, token, '[');
+}
+
+// objects mostly share key names, mixing the object in spreads them over the table
+static bs_U64 bs_jsonKeyHash(bs_JsonToken* object, const char* name, int len) {
+	return bs_hash(name, len) ^ ((bs_U64)(uintptr_t)object * 0x9E3779B97F4A7C15ull);
+}
+
+// next key of an object's direct members after token, nested objects and arrays are skipped over
+static bs_JsonToken* bs_nextJsonKey(bs_Json* json, bs_JsonToken* object, bs_JsonToken* token) {
+	bs_JsonToken* end = object + object->end;
+
+	for (token++; token < end; token += token->end + 1) {
+		if (token->type == BS_JSON_STRING && bs_isJsonSyntax(json, token + 1, ':')) {
+			return token;
+		}
 	}
-	return len;
+
+	return NULL;
 }
 
-void bs_lexJson(bs_Json* json) {
-	json->token_len = bs_calculateNumTokens(json);
-	json->token_data = bs_alloc(json->token_len + json->num_tokens);
-	json->tokens = bs_alloc(json->num_tokens * sizeof(bs_JsonToken));
-	bs_JsonToken* result = json->tokens;
+static bs_U32 bs_countJsonMembers(bs_Json* json, bs_JsonToken* object, bs_U32 max_members) {
+	bs_U32 num_members = 0;
 
-	char* raw = json->raw;
-	bs_U32 offset = 0;
-	int tok_offset = 0;
-	while (raw[0] != '\0') {
-		int remaining = raw - json->raw;
-		int tok_len = 0;
-		char* tok = NULL;
-		char* prev = raw;
+	for (bs_JsonToken* key = bs_nextJsonKey(json, object, object); key != NULL && num_members < max_members; key = bs_nextJsonKey(json, object, key)) {
+		num_members++;
+	}
+
+	return num_members;
+}
+
+static void bs_addJsonKey(bs_Json* json, bs_JsonToken* object, bs_JsonToken* key) {
+	char* name = bs_getJsonToken(json, key);
+	bs_U64 hash = bs_jsonKeyHash(object, name, key->len);
+	bs_U32 mask = json->num_keys - 1;
 
-		if (prev != (raw = bs_lexJsonString(raw, &tok, &tok_len))) {
-			result->type = BS_JSON_STRING;
-			memcpy(json->token_data + offset, tok, tok_len);
+	for (bs_U32 i = hash & mask;; i = (i + 1) & mask) {
+		bs_JsonKey* slot = json->keys + i;
+
+		if (slot->object == NULL) {
+			slot->object = object;
+			slot->key = key;
+			slot->hash = (bs_U32)hash;
+			return;
 		}
-		else if(prev != (raw = bs_lexJsonNumber(raw, &tok, &tok_len))) {
-			result->type = BS_JSON_NUMBER;
-			memcpy(json->token_data + offset, tok, tok_len);
+
+		// the first of duplicate keys wins, like it did for the linear search
+		if (slot->object == object && slot->hash == (bs_U32)hash && slot->key->len == key->len && memcmp(bs_getJsonToken(json, slot->key), name, key->len) == 0) {
+			return;
 		}
-		else if (prev != (raw = bs_lexJsonWord(raw, &tok, &tok_len, "true", 4, remaining))) {
-			result->type = BS_JSON_BOOL;
-			memcpy(json->token_data + offset, tok, tok_len);
+	}
+}
+
+// matches brackets, then puts the keys of every object with more than BS_JSON_SEARCHED_MEMBERS members in the table.
+// open brackets hold the index of their parent until they're closed, so no stack is needed
+static void bs_indexJson(bs_Json* json) {
+	bs_JsonToken* tokens = json->tokens;
+	int open = -1;
+
+	for (int i = 0; i < json->num_tokens; i++) {
+		bs_JsonToken* token = tokens + i;
+		token->end = 0;
+
+		if (bs_isJsonOpen(json, token)) {
+			token->end = open;
+			open = i;
 		}
-		else if (prev != (raw = bs_lexJsonWord(raw, &tok, &tok_len, "false", 5, remaining))) {
-			result->type = BS_JSON_BOOL;
-			memcpy(json->token_data + offset, tok, tok_len);
+		else if ((bs_isJsonSyntax(json, token, '}') || bs_isJsonSyntax(json, token, ']')) && open != -1) {
+			int parent = tokens[open].end;
+			tokens[open].end = i - open;
+			open = parent;
 		}
-		else if (prev != (raw = bs_lexJsonWord(raw, &tok, &tok_len, "null", 4, remaining))) {
-			result->type = BS_JSON_STRING;
-			memcpy(json->token_data + offset, tok, tok_len);
+	}
+
+	// unclosed brackets run to the last token
+	while (open != -1) {
+		int parent = tokens[open].end;
+		tokens[open].end = json->num_tokens - 1 - open;
+		open = parent;
+	}
+
+	bs_U32 num_indexed = 0;
+	for (int i = 0; i < json->num_tokens; i++) {
+		if (!bs_isJsonSyntax(json, tokens + i, '{')) continue;
+
+		bs_U32 num_members = bs_countJsonMembers(json, tokens + i, UINT32_MAX);
+		if (num_members > BS_JSON_SEARCHED_MEMBERS) num_indexed += num_members;
+	}
+
+	// at most half full so probes stay short
+	json->num_keys = 1;
+	while (json->num_keys < num_indexed * 2) json->num_keys *= 2;
+
+	json->keys = bs_allocWith(json->allocator, json->num_keys * sizeof(bs_JsonKey));
+	memset(json->keys, 0, json->num_keys * sizeof(bs_JsonKey));
+
+	for (int i = 0; i < json->num_tokens; i++) {
+		bs_JsonToken* object = tokens + i;
+		if (!bs_isJsonSyntax(json, object, '{')) continue;
+		if (bs_countJsonMembers(json, object, BS_JSON_SEARCHED_MEMBERS + 1) <= BS_JSON_SEARCHED_MEMBERS) continue;
+
+		for (bs_JsonToken* key = bs_nextJsonKey(json, object, object); key != NULL; key = bs_nextJsonKey(json, object, key)) {
+			bs_addJsonKey(json, object, key);
 		}
-		else if (strchr("{[\":,]}", raw[0]) != NULL) {
-			result->type = BS_JSON_SYNTAX;
-			json->token_data[offset] = raw[0];
-			tok_len = 1;
-			raw++;
+	}
+}
+
+// single pass over raw, tokens point back into it and are terminated in place.
+// raw becomes the token data, json->raw is left alone so the text can still be written back out
+void bs_lexJson(bs_Json* json, char* raw, int raw_len) {
+	char* end = raw + raw_len;
+	// files are loaded with their terminator counted
+	if (end > raw && end[-1] == '\0') end--;
+
+	// glTF averages a few bytes per token, the array doubles if that's short
+	bs_U32 capacity = raw_len / 8 + 16;
+	json->tokens = bs_allocWith(json->allocator, capacity * sizeof(bs_JsonToken));
+	json->num_tokens = 0;
+	json->token_data = raw;
+
+	char* p = raw;
+	while ((p = bs_skipJsonSpace(p, end)) < end) {
+		char c = *p;
+
+		if (json_classes[(bs_U8)c] & BS_JSON_STRUCTURAL) {
+			bs_pushJsonSyntax(json, &capacity, c);
+			p++;
+			continue;
 		}
-		else {
-			raw++;
+
+		if (c == '"') {
+			char* quote = bs_findJsonQuote(p + 1, end);
+			if (quote == end) {
+				bs_throw("JSON: Expected end-of-string quote char");
+				break;
+			}
+
+			*quote = '\0';
+			bs_pushJsonToken(json, &capacity, BS_JSON_STRING, p + 1 - raw, quote - p - 1);
+			p = quote + 1;
 			continue;
 		}
 
-		result->len = tok_len;
-		result->offset = offset;
-		result++;
+		char* delimiter = bs_findJsonDelimiter(p, end);
+		int len = delimiter - p;
+
+		if (c == '-' || (c >= '0' && c <= '9')) {
+			bs_pushJsonToken(json, &capacity, BS_JSON_NUMBER, p - raw, len);
+		}
+		else if ((len == 4 && memcmp(p, "true", 4) == 0) || (len == 5 && memcmp(p, "false", 5) == 0)) {
+			bs_pushJsonToken(json, &capacity, BS_JSON_BOOL, p - raw, len);
+		}
+		else if (len == 4 && memcmp(p, "null", 4) == 0) {
+			bs_pushJsonToken(json, &capacity, BS_JSON_STRING, p - raw, len);
+		}
+
+		// the terminator goes where the delimiter was, a structural one is pushed first.
+		// raw is terminated right after end, so a scalar running to it already is
+		if (delimiter < end) {
+			if (json_classes[(bs_U8)*delimiter] & BS_JSON_STRUCTURAL) {
+				bs_pushJsonSyntax(json, &capacity, *delimiter);
+			}
+
+			*delimiter = '\0';
+			delimiter++;
+		}
 
-		offset += tok_len;
-		json->token_data[offset++] = '\0';
+		p = delimiter;
 	}
+
+	bs_indexJson(json);
 }
 
 // writer
@@ -217,6 +429,37 @@ bs_JsonField bs_createJsonObjectArray(const char* field, bs_Json* value, int num
 	return bs_createJsonField(field, num_elements, value, false, false, true);
 }
 
+// jsons lexed in place and objects parsed out of a json have no raw, they're written from their tokens on one line.
+// out can be NULL to get the length
+static int bs_writeJsonTokens(bs_Json* obj, char* out) {
+	// a parsed object counts the tokens up to its closing brace
+	int num_tokens = obj->num_tokens;
+	if (num_tokens > 0 && obj->tokens[0].end > 0) {
+		num_tokens = obj->tokens[0].end + 1;
+	}
+
+	int len = 0;
+	for (int i = 0; i < num_tokens; i++) {
+		bs_JsonToken* token = obj->tokens + i;
+		const char* text = bs_getJsonToken(obj, token);
+
+		// strings keep their opening quote in front of them, null doesn't have one
+		bool quoted = token->type == BS_JSON_STRING && token->offset > 0 && obj->token_data[token->offset - 1] == '"';
+		bool spaced = token->type == BS_JSON_SYNTAX && (text[0] == ':' || text[0] == ',');
+
+		if (out != NULL) {
+			if (quoted) out[len] = '"';
+			memcpy(out + len + quoted, text, token->len);
+			if (quoted) out[len + 1 + token->len] = '"';
+			if (spaced) out[len + token->len] = ' ';
+		}
+
+		len += token->len + (quoted ? 2 : 0) + (spaced ? 1 : 0);
+	}
+
+	return len;
+}
+
 int bs_addJsonObjectField(bs_Json* json, bs_JsonField* field, int offset, int index, int* indent) {
 	json->raw[offset++] = '\n';
 	for (int j = 0; j < (*indent); j++) {
@@ -225,6 +468,10 @@ int bs_addJsonObjectField(bs_Json* json, bs_JsonField* field, int offset, int in
 
 	bs_Json* obj = (field->num_elements == 0) ? &field->value.as_object : (field->value.as_array.as_objects + index);
 
+	if (obj->raw == NULL) {
+		return offset + bs_writeJsonTokens(obj, json->raw + offset);
+	}
+
 	for (int i = 0; i < obj->raw_len; i++) {
 		json->raw[offset++] = obj->raw[i];
 		if (obj->raw[i] == '\n') {
@@ -241,6 +488,10 @@ bs_U32 bs_calculateJsonObjectFieldSize(bs_Json* json, bs_JsonField* field, int i
 	bs_U32 size = 1 + (*indent);
 	bs_Json* ptr = (field->num_elements == 0) ? &field->value.as_object : field->value.as_array.as_objects;
 
+	if (ptr[index].raw == NULL) {
+		return size + bs_writeJsonTokens(ptr + index, NULL);
+	}
+
 	for (int i = 0; i < ptr[index].raw_len; i++) {
 		size++;
 		if (ptr[index].raw[i] == '\n') {
@@ -375,11 +626,8 @@ char* bs_jsonFromFields(bs_Json* json, bs_JsonField* fields, int num_fields) {
 	offset += bs_addJsonTokens(json->raw + offset, "\n}\0", 3);
 
 	if (json->raw_len != (offset - 1)) {
-		bs_callErrorf(
-			BS_ERROR_JSON_FAILED_CALCULATION, 2, 
-			"JSON: Failed to calculate the correct size (expected %d, actual %d)", 
-			json->raw_len, offset - 1
-		);
+		printf("JSON: expected %d bytes, wrote %d\n", json->raw_len, offset - 1);
+		bs_throw("JSON: Failed to calculate the correct size");
 	}
 
 	return json->raw;
@@ -390,18 +638,12 @@ bs_JsonValue bs_parseJsonObject(bs_Json* json, bs_JsonToken* token) {
 	bs_JsonValue val = { 0 };
 
 	val.as_object.token_data = json->token_data;
+	val.as_object.allocator = json->allocator;
+	val.as_object.keys = json->keys;
+	val.as_object.num_keys = json->num_keys;
 	val.as_object.tokens = token;
-	val.as_object.num_tokens = 0;
+	val.as_object.num_tokens = token->end;
 	val.found = true;
-	char* tok = bs_getJsonToken(json, token);
-	int num = 1;
-	while (num != 0) {
-		val.as_object.num_tokens++;
-		tok = bs_getJsonToken(json, ++token);
-
-		if (tok[0] == '{' || tok[0] == '[') num++;
-		else if (tok[0] == '}' || tok[0] == ']') num--;
-	}
 
 	return val;
 }
@@ -411,14 +653,7 @@ bs_U32 bs_calculateJsonObjectArraySize(bs_Json* json, bs_JsonToken* token, bs_U3
 
 	while (bs_getJsonToken(json, token)[0] != ']') {
 		if (bs_getJsonToken(json, token)[0] == '{') {
-			int num = 1;
-			while (num != 0) {
-				char tok = bs_getJsonToken(json, ++token)[0];
-
-				if (tok == '{' || tok == '[') num++;
-				else if (tok == '}' || tok == ']') num--;
-			}
-
+			token += token->end;
 			size += object_size;
 		}
 		else {
@@ -436,14 +671,7 @@ bs_U32 bs_calculateJsonArraySize(bs_Json* json, bs_JsonToken* token) {
 
 	while (bs_getJsonToken(json, token)[0] != ']') {
 		if (bs_getJsonToken(json, token)[0] == '{') {
-			int num = 1;
-			while (num != 0) {
-				char tok = bs_getJsonToken(json, ++token)[0];
-
-				if (tok == '{' || tok == '[') num++;
-				else if (tok == '}' || tok == ']') num--;
-			}
-
+			token += token->end;
 			size += sizeof(bs_Json);
 		}
 		else if (token->type == BS_JSON_NUMBER) {
@@ -467,7 +695,7 @@ bs_JsonValue bs_parseJsonArray(bs_Json* json, bs_JsonToken* token) {
 	bs_U32 expected_size = bs_calculateJsonArraySize(json, token);
 	bs_U32 actual_size = 0;
 	val.found = true;
-	val.as_array.as_strings = malloc(expected_size);
+	val.as_array.as_strings = bs_allocWith(json->allocator, expected_size);
 	int offset = 0;
 	while (bs_getJsonToken(json, token)[0] != ']') {
 		char* tok = bs_getJsonToken(json, token);
@@ -508,17 +736,47 @@ bs_JsonValue bs_parseJsonArray(bs_Json* json, bs_JsonToken* token) {
 	}
 
 	if (expected_size != actual_size) {
-		bs_callErrorf(
-			BS_ERROR_JSON_FAILED_CALCULATION, 2,
-			"JSON: Failed to calculate the correct size (expected %d, actual %d)",
-			expected_size, actual_size
-		);
+		printf("JSON: expected %d bytes, wrote %d\n", expected_size, actual_size);
+		bs_throw("JSON: Failed to calculate the correct size");
 	}
 
 	return val;
 }
 
+static bs_JsonToken* bs_findIndexedToken(bs_Json* json, const char* field) {
+	int len = strlen(field);
+	bs_JsonToken* key = bs_nextJsonKey(json, json->tokens, json->tokens);
+
+	// the first members are searched in place, only objects that have more of them are in the table
+	for (int i = 0; key != NULL && i < BS_JSON_SEARCHED_MEMBERS; i++) {
+		if (key->len == len && memcmp(bs_getJsonToken(json, key), field, len) == 0) {
+			return key + 2;
+		}
+
+		key = bs_nextJsonKey(json, json->tokens, key);
+	}
+
+	if (key == NULL) return NULL;
+
+	bs_U64 hash = bs_jsonKeyHash(json->tokens, field, len);
+	bs_U32 mask = json->num_keys - 1;
+
+	for (bs_U32 i = hash & mask;; i = (i + 1) & mask) {
+		bs_JsonKey* slot = json->keys + i;
+		if (slot->object == NULL) return NULL;
+
+		if (slot->object == json->tokens && slot->hash == (bs_U32)hash && slot->key->len == len && memcmp(bs_getJsonToken(json, slot->key), field, len) == 0) {
+			return slot->key + 2;
+		}
+	}
+}
+
 bs_JsonToken* bs_findToken(bs_Json* json, const char* field) {
+	// objects start with their brace, anything else is searched linearly
+	if (json->keys != NULL && json->num_tokens > 0 && bs_isJsonSyntax(json, json->tokens, '{')) {
+		return bs_findIndexedToken(json, field);
+	}
+
 	int t = 0;
 	for (int i = 1; i < json->num_tokens - 2; i++) {
 		bs_JsonToken* token = json->tokens + i;
@@ -546,11 +804,11 @@ void* bs_jsonFieldObjectArray(
 {
 	bs_JsonToken* token = bs_findToken(json, field);
 
-	if (token == NULL) return;
-	if (bs_getJsonToken(json, token)[0] != '[') return;
+	if (token == NULL) return NULL;
+	if (bs_getJsonToken(json, token)[0] != '[') return NULL;
 
 	bs_U32 expected_size = bs_calculateJsonObjectArraySize(json, token, size);
-	void* buffer = bs_alloc(expected_size);
+	void* buffer = bs_allocWith(json->allocator, expected_size);
 	bs_U8* destination = buffer;
 
 	int offset = 0;
@@ -653,26 +911,51 @@ void bs_dumpTokens(bs_Json* json) {
 }
 
 bs_Json bs_json(const char* raw) {
+	return bs_jsonWith(raw, NULL);
+}
+
+// raw is const, so the lexer gets a copy it can terminate tokens in and raw stays intact
+static bs_Json bs_lexJsonCopy(char* raw, int raw_len, bs_Allocator* allocator) {
 	bs_Json json = { 0 };
+	json.allocator = allocator;
 	json.raw = raw;
-	json.raw_len = strlen(raw);
+	json.raw_len = raw_len;
+
+	char* token_data = bs_allocWith(allocator, raw_len + 1);
+	memcpy(token_data, raw, raw_len);
+	token_data[raw_len] = '\0';
 
-	bs_lexJson(&json);
+	bs_lexJson(&json, token_data, raw_len);
 	//bs_dumpTokens(&json);
 
 	return json;
 }
 
-bs_Json bs_jsonFile(const char* path) {
+bs_Json bs_jsonWith(const char* raw, bs_Allocator* allocator) {
+	return bs_lexJsonCopy((char*)raw, strlen(raw), allocator);
+}
+
+bs_Json bs_jsonInPlace(char* raw, int raw_len, bs_Allocator* allocator) {
 	bs_Json json = { 0 };
-	json.raw = bs_loadFile(path, &json.raw_len);
+	json.allocator = allocator;
 
-	bs_lexJson(&json);
+	bs_lexJson(&json, raw, raw_len);
 	//bs_dumpTokens(&json);
 
 	return json;
 }
 
+bs_Json bs_jsonFile(const char* path) {
+	return bs_jsonFileWith(path, NULL);
+}
+
+// the loaded file is owned by the json, so it's lexed in place
+bs_Json bs_jsonFileWith(const char* path, bs_Allocator* allocator) {
+	int raw_len = 0;
+	char* raw = bs_loadFile(path, &raw_len);
+	return bs_jsonInPlace(raw, raw_len, allocator);
+}
+
 void bs_freeJson(bs_Json* json) {
 	//json->raw = bs_free(json->raw);
 	//json->tokens = bs_free(json->tokens);
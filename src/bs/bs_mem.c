@@ -1,6 +1,8 @@
 #include <bs_core.h>
 #include <bs_math.h>
 #include <bs_ini.h>
+#include <bs_mem.h>
+#include <bs_pack.h>
 
 #include <stddef.h>
 #include <stdio.h>
@@ -8,6 +10,15 @@
 #include <string.h>
 #include <stdint.h>
 
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
 void* bs_memmem(const void *haystack, bs_U32 haystack_len, 
     const void * const needle, const bs_U32 needle_len)
 {
@@ -33,21 +44,36 @@ bs_JsonString bs_string(const char* str) {
     return string;
 }
 
+// - heap -
+static bs_AllocStats heap_stats = { 0 };
+
+// allocations can come from job threads
+#ifdef _WIN32
+static void bs_count(bs_U64* counter, bs_U64 add) {
+    InterlockedExchangeAdd64((volatile LONG64*)counter, add);
+}
+#else
+static void bs_count(bs_U64* counter, bs_U64 add) {
+    __atomic_add_fetch(counter, add, __ATOMIC_RELAXED);
+}
+#endif
+
 void* bs_free(void* p) {
+    if (p != NULL) {
+        bs_count(&heap_stats.num_frees, 1);
+    }
+
     free(p);
     return NULL;
 }
 
-void* bs_alloc(bs_U32 size) {
-    void* p = malloc(size);
+static void* bs_heapRealloc(void* p, bs_U64 size) {
     if (p == NULL) {
-        bs_throw("malloc returned null");
+        bs_count(&heap_stats.num_allocs, 1);
     }
 
-    return p;
-}
+    bs_count(&heap_stats.total_bytes, size);
 
-void* bs_realloc(void* p, bs_U32 size) {
     p = realloc(p, size);
     if (p == NULL) {
         bs_throw("realloc returned null");
@@ -56,24 +82,337 @@ void* bs_realloc(void* p, bs_U32 size) {
     return p;
 }
 
+void* bs_alloc(bs_U32 size) {
+    return bs_heapRealloc(NULL, size);
+}
+
+void* bs_realloc(void* p, bs_U32 size) {
+    return bs_heapRealloc(p, size);
+}
+
+bs_AllocStats bs_heapStats() {
+    return heap_stats;
+}
+
+static void* bs_heapFn(bs_Allocator* allocator, void* p, bs_U64 old_size, bs_U64 new_size) {
+    if (new_size == 0) {
+        return bs_free(p);
+    }
+
+    return bs_heapRealloc(p, new_size);
+}
+
+static bs_Allocator heap_allocator = { bs_heapFn };
+
+bs_Allocator* bs_heapAllocator() {
+    return &heap_allocator;
+}
+
+void* bs_allocWith(bs_Allocator* allocator, bs_U64 size) {
+    return bs_reallocWith(allocator, NULL, 0, size);
+}
+
+void* bs_reallocWith(bs_Allocator* allocator, void* p, bs_U64 old_size, bs_U64 new_size) {
+    if (allocator == NULL) {
+        allocator = &heap_allocator;
+    }
+
+    return allocator->fn(allocator, p, old_size, new_size);
+}
+
+void bs_freeWith(bs_Allocator* allocator, void* p, bs_U64 size) {
+    if (p != NULL) {
+        bs_reallocWith(allocator, p, size, 0);
+    }
+}
+
+// - arena -
+static void bs_arenaUsed(bs_Arena* arena, bs_U64 prev_used, bs_U64 used) {
+    bs_AllocStats* stats = &arena->allocator.stats;
+    stats->used_bytes = stats->used_bytes - prev_used + used;
+    if (stats->used_bytes > stats->peak_bytes) stats->peak_bytes = stats->used_bytes;
+}
+
+static bs_ArenaBlock* bs_arenaBlock(bs_Arena* arena, bs_U64 size) {
+    bs_U64 block_size = arena->block_size != 0 ? arena->block_size : BS_ARENA_BLOCK_SIZE;
+    if (size > block_size) {
+        block_size = size;
+    }
+
+    bs_ArenaBlock* block = bs_heapRealloc(NULL, sizeof(bs_ArenaBlock) + block_size);
+    block->prev = arena->block;
+    block->size = block_size;
+    block->used = 0;
+
+    arena->block = block;
+    return block;
+}
+
+static void* bs_arenaFn(bs_Allocator* allocator, void* p, bs_U64 old_size, bs_U64 new_size) {
+    bs_Arena* arena = (bs_Arena*)allocator;
+    bs_ArenaBlock* block = arena->block;
+    bool latest = p != NULL && p == arena->last;
+
+    if (new_size == 0) {
+        allocator->stats.num_frees++;
+
+        if (latest) {
+            bs_U64 used = (bs_U8*)p - (bs_U8*)(block + 1);
+            bs_arenaUsed(arena, block->used, used);
+            block->used = used;
+            arena->last = NULL;
+        }
+
+        return NULL;
+    }
+
+    if (latest && (bs_U8*)p - (bs_U8*)(block + 1) + new_size <= block->size) {
+        bs_U64 used = (bs_U8*)p - (bs_U8*)(block + 1) + new_size;
+        bs_arenaUsed(arena, block->used, used);
+        block->used = used;
+        return p;
+    }
+
+    void* result = bs_arenaAlloc(arena, new_size, 16);
+    if (p != NULL) {
+        memcpy(result, p, old_size < new_size ? old_size : new_size);
+    }
+
+    return result;
+}
+
+bs_Arena bs_arena(bs_U64 block_size) {
+    bs_Arena arena = { 0 };
+    arena.allocator.fn = bs_arenaFn;
+    arena.block_size = block_size;
+    return arena;
+}
+
+void* bs_arenaAlloc(bs_Arena* arena, bs_U64 size, bs_U64 alignment) {
+    bs_ArenaBlock* block = arena->block;
+    uintptr_t at = 0;
+
+    if (block != NULL) {
+        uintptr_t base = (uintptr_t)(block + 1);
+        at = (base + block->used + alignment - 1) & ~(uintptr_t)(alignment - 1);
+
+        if (at + size > base + block->size) {
+            block = NULL;
+        }
+    }
+
+    // padded so the aligned allocation always fits
+    if (block == NULL) {
+        block = bs_arenaBlock(arena, size + alignment);
+        at = ((uintptr_t)(block + 1) + alignment - 1) & ~(uintptr_t)(alignment - 1);
+    }
+
+    bs_U64 used = at + size - (uintptr_t)(block + 1);
+    bs_arenaUsed(arena, block->used, used);
+    block->used = used;
+
+    arena->allocator.stats.num_allocs++;
+    arena->allocator.stats.total_bytes += size;
+    arena->last = (bs_U8*)at;
+    return (void*)at;
+}
+
+bs_ArenaMark bs_arenaMark(bs_Arena* arena) {
+    bs_ArenaMark mark = { 0 };
+    mark.block = arena->block;
+    mark.used = arena->block != NULL ? arena->block->used : 0;
+    return mark;
+}
+
+void bs_arenaRewind(bs_Arena* arena, bs_ArenaMark mark) {
+    while (arena->block != mark.block) {
+        bs_ArenaBlock* block = arena->block;
+        bs_arenaUsed(arena, block->used, 0);
+
+        arena->block = block->prev;
+        bs_free(block);
+    }
+
+    if (arena->block != NULL) {
+        bs_arenaUsed(arena, arena->block->used, mark.used);
+        arena->block->used = mark.used;
+    }
+
+    arena->last = NULL;
+}
+
+void bs_arenaReset(bs_Arena* arena) {
+    if (arena->block == NULL) {
+        return;
+    }
+
+    if (arena->block->prev == NULL) {
+        arena->block->used = 0;
+    } else {
+        bs_U64 total = 0;
+        for (bs_ArenaBlock* block = arena->block; block != NULL; block = block->prev) {
+            total += block->size;
+        }
+
+        bs_freeArena(arena);
+        bs_arenaBlock(arena, total);
+    }
+
+    arena->allocator.stats.used_bytes = 0;
+    arena->last = NULL;
+}
+
+void bs_freeArena(bs_Arena* arena) {
+    while (arena->block != NULL) {
+        bs_ArenaBlock* block = arena->block;
+        arena->block = block->prev;
+        bs_free(block);
+    }
+
+    arena->allocator.stats.used_bytes = 0;
+    arena->last = NULL;
+}
+
+static bs_Arena frame_arena = { 0 };
+
+bs_Arena* bs_frameArena() {
+    if (frame_arena.allocator.fn == NULL) {
+        frame_arena = bs_arena(BS_ARENA_BLOCK_SIZE);
+    }
+
+    return &frame_arena;
+}
+
+void* bs_frameAlloc(bs_U64 size) {
+    return bs_arenaAlloc(bs_frameArena(), size, 16);
+}
+
+// - pool -
+// chunks start with their link, padded so units stay 16 byte aligned
+#define BS_POOL_CHUNK_HEADER 16
+
+static void* bs_poolFn(bs_Allocator* allocator, void* p, bs_U64 old_size, bs_U64 new_size) {
+    bs_Pool* pool = (bs_Pool*)allocator;
+
+    if (new_size > pool->unit_size) {
+        bs_throw("Pool allocation larger than its unit size");
+    }
+
+    if (new_size == 0) {
+        if (p != NULL) bs_poolFree(pool, p);
+        return NULL;
+    }
+
+    return p != NULL ? p : bs_poolAlloc(pool);
+}
+
+bs_Pool bs_pool(bs_U32 unit_size, bs_U32 units_per_chunk) {
+    bs_Pool pool = { 0 };
+    pool.allocator.fn = bs_poolFn;
+    pool.unit_size = ((unit_size > sizeof(void*) ? unit_size : sizeof(void*)) + 15) & ~15;
+    pool.units_per_chunk = units_per_chunk > 0 ? units_per_chunk : 1;
+    return pool;
+}
+
+void* bs_poolAlloc(bs_Pool* pool) {
+    if (pool->free_units == NULL) {
+        bs_U8* chunk = bs_heapRealloc(NULL, BS_POOL_CHUNK_HEADER + (bs_U64)pool->unit_size * pool->units_per_chunk);
+        *(void**)chunk = pool->chunks;
+        pool->chunks = chunk;
+
+        // linked back to front so units are handed out in address order
+        for (bs_U32 i = pool->units_per_chunk; i > 0; i--) {
+            bs_U8* unit = chunk + BS_POOL_CHUNK_HEADER + (bs_U64)(i - 1) * pool->unit_size;
+            *(void**)unit = pool->free_units;
+            pool->free_units = unit;
+        }
+    }
+
+    void* unit = pool->free_units;
+    pool->free_units = *(void**)unit;
+
+    bs_AllocStats* stats = &pool->allocator.stats;
+    stats->num_allocs++;
+    stats->total_bytes += pool->unit_size;
+    stats->used_bytes += pool->unit_size;
+    if (stats->used_bytes > stats->peak_bytes) stats->peak_bytes = stats->used_bytes;
+    return unit;
+}
+
+void bs_poolFree(bs_Pool* pool, void* p) {
+    *(void**)p = pool->free_units;
+    pool->free_units = p;
+
+    pool->allocator.stats.num_frees++;
+    pool->allocator.stats.used_bytes -= pool->unit_size;
+}
+
+void bs_freePool(bs_Pool* pool) {
+    while (pool->chunks != NULL) {
+        void* chunk = pool->chunks;
+        pool->chunks = *(void**)chunk;
+        bs_free(chunk);
+    }
+
+    pool->free_units = NULL;
+    pool->allocator.stats.used_bytes = 0;
+}
+
+// - buffer -
+
 void* bs_bufferData(bs_Buffer* buf, bs_U32 offset) {
     return ((uint8_t*)buf->data) + offset * buf->unit_size;
 }
 
 void bs_bufferResizeCheck(bs_Buffer* buf, bs_U32 num_units) {
-    if ((buf->num_units + num_units) < buf->capacity) {
+    bs_U64 required = (bs_U64)buf->num_units + num_units;
+    if (required <= buf->capacity) {
+        return;
+    }
+
+    if (buf->max_units != 0 && required > buf->max_units) {
+        bs_throw("Buffer would grow past its max_units");
+    }
+
+    // grows by half its capacity so n appends copy O(n) units in total, increment is the smallest step
+    bs_U64 capacity = buf->capacity + (buf->capacity / 2 > buf->increment ? buf->capacity / 2 : buf->increment);
+    if (capacity < required) capacity = required;
+    if (buf->max_units != 0 && capacity > buf->max_units) capacity = buf->max_units;
+    if (capacity > UINT32_MAX) capacity = UINT32_MAX;
+
+    bs_bufferReserve(buf, capacity);
+}
+
+void bs_bufferReserve(bs_Buffer* buf, bs_U32 capacity) {
+    if (capacity <= buf->capacity) {
         return;
     }
 
-    if (buf->max_units != 0 && num_units >= buf->max_units) {
-        return; // todo log, or not?
+    if (buf->max_units != 0 && capacity > buf->max_units) {
+        bs_throw("Buffer reserved past its max_units");
     }
 
     bs_U32 prev_capacity = buf->capacity;
-    buf->capacity += bs_max(num_units, buf->increment);
-    buf->data = realloc(buf->data, buf->capacity * buf->unit_size);
+    buf->data = bs_reallocWith(buf->allocator, buf->data, (bs_U64)prev_capacity * buf->unit_size, (bs_U64)capacity * buf->unit_size);
+    buf->capacity = capacity;
 
-    memset(bs_bufferData(buf, prev_capacity), 0, (buf->capacity - prev_capacity) * buf->unit_size);
+    if ((buf->flags & BS_BUFFER_NO_ZERO_FILL) == 0) {
+        memset(bs_bufferData(buf, prev_capacity), 0, (bs_U64)(capacity - prev_capacity) * buf->unit_size);
+    }
+}
+
+void bs_bufferShrink(bs_Buffer* buf) {
+    if (buf->capacity == buf->num_units) {
+        return;
+    }
+
+    if (buf->num_units == 0) {
+        bs_freeBuffer(buf);
+        return;
+    }
+
+    buf->data = bs_reallocWith(buf->allocator, buf->data, (bs_U64)buf->capacity * buf->unit_size, (bs_U64)buf->num_units * buf->unit_size);
+    buf->capacity = buf->num_units;
 }
 
 void* bs_bufferAppend(bs_Buffer* buf, void* data) {
@@ -99,8 +438,13 @@ void bs_bufferAppendRange(bs_Buffer* buf, void* data, size_t num_units) {
 }
 
 bs_Buffer bs_buffer(bs_U32 unit_size, bs_U32 increment, bs_U32 pre_alloc, bs_U32 max_units) {
+    return bs_bufferWith(NULL, unit_size, increment, pre_alloc, max_units);
+}
+
+bs_Buffer bs_bufferWith(bs_Allocator* allocator, bs_U32 unit_size, bs_U32 increment, bs_U32 pre_alloc, bs_U32 max_units) {
     bs_Buffer buf = { 0 };
 
+    buf.allocator = allocator;
     buf.unit_size = unit_size;
     buf.increment = increment;
     buf.max_units = max_units;
@@ -112,6 +456,14 @@ bs_Buffer bs_buffer(bs_U32 unit_size, bs_U32 increment, bs_U32 pre_alloc, bs_U32
     return buf;
 }
 
+void bs_freeBuffer(bs_Buffer* buf) {
+    bs_freeWith(buf->allocator, buf->data, buf->capacity * buf->unit_size);
+
+    buf->data = NULL;
+    buf->num_units = 0;
+    buf->capacity = 0;
+}
+
 bs_Buffer bs_singleUnitBuffer(void* data, bs_U32 unit_size) {
     bs_Buffer buf = { 0 };
 
@@ -123,6 +475,19 @@ bs_Buffer bs_singleUnitBuffer(void* data, bs_U32 unit_size) {
     return buf;
 }
 
+// FNV-1a
+bs_U64 bs_hash(const void* data, bs_U64 size) {
+    const bs_U8* bytes = data;
+    bs_U64 hash = 0xcbf29ce484222325ull;
+
+    for (bs_U64 i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+
+    return hash;
+}
+
 bs_U8 bs_memU8(void *data, bs_U32 offset) {
     return *((bs_U8*)data + offset);
 }
@@ -171,12 +536,132 @@ char* bs_replaceFirstSubstring(const char* str, const char* old_str, const char*
     return result;
 }
 
+#ifdef _WIN32
+bs_MappedFile bs_mapFile(const char* path, bs_U32 hints) {
+    bs_MappedFile file = { 0 };
+
+    // windows takes access pattern hints when the file is opened rather than per mapping
+    DWORD flags = FILE_ATTRIBUTE_NORMAL;
+    if (hints & BS_MAP_SEQUENTIAL) flags |= FILE_FLAG_SEQUENTIAL_SCAN;
+    if (hints & BS_MAP_RANDOM) flags |= FILE_FLAG_RANDOM_ACCESS;
+
+    HANDLE handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, flags, NULL);
+    if (handle == INVALID_HANDLE_VALUE) {
+        bs_throw("Failed to open file for mapping");
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(handle, &size)) {
+        CloseHandle(handle);
+        bs_throw("Failed to get the size of a mapped file");
+    }
+
+    file.size = size.QuadPart;
+    if (file.size == 0) {
+        CloseHandle(handle);
+        return file;
+    }
+
+    // the view keeps the mapping and the file open
+    HANDLE mapping = CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(handle);
+    if (mapping == NULL) {
+        bs_throw("Failed to create file mapping");
+    }
+
+    file.data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (file.data == NULL) {
+        bs_throw("Failed to map file");
+    }
+
+    if (hints & BS_MAP_WILLNEED) {
+        WIN32_MEMORY_RANGE_ENTRY range = { (void*)file.data, file.size };
+        PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+    }
+
+    return file;
+}
+
+void bs_unmapFile(bs_MappedFile* file) {
+    if (file->source == BS_FILE_HEAP) {
+        bs_free((void*)file->data);
+    } else if (file->source == BS_FILE_MAPPED && file->data != NULL) {
+        UnmapViewOfFile(file->data);
+    }
+
+    file->data = NULL;
+    file->size = 0;
+}
+#else
+bs_MappedFile bs_mapFile(const char* path, bs_U32 hints) {
+    bs_MappedFile file = { 0 };
+
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        bs_throw("Failed to open file for mapping");
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        bs_throw("Failed to get the size of a mapped file");
+    }
+
+    file.size = st.st_size;
+    if (file.size == 0) {
+        close(fd);
+        return file;
+    }
+
+    // the mapping keeps the file open
+    void* data = mmap(NULL, file.size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        bs_throw("Failed to map file");
+    }
+
+    if (hints & BS_MAP_SEQUENTIAL) madvise(data, file.size, MADV_SEQUENTIAL);
+    if (hints & BS_MAP_RANDOM) madvise(data, file.size, MADV_RANDOM);
+    if (hints & BS_MAP_WILLNEED) madvise(data, file.size, MADV_WILLNEED);
+
+    file.data = data;
+    return file;
+}
+
+void bs_unmapFile(bs_MappedFile* file) {
+    if (file->source == BS_FILE_HEAP) {
+        bs_free((void*)file->data);
+    } else if (file->source == BS_FILE_MAPPED && file->data != NULL) {
+        munmap((void*)file->data, file->size);
+    }
+
+    file->data = NULL;
+    file->size = 0;
+}
+#endif
+
 char* bs_loadFile(const char* path, int* content_len) {
     if (path == NULL) {
         bs_throw("File \"%s\" not found");
         return NULL;
     }
 
+    // copied so the result is null terminated and owned like a loose file's
+    bs_MappedFile packed;
+    if (bs_packFile(path, &packed)) {
+        char* buffer = bs_allocWith(NULL, packed.size + 1);
+        if (packed.size > 0) {
+            memcpy(buffer, packed.data, packed.size);
+        }
+
+        buffer[packed.size] = '\0';
+        *content_len = packed.size + 1;
+
+        bs_unmapFile(&packed);
+        return buffer;
+    }
+
     long length = 0;
     char* buffer = 0;
     FILE* f = fopen (path, "rb");
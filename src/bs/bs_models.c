@@ -7,6 +7,7 @@
 #include <stdint.h>
 
 #include <bs_mem.h>
+#include <bs_pack.h>
 #include <bs_core.h>
 #include <bs_math.h>
 #include <bs_models.h>
@@ -457,7 +458,6 @@ void bs_loadAnimation(bs_Gltf* gltf, bs_Model* model, bs_Json* animation_json) {
     }
 
     bs_bufferAppend(&animation_buf, &animation);
-    free(channels);
 }
 
 void bs_loadArmature(bs_Gltf* gltf, bs_Json* skin, bs_Armature* armature) {
@@ -541,7 +541,9 @@ bs_Model bs_model(const char* directory, const char* file_name) {
     int len = 0;
     char* raw = bs_loadFile(model_path, &len);
 
-    bs_Json json = bs_json(raw);
+    // tokens and arrays of the gltf only live through the load
+    bs_Arena scratch = bs_arena(0);
+    bs_Json json = bs_jsonInPlace(raw, len, &scratch.allocator);
     bs_Gltf gltf = { 0 };
     gltf.meshes = bs_jsonField(&json, "meshes").as_array;
     gltf.skins = bs_jsonField(&json, "skins").as_array;
@@ -555,12 +557,18 @@ bs_Model bs_model(const char* directory, const char* file_name) {
         bs_callErrorf(BS_ERROR_MODEL_GLTF_BUFFER_SIZE, 2, "Invalid buffer size (%d)", gltf.buffers.size);
     }
 
-    int sz = 0;
     const char buffer_path[MAX_PATH];
     const char* uri = bs_jsonField(gltf.buffers.as_objects, "uri").as_string.value;
     gltf.buffer_size = bs_jsonField(gltf.buffers.as_objects, "byteLength").as_int;
     sprintf(buffer_path, "%s/%s", directory, uri);
-    gltf.buffer = bs_loadFile(buffer_path, &sz);
+
+    // accessors are copied out of the mapping, so the buffer is never read into the heap as a whole
+    bs_MappedFile buffer_file = bs_mapAsset(buffer_path, BS_MAP_SEQUENTIAL);
+    gltf.buffer = (const char*)buffer_file.data;
+
+    if (buffer_file.size < gltf.buffer_size) {
+        bs_callErrorf(BS_ERROR_MODEL_GLTF_BUFFER_SIZE, 2, "Buffer \"%s\" is smaller than its byteLength", buffer_path);
+    }
 
     model.num_meshes = gltf.meshes.size;
     model.aabb.max = bs_v3s(-FLT_MAX);
@@ -592,6 +600,10 @@ bs_Model bs_model(const char* directory, const char* file_name) {
         bs_loadAnimation(&gltf, &model, gltf.animations.as_objects + i);
     }
 
+    bs_freeArena(&scratch);
+    bs_unmapFile(&buffer_file);
+    bs_free(raw);
+
     return model;
 }
 
@@ -0,0 +1,185 @@
+#include <bs_types.h>
+#include <bs_ini.h>
+#include <bs_mem.h>
+#include <bs_compress.h>
+#include <bs_pack.h>
+
+#include <string.h>
+
+#define BS_PACK_MAX_NAME 512
+
+typedef struct {
+    bs_MappedFile file;
+    bs_U32 flags;
+
+    const bs_PackHeader* header;
+    const bs_PackEntry* entries;
+    const bs_U32* buckets;
+    const char* names;
+} bs_Pack;
+
+static struct {
+    bs_Pack packs[BS_MAX_PACKS];
+    bs_U32 num_packs;
+} packs = { 0 };
+
+// every offset and size is checked once here, lookups trust them afterwards
+static bool bs_validPack(bs_Pack* pack) {
+    bs_U64 size = pack->file.size;
+    if(size < sizeof(bs_PackHeader)) return false;
+
+    const bs_PackHeader* header = (const bs_PackHeader*)pack->file.data;
+    if(header->magic != BS_PACK_MAGIC || header->version != BS_PACK_VERSION) return false;
+    if(header->num_buckets == 0 || (header->num_buckets & (header->num_buckets - 1)) != 0) return false;
+    if(header->num_buckets < header->num_entries) return false;
+
+    if(header->entries_offset % 8 != 0 || header->buckets_offset % 4 != 0) return false;
+    if(header->entries_offset > size || (size - header->entries_offset) / sizeof(bs_PackEntry) < header->num_entries) return false;
+    if(header->buckets_offset > size || (size - header->buckets_offset) / sizeof(bs_U32) < header->num_buckets) return false;
+    if(header->names_offset > size || size - header->names_offset < header->names_size) return false;
+
+    pack->header = header;
+    pack->entries = (const bs_PackEntry*)(pack->file.data + header->entries_offset);
+    pack->buckets = (const bs_U32*)(pack->file.data + header->buckets_offset);
+    pack->names = (const char*)(pack->file.data + header->names_offset);
+
+    for(bs_U32 i = 0; i < header->num_entries; i++) {
+        const bs_PackEntry* entry = pack->entries + i;
+        if(entry->offset > size || size - entry->offset < entry->size) return false;
+        if(entry->name_offset > header->names_size || header->names_size - entry->name_offset <= entry->name_len) return false;
+        if(entry->compression != BS_PACK_RAW && entry->compression != BS_PACK_LZ4) return false;
+        if(entry->compression == BS_PACK_RAW && entry->size != entry->raw_size) return false;
+    }
+
+    for(bs_U32 i = 0; i < header->num_buckets; i++) {
+        if(pack->buckets[i] != BS_PACK_EMPTY_BUCKET && pack->buckets[i] >= header->num_entries) return false;
+    }
+
+    return true;
+}
+
+void bs_mountPack(const char* path, bs_U32 flags) {
+    if(packs.num_packs == BS_MAX_PACKS) {
+        bs_throw("More than BS_MAX_PACKS packs mounted");
+    }
+
+    bs_Pack* pack = packs.packs + packs.num_packs;
+    memset(pack, 0, sizeof(bs_Pack));
+    pack->file = bs_mapFile(path, 0);
+    pack->flags = flags;
+
+    if(!bs_validPack(pack)) {
+        bs_unmapFile(&pack->file);
+        bs_throw("Not a pack or its tables are corrupt");
+    }
+
+    packs.num_packs++;
+}
+
+void bs_unmountPacks() {
+    for(bs_U32 i = 0; i < packs.num_packs; i++) {
+        bs_unmapFile(&packs.packs[i].file);
+    }
+
+    packs.num_packs = 0;
+}
+
+static const bs_PackEntry* bs_findPackEntry(const bs_Pack* pack, const char* name, bs_U32 len, bs_U64 hash) {
+    bs_U32 mask = pack->header->num_buckets - 1;
+
+    for(bs_U32 i = 0, bucket = hash & mask; i < pack->header->num_buckets; i++, bucket = (bucket + 1) & mask) {
+        bs_U32 index = pack->buckets[bucket];
+        if(index == BS_PACK_EMPTY_BUCKET) {
+            return NULL;
+        }
+
+        const bs_PackEntry* entry = pack->entries + index;
+        if(entry->hash == hash && entry->name_len == len && memcmp(pack->names + entry->name_offset, name, len) == 0) {
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
+// later packs shadow earlier ones
+static const bs_PackEntry* bs_lookupPack(const char* name, const bs_Pack** found) {
+    if(packs.num_packs == 0) {
+        return NULL;
+    }
+
+    if(name[0] == '.' && (name[1] == '/' || name[1] == '\\')) {
+        name += 2;
+    }
+
+    char normalized[BS_PACK_MAX_NAME];
+    bs_U32 len = 0;
+    for(; name[len] != '\0'; len++) {
+        if(len == BS_PACK_MAX_NAME) return NULL;
+        normalized[len] = name[len] == '\\' ? '/' : name[len];
+    }
+
+    bs_U64 hash = bs_hash(normalized, len);
+
+    for(bs_U32 i = packs.num_packs; i-- > 0;) {
+        const bs_Pack* pack = packs.packs + i;
+        const bs_PackEntry* entry = bs_findPackEntry(pack, normalized, len, hash);
+        if(entry != NULL) {
+            *found = pack;
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
+bool bs_inPack(const char* name) {
+    const bs_Pack* pack;
+    return bs_lookupPack(name, &pack) != NULL;
+}
+
+bool bs_packFile(const char* name, bs_MappedFile* file) {
+    const bs_Pack* pack;
+    const bs_PackEntry* entry = bs_lookupPack(name, &pack);
+    if(entry == NULL) {
+        return false;
+    }
+
+    const bs_U8* data = pack->file.data + entry->offset;
+    memset(file, 0, sizeof(bs_MappedFile));
+    file->size = entry->raw_size;
+
+    if(entry->compression == BS_PACK_RAW) {
+        if((pack->flags & BS_PACK_VERIFY) && bs_crc32(0, data, entry->size) != entry->crc) {
+            return false;
+        }
+
+        file->data = entry->size > 0 ? data : NULL;
+        file->source = BS_FILE_PACKED;
+        return true;
+    }
+
+    if(entry->raw_size == 0) {
+        file->source = BS_FILE_PACKED;
+        return true;
+    }
+
+    bs_U8* raw = bs_allocWith(NULL, entry->raw_size);
+    if(!bs_lz4Decompress(data, entry->size, raw, entry->raw_size) || bs_crc32(0, raw, entry->raw_size) != entry->crc) {
+        bs_free(raw);
+        return false;
+    }
+
+    file->data = raw;
+    file->source = BS_FILE_HEAP;
+    return true;
+}
+
+bs_MappedFile bs_mapAsset(const char* path, bs_U32 hints) {
+    bs_MappedFile file;
+    if(bs_packFile(path, &file)) {
+        return file;
+    }
+
+    return bs_mapFile(path, hints);
+}
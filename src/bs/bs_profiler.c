@@ -0,0 +1,324 @@
+#include <bs_types.h>
+#include <bs_ini.h>
+#include <bs_mem.h>
+#include <bs_jobs.h>
+#include <bs_profiler.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include <vulkan.h>
+
+#define BS_NO_SCOPE 0xFFFFFFFF
+// cpu scopes use the job thread index as their trace thread, gpu ones go after every job thread
+#define BS_PROFILER_GPU_TID BS_MAX_JOB_THREADS
+
+typedef struct {
+    const char* name;
+    bs_U32 depth;
+    bs_U32 thread;
+
+    double cpu_begin;
+    double cpu_end;
+} bs_PendingScope;
+
+// scopes of a frame that hasn't finished on the gpu yet, scope i owns queries i * 2 and i * 2 + 1 of the slot.
+// threads recording secondaries reserve scopes atomically, so this can count past BS_PROFILER_MAX_SCOPES
+typedef struct {
+    bs_PendingScope scopes[BS_PROFILER_MAX_SCOPES];
+    volatile bs_I32 num_scopes;
+
+    bs_U64 frame_num;
+    double cpu_begin;
+    double cpu_end;
+
+    bool recorded;
+} bs_PendingFrame;
+
+// open scopes of one job thread
+typedef struct {
+    bs_U32 stack[BS_PROFILER_MAX_DEPTH];
+    bs_U32 depth;
+    // scopes opened past BS_PROFILER_MAX_DEPTH, only counted so their ends match up
+    bs_U32 overflow;
+} bs_ProfileStack;
+
+static struct {
+    bool enabled;
+
+    VkQueryPool pool;
+    // nanoseconds per tick
+    double timestamp_period;
+    bs_U64 timestamp_mask;
+
+    bs_PendingFrame pending[BS_MAX_FRAMES_IN_FLIGHT];
+    bs_PendingFrame* current;
+    bs_U32 slot;
+
+    bs_ProfileStack threads[BS_MAX_JOB_THREADS];
+    // depth of the main thread when jobs were last dispatched, scopes of other threads nest under it
+    bs_U32 job_depth;
+
+    bs_ProfileFrame history[BS_PROFILER_HISTORY];
+    bs_U32 history_head;
+    bs_U32 num_history;
+} profiler = { 0 };
+
+void bs_prepareProfiler() {
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(bs_vkPhysicalDevice(), &properties);
+
+    bs_U32 num_families = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(bs_vkPhysicalDevice(), &num_families, NULL);
+
+    VkQueueFamilyProperties* families = bs_alloc(num_families * sizeof(VkQueueFamilyProperties));
+    vkGetPhysicalDeviceQueueFamilyProperties(bs_vkPhysicalDevice(), &num_families, families);
+
+    bs_U32 valid_bits = families[bs_vkGraphicsFamily()].timestampValidBits;
+    bs_free(families);
+
+    profiler.timestamp_period = properties.limits.timestampPeriod;
+    profiler.timestamp_mask = valid_bits >= 64 ? ~0ull : (1ull << valid_bits) - 1;
+    profiler.enabled = true;
+
+    // no timestamp support on the queue, scopes only measure cpu time
+    if(valid_bits == 0) {
+        return;
+    }
+
+    VkQueryPoolCreateInfo pool_ci = { 0 };
+    pool_ci.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    pool_ci.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    pool_ci.queryCount = bs_framesInFlight() * BS_PROFILER_MAX_SCOPES * 2;
+
+    BS_VK_ERR(vkCreateQueryPool(bs_vkDevice(), &pool_ci, NULL, &profiler.pool), "Failed to create timestamp query pool");
+}
+
+void bs_freeProfiler() {
+    if(profiler.pool != VK_NULL_HANDLE) {
+        vkDestroyQueryPool(bs_vkDevice(), profiler.pool, NULL);
+    }
+
+    memset(&profiler, 0, sizeof(profiler));
+}
+
+static void bs_resolveFrame(bs_U32 slot) {
+    bs_PendingFrame* pending = profiler.pending + slot;
+    bs_ProfileFrame* frame = profiler.history + profiler.history_head;
+
+    profiler.history_head = (profiler.history_head + 1) % BS_PROFILER_HISTORY;
+    if(profiler.num_history < BS_PROFILER_HISTORY) {
+        profiler.num_history++;
+    }
+
+    frame->frame_num = pending->frame_num;
+    frame->cpu_begin = pending->cpu_begin;
+    frame->cpu_time = (pending->cpu_end - pending->cpu_begin) * 1000.0;
+    frame->gpu_time = -1.0;
+    frame->num_scopes = pending->num_scopes < BS_PROFILER_MAX_SCOPES ? pending->num_scopes : BS_PROFILER_MAX_SCOPES;
+
+    // the fence of the slot has been waited on, so the results are available without waiting
+    bs_U64 timestamps[BS_PROFILER_MAX_SCOPES * 2];
+    bool gpu = profiler.pool != VK_NULL_HANDLE && frame->num_scopes != 0 && vkGetQueryPoolResults(
+        bs_vkDevice(), profiler.pool, slot * BS_PROFILER_MAX_SCOPES * 2, frame->num_scopes * 2,
+        sizeof(timestamps), timestamps, sizeof(bs_U64), VK_QUERY_RESULT_64_BIT
+    ) == VK_SUCCESS;
+
+    // secondary command buffers execute after the primary recorded around them, so the first scope isn't always the earliest
+    bs_U64 base = gpu ? timestamps[0] & profiler.timestamp_mask : 0;
+    for(bs_U32 i = 0; gpu && i < frame->num_scopes * 2; i += 2) {
+        bs_U64 begin = timestamps[i] & profiler.timestamp_mask;
+        if(begin < base) base = begin;
+    }
+
+    double ms_per_tick = profiler.timestamp_period / 1000000.0;
+
+    for(bs_U32 i = 0; i < frame->num_scopes; i++) {
+        bs_PendingScope* src = pending->scopes + i;
+        bs_ProfileScope* dst = frame->scopes + i;
+
+        dst->name = src->name;
+        dst->depth = src->depth;
+        dst->thread = src->thread;
+        dst->cpu_start = (src->cpu_begin - pending->cpu_begin) * 1000.0;
+        dst->cpu_time = (src->cpu_end - src->cpu_begin) * 1000.0;
+        dst->gpu_start = -1.0;
+        dst->gpu_time = -1.0;
+
+        if(!gpu) continue;
+
+        bs_U64 begin = timestamps[i * 2] & profiler.timestamp_mask;
+        bs_U64 end = timestamps[i * 2 + 1] & profiler.timestamp_mask;
+
+        dst->gpu_start = ((begin - base) & profiler.timestamp_mask) * ms_per_tick;
+        dst->gpu_time = ((end - begin) & profiler.timestamp_mask) * ms_per_tick;
+
+        if(dst->gpu_start + dst->gpu_time > frame->gpu_time) {
+            frame->gpu_time = dst->gpu_start + dst->gpu_time;
+        }
+    }
+
+    pending->recorded = false;
+}
+
+void bs_profileFrameBegin(void* command_buffer) {
+    if(!profiler.enabled) return;
+
+    bs_U32 slot = bs_frameData()->swapchain_frame;
+    bs_PendingFrame* pending = profiler.pending + slot;
+
+    if(pending->recorded) {
+        bs_resolveFrame(slot);
+    }
+
+    pending->num_scopes = 0;
+    pending->frame_num = bs_frameData()->frame_num;
+    pending->cpu_begin = bs_time();
+
+    profiler.current = pending;
+    profiler.slot = slot;
+    profiler.job_depth = 0;
+    memset(profiler.threads, 0, sizeof(profiler.threads));
+
+    if(profiler.pool != VK_NULL_HANDLE) {
+        vkCmdResetQueryPool(command_buffer, profiler.pool, slot * BS_PROFILER_MAX_SCOPES * 2, BS_PROFILER_MAX_SCOPES * 2);
+    }
+}
+
+void bs_profileFrameEnd() {
+    if(profiler.current == NULL) return;
+
+    // jobs recording into this frame have all finished by now, only the main thread can have scopes left open
+    bs_ProfileStack* main = profiler.threads;
+    while(main->depth > 0 || main->overflow > 0) {
+        bs_profileEnd();
+    }
+
+    profiler.current->cpu_end = bs_time();
+    profiler.current->recorded = true;
+    profiler.current = NULL;
+}
+
+void bs_profileDispatch() {
+    if(profiler.current == NULL) return;
+    profiler.job_depth = profiler.threads[0].depth;
+}
+
+void bs_profileBegin(const char* name) {
+    if(profiler.current == NULL) return;
+
+    bs_U32 thread = bs_jobThreadIndex();
+    bs_ProfileStack* stack = profiler.threads + thread;
+
+    if(stack->depth == BS_PROFILER_MAX_DEPTH) {
+        stack->overflow++;
+        return;
+    }
+
+    bs_PendingFrame* pending = profiler.current;
+    bs_U32 index = bs_atomicAdd(&pending->num_scopes, 1) - 1;
+    if(index >= BS_PROFILER_MAX_SCOPES) {
+        stack->stack[stack->depth++] = BS_NO_SCOPE;
+        return;
+    }
+
+    bs_PendingScope* scope = pending->scopes + index;
+    scope->name = name;
+    scope->depth = stack->depth + (thread != 0 ? profiler.job_depth : 0);
+    scope->thread = thread;
+    scope->cpu_begin = bs_time();
+
+    stack->stack[stack->depth++] = index;
+
+    if(profiler.pool != VK_NULL_HANDLE) {
+        bs_U32 query = (profiler.slot * BS_PROFILER_MAX_SCOPES + index) * 2;
+        vkCmdWriteTimestamp(bs_vkCmdBuffer(), VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, profiler.pool, query);
+    }
+}
+
+void bs_profileEnd() {
+    if(profiler.current == NULL) return;
+
+    bs_ProfileStack* stack = profiler.threads + bs_jobThreadIndex();
+    if(stack->overflow > 0) {
+        stack->overflow--;
+        return;
+    }
+
+    if(stack->depth == 0) {
+        return;
+    }
+
+    bs_U32 index = stack->stack[--stack->depth];
+    if(index == BS_NO_SCOPE) {
+        return;
+    }
+
+    profiler.current->scopes[index].cpu_end = bs_time();
+
+    if(profiler.pool != VK_NULL_HANDLE) {
+        bs_U32 query = (profiler.slot * BS_PROFILER_MAX_SCOPES + index) * 2 + 1;
+        vkCmdWriteTimestamp(bs_vkCmdBuffer(), VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, profiler.pool, query);
+    }
+}
+
+bs_ProfileFrame* bs_profileFrame() {
+    if(profiler.num_history == 0) {
+        return NULL;
+    }
+
+    return profiler.history + (profiler.history_head + BS_PROFILER_HISTORY - 1) % BS_PROFILER_HISTORY;
+}
+
+void bs_printProfile() {
+    bs_ProfileFrame* frame = bs_profileFrame();
+    if(frame == NULL) return;
+
+    printf("frame %llu: cpu %.3f ms, gpu %.3f ms\n", (unsigned long long)frame->frame_num, frame->cpu_time, frame->gpu_time);
+
+    for(bs_U32 i = 0; i < frame->num_scopes; i++) {
+        bs_ProfileScope* scope = frame->scopes + i;
+        int indent = (scope->depth + 1) * 2;
+
+        printf("%*s%-*s cpu %8.3f ms  gpu %8.3f ms\n", indent, "", 32 - indent, scope->name, scope->cpu_time, scope->gpu_time);
+    }
+}
+
+void bs_saveProfileTrace(const char* path) {
+    FILE* file = fopen(path, "w");
+    if(file == NULL) {
+        bs_throw("Failed to open profile trace file");
+        return;
+    }
+
+    fprintf(file, "{\"traceEvents\":[\n");
+    fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":0,\"args\":{\"name\":\"cpu\"}},\n");
+    fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%d,\"args\":{\"name\":\"gpu\"}}", BS_PROFILER_GPU_TID);
+
+    bs_U32 first = (profiler.history_head + BS_PROFILER_HISTORY - profiler.num_history) % BS_PROFILER_HISTORY;
+
+    for(bs_U32 i = 0; i < profiler.num_history; i++) {
+        bs_ProfileFrame* frame = profiler.history + (first + i) % BS_PROFILER_HISTORY;
+
+        // trace timestamps are in microseconds, gpu scopes are placed relative to the start of their frame
+        double frame_us = frame->cpu_begin * 1000000.0;
+
+        fprintf(file, ",\n{\"name\":\"frame %llu\",\"ph\":\"X\",\"pid\":0,\"tid\":0,\"ts\":%.3f,\"dur\":%.3f}",
+            (unsigned long long)frame->frame_num, frame_us, frame->cpu_time * 1000.0);
+
+        for(bs_U32 j = 0; j < frame->num_scopes; j++) {
+            bs_ProfileScope* scope = frame->scopes + j;
+
+            fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                scope->name, scope->thread, frame_us + scope->cpu_start * 1000.0, scope->cpu_time * 1000.0);
+
+            if(scope->gpu_time < 0.0) continue;
+
+            fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                scope->name, BS_PROFILER_GPU_TID, frame_us + scope->gpu_start * 1000.0, scope->gpu_time * 1000.0);
+        }
+    }
+
+    fprintf(file, "\n],\"displayTimeUnit\":\"ms\"}\n");
+    fclose(file);
+}
@@ -1,9 +1,13 @@
 // Basilisk
 #include <bs_mem.h>
+#include <bs_pack.h>
 #include <bs_core.h>
 #include <bs_shaders.h>
 #include <bs_textures.h>
 #include <bs_ini.h>
+#include <bs_jobs.h>
+#include <bs_spirv.h>
+#include <bs_descriptors.h>
 #include <bs_types.h>
 
 // STD
@@ -15,45 +19,47 @@
 
 #include <vulkan.h>
 
-void bs_setVertexAttributes(bs_VertexShader* vs, const char* code, int code_len) {
+// the vertex layout follows the attribute order, the location comes from the shader
+void bs_setVertexAttributes(bs_VertexShader* vs, const bs_ShaderReflection* reflection) {
     struct {
-        char *name;
-        bs_U32 name_len;
         bs_U8 format;
         bs_U8 value;
         uint8_t size;
     } attribs[] = {
-        { "bs_Position", sizeof("bs_Position"), VK_FORMAT_R32G32B32_SFLOAT   , 1, sizeof(bs_vec3) },
-        { "bs_Texture" , sizeof("bs_Texture" ), VK_FORMAT_R32G32_SFLOAT      , 2, sizeof(bs_vec2) },
-        { "bs_Color"   , sizeof("bs_Color"   ), VK_FORMAT_R8G8B8A8_UNORM     , 4, sizeof(bs_RGBA) },
-        { "bs_Normal"  , sizeof("bs_Normal"  ), VK_FORMAT_R32G32B32_SFLOAT   , 8, sizeof(bs_vec3) },
-        { "bs_BoneId"  , sizeof("bs_BoneId"  ), VK_FORMAT_R32G32B32A32_SINT  , 16, sizeof(bs_ivec4) },
-        { "bs_Weight"  , sizeof("bs_Weight"  ), VK_FORMAT_R32G32B32A32_SFLOAT, 32, sizeof(bs_vec4) },
-        { "bs_Entity"  , sizeof("bs_Entity"  ), VK_FORMAT_R32_UINT           , 64, sizeof(bs_U32) },
-        { "bs_Image"   , sizeof("bs_Image"   ), VK_FORMAT_R32_UINT           , 128, sizeof(bs_U32) }
+        { VK_FORMAT_R32G32B32_SFLOAT   , 1, sizeof(bs_vec3) },
+        { VK_FORMAT_R32G32_SFLOAT      , 2, sizeof(bs_vec2) },
+        { VK_FORMAT_R8G8B8A8_UNORM     , 4, sizeof(bs_RGBA) },
+        { VK_FORMAT_R32G32B32_SFLOAT   , 8, sizeof(bs_vec3) },
+        { VK_FORMAT_R32G32B32A32_SINT  , 16, sizeof(bs_ivec4) },
+        { VK_FORMAT_R32G32B32A32_SFLOAT, 32, sizeof(bs_vec4) },
+        { VK_FORMAT_R32_UINT           , 64, sizeof(bs_U32) },
+        { VK_FORMAT_R32_UINT           , 128, sizeof(bs_U32) }
     };   
 
-    for(int i = 0; i < BS_NUM_ATTRIBUTES; i++) {
-        uint8_t *attrib_sizes = (uint8_t *)&vs->attribs;
-        uint8_t *attrib_size = attrib_sizes + i;
-        *attrib_size = 0;
+    for(bs_U32 i = 0; i < reflection->num_inputs; i++) {
+        const bs_ShaderInput* input = reflection->inputs + i;
 
-        if(bs_memmem(code, code_len, attribs[i].name, attribs[i].name_len)) {
-            *attrib_size = attribs[i].size;
-
-            vs->attributes[i].size = attribs[i].size;
-            vs->attributes[i].format = attribs[i].format;
-            vs->attrib_size_bytes += attribs[i].size;
-            vs->attribs |= attribs[i].value;
-            vs->attrib_count++;
+        // stripped shaders have no names, their locations are expected to match bs_AttributeType
+        bs_U32 attribute = input->attribute;
+        if(attribute == BS_NUM_ATTRIBUTES && !input->named && input->location < BS_NUM_ATTRIBUTES) {
+            attribute = input->location;
         }
+
+        if(attribute == BS_NUM_ATTRIBUTES || (vs->attribs & attribs[attribute].value)) continue;
+
+        vs->attributes[attribute].size = attribs[attribute].size;
+        vs->attributes[attribute].format = attribs[attribute].format;
+        vs->attributes[attribute].location = input->location;
+        vs->attrib_size_bytes += attribs[attribute].size;
+        vs->attribs |= attribs[attribute].value;
+        vs->attrib_count++;
     }
 }
 
-static VkShaderModule bs_shaderModule(const char* spirv, int len) {
+static VkShaderModule bs_shaderModule(const char* spirv, bs_U64 size) {
     VkShaderModuleCreateInfo shader_ci = { 0 };
     shader_ci.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    shader_ci.codeSize = len - 1;
+    shader_ci.codeSize = size;
     shader_ci.pCode = spirv;
 
     VkShaderModule module;
@@ -61,31 +67,253 @@ static VkShaderModule bs_shaderModule(const char* spirv, int len) {
     return module;
 }
 
-bs_VertexShader bs_vertexShader(const char *path) {
-    bs_VertexShader vs = { 0 };
+// - registries -
+// chained hash tables, entries are allocated one by one so pointers to them stay valid
+typedef struct bs_RegistryEntry {
+    struct bs_RegistryEntry* next;
+    bs_U64 hash;
+} bs_RegistryEntry;
+
+typedef struct {
+    bs_RegistryEntry** buckets;
+    bs_U32 num_buckets;
+    bs_U32 count;
+} bs_Registry;
+
+static bs_RegistryEntry* bs_registryFirst(bs_Registry* registry, bs_U64 hash) {
+    if(registry->num_buckets == 0) return NULL;
+    return registry->buckets[hash & (registry->num_buckets - 1)];
+}
 
-    int len = 0;
-    const char* spirv = bs_loadFile(path, &len);
-    bs_setVertexAttributes(&vs, spirv, len);
+static void bs_registryInsert(bs_Registry* registry, bs_RegistryEntry* entry) {
+    if(registry->count >= registry->num_buckets) {
+        bs_U32 num_buckets = registry->num_buckets == 0 ? 64 : registry->num_buckets * 2;
+        bs_RegistryEntry** buckets = bs_alloc(num_buckets * sizeof(bs_RegistryEntry*));
+        memset(buckets, 0, num_buckets * sizeof(bs_RegistryEntry*));
+
+        for(bs_U32 i = 0; i < registry->num_buckets; i++) {
+            bs_RegistryEntry* it = registry->buckets[i];
+            while(it != NULL) {
+                bs_RegistryEntry* next = it->next;
+                it->next = buckets[it->hash & (num_buckets - 1)];
+                buckets[it->hash & (num_buckets - 1)] = it;
+                it = next;
+            }
+        }
 
-    vs.module = bs_shaderModule(spirv, len);
+        bs_free(registry->buckets);
+        registry->buckets = buckets;
+        registry->num_buckets = num_buckets;
+    }
 
-    free(spirv);
-    return vs;
+    bs_RegistryEntry** bucket = registry->buckets + (entry->hash & (registry->num_buckets - 1));
+    entry->next = *bucket;
+    *bucket = entry;
+    registry->count++;
+}
+
+static void bs_registryRemove(bs_Registry* registry, bs_RegistryEntry* entry) {
+    bs_RegistryEntry** it = registry->buckets + (entry->hash & (registry->num_buckets - 1));
+    while(*it != entry) {
+        it = &(*it)->next;
+    }
+
+    *it = entry->next;
+    registry->count--;
+}
+
+// - shader modules -
+// modules are shared by every shader loaded from the same path and destroyed once the last one is released
+typedef struct {
+    bs_RegistryEntry link;
+
+    char* path;
+    VkShaderStageFlags stage;
+    VkShaderModule module;
+    bs_U32 refs;
+
+    bs_ShaderReflection reflection;
+    // attributes of vertex shaders so they don't have to be reflected again
+    bs_VertexShader vs;
+} bs_ModuleEntry;
+
+static bs_Registry modules = { 0 };
+static bs_U32 next_module_id = 1;
+
+// compiles of bs_pipelineAsync() that haven't finished yet
+static bs_JobCounter compiles = { 0 };
+static volatile bs_I32 failed_compiles = 0;
+
+static bs_ModuleEntry* bs_loadModule(const char* path, VkShaderStageFlags stage) {
+    bs_U64 hash = bs_hash(path, strlen(path)) ^ stage;
+
+    for(bs_RegistryEntry* it = bs_registryFirst(&modules, hash); it != NULL; it = it->next) {
+        bs_ModuleEntry* entry = (bs_ModuleEntry*)it;
+        if(it->hash == hash && entry->stage == stage && strcmp(entry->path, path) == 0) {
+            entry->refs++;
+            return entry;
+        }
+    }
+
+    bs_ModuleEntry* entry = bs_alloc(sizeof(bs_ModuleEntry));
+    memset(entry, 0, sizeof(bs_ModuleEntry));
+
+    entry->link.hash = hash;
+    entry->path = bs_alloc(strlen(path) + 1);
+    strcpy(entry->path, path);
+    entry->stage = stage;
+    entry->refs = 1;
+
+    // page aligned, which covers the 4 byte alignment vkCreateShaderModule() wants
+    bs_MappedFile spirv = bs_mapAsset(path, BS_MAP_WILLNEED);
+    bs_reflectSpirv(spirv.data, spirv.size, &entry->reflection);
+
+    if(stage == VK_SHADER_STAGE_VERTEX_BIT) {
+        bs_setVertexAttributes(&entry->vs, &entry->reflection);
+    }
+
+    entry->module = bs_shaderModule((const char*)spirv.data, spirv.size);
+    entry->vs.id = next_module_id++;
+    entry->vs.module = entry->module;
+    entry->vs.reflection = &entry->reflection;
+
+    bs_unmapFile(&spirv);
+    bs_registryInsert(&modules, &entry->link);
+    return entry;
+}
+
+static void bs_waitModuleCompiles(VkShaderModule module);
+
+static void bs_releaseModule(VkShaderModule module) {
+    for(bs_U32 i = 0; i < modules.num_buckets; i++) {
+        for(bs_RegistryEntry* it = modules.buckets[i]; it != NULL; it = it->next) {
+            bs_ModuleEntry* entry = (bs_ModuleEntry*)it;
+            if(entry->module != module) continue;
+
+            if(--entry->refs == 0) {
+                // pipelines compiling in the background may still read the module
+                bs_waitModuleCompiles(module);
+
+                bs_registryRemove(&modules, it);
+                vkDestroyShaderModule(bs_vkDevice(), entry->module, NULL);
+                bs_free(entry->path);
+                bs_free(entry);
+            }
+
+            return;
+        }
+    }
+}
+
+bs_VertexShader bs_vertexShader(const char *path) {
+    return bs_loadModule(path, VK_SHADER_STAGE_VERTEX_BIT)->vs;
 }
 
 bs_FragmentShader bs_fragmentShader(const char *path) {
+    bs_ModuleEntry* entry = bs_loadModule(path, VK_SHADER_STAGE_FRAGMENT_BIT);
+
     bs_FragmentShader fs = { 0 };
+    fs.id = entry->vs.id;
+    fs.module = entry->module;
+    fs.reflection = &entry->reflection;
+    return fs;
+}
+
+void bs_releaseVertexShader(bs_VertexShader* vs) {
+    bs_releaseModule(vs->module);
+    vs->module = NULL;
+}
 
-    int len = 0;
-    const char* spirv = bs_loadFile(path, &len);
+void bs_releaseFragmentShader(bs_FragmentShader* fs) {
+    bs_releaseModule(fs->module);
+    fs->module = NULL;
+}
 
-    fs.module = bs_shaderModule(spirv, len);
+// - pipeline cache -
+static VkPipelineCache pipeline_cache = VK_NULL_HANDLE;
 
-    free(spirv);
-    return fs;
+// cache data starts with VkPipelineCacheHeaderVersionOne, data from another driver or gpu is ignored
+static bool bs_validPipelineCache(const bs_U8* data, bs_U64 size) {
+    if(size < 16 + VK_UUID_SIZE) return false;
+
+    bs_U32 header[4];
+    memcpy(header, data, sizeof(header));
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(bs_vkPhysicalDevice(), &properties);
+
+    return
+        header[0] >= 16 + VK_UUID_SIZE &&
+        header[1] == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+        header[2] == properties.vendorID &&
+        header[3] == properties.deviceID &&
+        memcmp(data + 16, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+void bs_preparePipelineCache(const char* path) {
+    bs_U8* data = NULL;
+    bs_U64 size = 0;
+
+    // a missing cache isn't an error, it's written on shutdown
+    FILE* file = path == NULL ? NULL : fopen(path, "rb");
+    if(file != NULL) {
+        fseek(file, 0, SEEK_END);
+        size = ftell(file);
+        fseek(file, 0, SEEK_SET);
+
+        data = bs_alloc(size);
+        if(fread(data, 1, size, file) != size) {
+            size = 0;
+        }
+
+        fclose(file);
+    }
+
+    VkPipelineCacheCreateInfo cache_ci = { 0 };
+    cache_ci.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+
+    if(data != NULL && bs_validPipelineCache(data, size)) {
+        cache_ci.initialDataSize = size;
+        cache_ci.pInitialData = data;
+    }
+
+    BS_VK_ERR(vkCreatePipelineCache(bs_vkDevice(), &cache_ci, NULL, &pipeline_cache), "Failed to create pipeline cache");
+    bs_free(data);
+}
+
+void bs_savePipelineCache(const char* path) {
+    if(pipeline_cache == VK_NULL_HANDLE || path == NULL) return;
+
+    size_t size = 0;
+    BS_VK_ERR(vkGetPipelineCacheData(bs_vkDevice(), pipeline_cache, &size, NULL), "Failed to query pipeline cache size");
+
+    bs_U8* data = bs_alloc(size);
+    BS_VK_ERR(vkGetPipelineCacheData(bs_vkDevice(), pipeline_cache, &size, data), "Failed to read pipeline cache");
+
+    // losing the cache only costs startup time, so failing to write it isn't fatal
+    FILE* file = fopen(path, "wb");
+    if(file != NULL) {
+        fwrite(data, 1, size, file);
+        fclose(file);
+    } else {
+        printf("Failed to write pipeline cache \"%s\"\n", path);
+    }
+
+    bs_free(data);
+}
+
+void bs_freePipelineCache() {
+    if(pipeline_cache == VK_NULL_HANDLE) return;
+
+    vkDestroyPipelineCache(bs_vkDevice(), pipeline_cache, NULL);
+    pipeline_cache = VK_NULL_HANDLE;
 }
 
+void* bs_vkPipelineCache() {
+    return pipeline_cache;
+}
+
+// - pipelines -
 inline VkPipelineShaderStageCreateInfo bs_shaderStage(VkShaderModule module, VkShaderStageFlags flags) {
     VkPipelineShaderStageCreateInfo ci = { 0 };
     ci.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -94,56 +322,245 @@ inline VkPipelineShaderStageCreateInfo bs_shaderStage(VkShaderModule module, VkS
     ci.pName = "main";
     return ci;
 }
-VkVertexInputAttributeDescription attributes[BS_NUM_ATTRIBUTES] = { 0 };
 
-bs_Pipeline bs_pipeline(bs_Renderer* renderer, bs_VertexShader* vs, bs_FragmentShader* fs) {
-    bs_Pipeline pipeline = { 0 };
-    pipeline.vs = vs;
+// - pipeline layouts -
+// shaders with the same bindings and push constants share a layout
+typedef struct {
+    // sorted by set and binding
+    bs_ShaderBinding bindings[BS_MAX_SHADER_BINDINGS];
+    bs_U32 num_bindings;
+
+    bs_U32 push_constant_size;
+    bs_U32 push_constant_stages;
+} bs_LayoutKey;
+
+typedef struct {
+    bs_RegistryEntry link;
+
+    bs_LayoutKey key;
+    VkDescriptorSetLayout set_layouts[BS_MAX_DESCRIPTOR_SETS];
+    bs_U32 num_sets;
+    VkPipelineLayout layout;
+
+    // shader spaces are the first bindings of the key
+    bs_U32 num_spaces;
+    // written by bs_requestSpaceSet() once every space exists
+    void* space_set;
+    // set BS_BINDLESS_SET is the shared bindless layout, owned by bs_descriptors
+    bool bindless;
+} bs_LayoutEntry;
+
+static bs_Registry layouts = { 0 };
+
+static void bs_mergeBindings(bs_LayoutKey* key, const bs_ShaderReflection* reflection) {
+    for(bs_U32 i = 0; i < reflection->num_bindings; i++) {
+        bs_ShaderBinding binding = reflection->bindings[i];
+
+        // shader spaces are ring buffered, every frame reads its own slot through a dynamic offset
+        if(binding.set == BS_SPACE_SET) {
+            if(binding.type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER) binding.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+            else if(binding.type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER) binding.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+            else bs_throw("Only shader spaces can be bound to BS_SPACE_SET");
+        }
 
-    // pipeline
+        bs_U32 at = 0;
+        while(at < key->num_bindings && (key->bindings[at].set < binding.set || (key->bindings[at].set == binding.set && key->bindings[at].binding < binding.binding))) {
+            at++;
+        }
+
+        bs_ShaderBinding* existing = key->bindings + at;
+        if(at < key->num_bindings && existing->set == binding.set && existing->binding == binding.binding) {
+            if(existing->type != binding.type) {
+                bs_throw("Descriptor binding has different types between shader stages");
+            }
+
+            existing->stages |= binding.stages;
+            if(binding.count > existing->count) existing->count = binding.count;
+            continue;
+        }
+
+        if(key->num_bindings == BS_MAX_SHADER_BINDINGS) {
+            bs_throw("Pipeline has more than BS_MAX_SHADER_BINDINGS descriptor bindings");
+        }
+
+        memmove(existing + 1, existing, (key->num_bindings - at) * sizeof(bs_ShaderBinding));
+        *existing = binding;
+        key->num_bindings++;
+    }
+
+    // push constants are visible to every stage so bs_pushConstants() doesn't need to know which ones read them
+    if(reflection->push_constant_size > 0) {
+        key->push_constant_stages = VK_SHADER_STAGE_ALL_GRAPHICS;
+        if(reflection->push_constant_size > key->push_constant_size) key->push_constant_size = reflection->push_constant_size;
+    }
+}
+
+static bs_LayoutEntry* bs_layoutEntry(const bs_ShaderReflection* vs, const bs_ShaderReflection* fs) {
+    bs_LayoutKey key;
+    memset(&key, 0, sizeof(key));
+    bs_mergeBindings(&key, vs);
+    bs_mergeBindings(&key, fs);
+
+    bs_U64 hash = bs_hash(&key, sizeof(key));
+
+    for(bs_RegistryEntry* it = bs_registryFirst(&layouts, hash); it != NULL; it = it->next) {
+        bs_LayoutEntry* entry = (bs_LayoutEntry*)it;
+        if(it->hash == hash && memcmp(&entry->key, &key, sizeof(key)) == 0) {
+            return entry;
+        }
+    }
+
+    bs_LayoutEntry* entry = bs_alloc(sizeof(bs_LayoutEntry));
+    memset(entry, 0, sizeof(bs_LayoutEntry));
+    entry->link.hash = hash;
+    entry->key = key;
+    entry->num_sets = key.num_bindings == 0 ? 0 : key.bindings[key.num_bindings - 1].set + 1;
+
+    // sets without bindings in between get empty layouts
+    for(bs_U32 set = 0, first = 0; set < entry->num_sets; set++) {
+        VkDescriptorSetLayoutBinding bindings[BS_MAX_SHADER_BINDINGS] = { 0 };
+        bs_U32 num_bindings = 0;
+
+        if(set == BS_BINDLESS_SET && first < key.num_bindings && key.bindings[first].set == set) {
+            while(first < key.num_bindings && key.bindings[first].set == set) first++;
+
+            entry->set_layouts[set] = bs_bindlessLayout();
+            entry->bindless = true;
+            continue;
+        }
+
+        for(; first < key.num_bindings && key.bindings[first].set == set; first++) {
+            bs_ShaderBinding* binding = key.bindings + first;
+            bindings[num_bindings].binding = binding->binding;
+            bindings[num_bindings].descriptorType = binding->type;
+            bindings[num_bindings].descriptorCount = binding->count == 0 ? 1 : binding->count;
+            bindings[num_bindings].stageFlags = binding->stages;
+            num_bindings++;
+        }
+
+        VkDescriptorSetLayoutCreateInfo set_layout_ci = { 0 };
+        set_layout_ci.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        set_layout_ci.bindingCount = num_bindings;
+        set_layout_ci.pBindings = bindings;
+        BS_VK_ERR(vkCreateDescriptorSetLayout(bs_vkDevice(), &set_layout_ci, NULL, entry->set_layouts + set), "Failed to create descriptor set layout");
+    }
+
+    VkPushConstantRange push_range = { 0 };
+    push_range.stageFlags = key.push_constant_stages;
+    push_range.size = key.push_constant_size;
+
+    VkPipelineLayoutCreateInfo pipeline_layout_i = { 0 };
+    pipeline_layout_i.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipeline_layout_i.setLayoutCount = entry->num_sets;
+    pipeline_layout_i.pSetLayouts = entry->set_layouts;
+    pipeline_layout_i.pushConstantRangeCount = key.push_constant_size > 0 ? 1 : 0;
+    pipeline_layout_i.pPushConstantRanges = &push_range;
+    BS_VK_ERR(vkCreatePipelineLayout(bs_vkDevice(), &pipeline_layout_i, NULL, &entry->layout), "Failed to create pipeline layout");
+
+    while(entry->num_spaces < key.num_bindings && key.bindings[entry->num_spaces].set == BS_SPACE_SET) {
+        entry->num_spaces++;
+    }
+
+    if(entry->num_spaces > 0) {
+        bs_requestSpaceSet(entry->set_layouts[BS_SPACE_SET], key.bindings, entry->num_spaces, &entry->space_set);
+    }
+
+    bs_registryInsert(&layouts, &entry->link);
+    return entry;
+}
+
+// - pipelines -
+// everything a VkPipeline is built from, compared and hashed bytewise so it's zeroed before being filled
+typedef struct {
+    // module ids are never reused, unlike the handles of released modules
+    bs_U32 vs;
+    bs_U32 fs;
+    bs_U32 attribs;
+    VkRenderPass render_pass;
+
+    VkPrimitiveTopology topology;
+    VkPolygonMode polygon_mode;
+    VkCullModeFlags cull_mode;
+    VkFrontFace front_face;
+    VkBool32 blend;
+} bs_PipelineKey;
+
+#define BS_PIPELINE_COMPILING 0
+#define BS_PIPELINE_READY 1
+#define BS_PIPELINE_FAILED 2
+
+typedef struct {
+    bs_RegistryEntry link;
+
+    bs_PipelineKey key;
+    VkPipeline pipeline;
+    bs_LayoutEntry* layout;
+
+    // written by the compile job, pipeline is only valid once status is BS_PIPELINE_READY
+    volatile bs_I32 status;
+    bs_JobCounter compile;
+
+    // copies for the compile job, the shaders passed to bs_pipelineAsync() don't have to outlive the call
+    bs_VertexShader vs;
+    bs_FragmentShader fs;
+} bs_PipelineEntry;
+
+static bs_Registry pipelines = { 0 };
+
+// only the compiles reading this module, the rest keep going in the background
+static void bs_waitModuleCompiles(VkShaderModule module) {
+    for(bs_U32 i = 0; i < pipelines.num_buckets; i++) {
+        for(bs_RegistryEntry* it = pipelines.buckets[i]; it != NULL; it = it->next) {
+            bs_PipelineEntry* entry = (bs_PipelineEntry*)it;
+            if(entry->vs.module == module || entry->fs.module == module) {
+                bs_waitJobs(&entry->compile);
+            }
+        }
+    }
+}
+
+static bs_PipelineEntry* fallback = NULL;
+
+static VkResult bs_createPipeline(const bs_PipelineKey* key, VkPipelineLayout layout, bs_VertexShader* vs, bs_FragmentShader* fs, VkPipeline* out) {
     VkDynamicState states[] = { 
         VK_DYNAMIC_STATE_VIEWPORT,
         VK_DYNAMIC_STATE_SCISSOR
     };
 
-    VkPipelineLayout layout = VK_NULL_HANDLE;
-    VkPipelineLayoutCreateInfo pipeline_layout_i = { 0 };
-    pipeline_layout_i.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    BS_VK_ERR(vkCreatePipelineLayout(bs_vkDevice(), &pipeline_layout_i, NULL, &layout), "Failed to create pipeline layout");
-
     VkPipelineDynamicStateCreateInfo dynamic_state_i = { 0 };
     dynamic_state_i.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
     dynamic_state_i.dynamicStateCount = sizeof(states) / sizeof(VkDynamicState);
     dynamic_state_i.pDynamicStates = states;
 
     // add attributes
+    VkVertexInputAttributeDescription attributes[BS_NUM_ATTRIBUTES] = { 0 };
     VkVertexInputBindingDescription input_binding = { 0 };
     input_binding.binding = 0;
-    input_binding.stride = pipeline.vs->attrib_size_bytes;
+    input_binding.stride = vs->attrib_size_bytes;
     input_binding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
 
     bs_U32 offset = 0, location = 0;
     for(int i = 0, j = 1; i < BS_NUM_ATTRIBUTES; i++, j *= 2) {
-        if ((pipeline.vs->attribs & j) != j) continue;
+        if ((key->attribs & j) != j) continue;
 
         attributes[location].binding = 0;
-        attributes[location].location = location;
-        attributes[location].format = pipeline.vs->attributes[i].format;
+        attributes[location].location = vs->attributes[i].location;
+        attributes[location].format = vs->attributes[i].format;
         attributes[location].offset = offset;
-        offset += pipeline.vs->attributes[i].size;
+        offset += vs->attributes[i].size;
         location++;
     }
 
     VkPipelineVertexInputStateCreateInfo vertex_ci = { 0 };
     vertex_ci.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
     vertex_ci.vertexBindingDescriptionCount = 1;
-    vertex_ci.vertexAttributeDescriptionCount = pipeline.vs->attrib_count; 
+    vertex_ci.vertexAttributeDescriptionCount = location; 
     vertex_ci.pVertexBindingDescriptions = &input_binding; 
     vertex_ci.pVertexAttributeDescriptions = attributes; 
 
     VkPipelineInputAssemblyStateCreateInfo assembly_ci = { 0 };
     assembly_ci.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-    assembly_ci.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    assembly_ci.topology = key->topology;
 
     VkViewport viewport = { 0 };
     viewport.x = 0.0f;
@@ -166,10 +583,10 @@ bs_Pipeline bs_pipeline(bs_Renderer* renderer, bs_VertexShader* vs, bs_FragmentS
 
     VkPipelineRasterizationStateCreateInfo rasterizer_ci = { 0 };
     rasterizer_ci.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-    rasterizer_ci.polygonMode = VK_POLYGON_MODE_FILL;
+    rasterizer_ci.polygonMode = key->polygon_mode;
     rasterizer_ci.lineWidth = 1.0f;
-    rasterizer_ci.cullMode = VK_CULL_MODE_BACK_BIT;
-    rasterizer_ci.frontFace = VK_FRONT_FACE_CLOCKWISE;
+    rasterizer_ci.cullMode = key->cull_mode;
+    rasterizer_ci.frontFace = key->front_face;
 
     VkPipelineMultisampleStateCreateInfo multisampling_ci = { 0 };
     multisampling_ci.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
@@ -178,15 +595,9 @@ bs_Pipeline bs_pipeline(bs_Renderer* renderer, bs_VertexShader* vs, bs_FragmentS
 
     VkPipelineColorBlendAttachmentState blend_state = { 0 };
     blend_state.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-    blend_state.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
-    blend_state.dstColorBlendFactor = VK_BLEND_FACTOR_ZERO;
-    blend_state.colorBlendOp = VK_BLEND_OP_ADD;
-    blend_state.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
-    blend_state.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
-    blend_state.alphaBlendOp = VK_BLEND_OP_ADD;
-    blend_state.blendEnable = VK_TRUE;
-    blend_state.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
-    blend_state.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+    blend_state.blendEnable = key->blend;
+    blend_state.srcColorBlendFactor = key->blend ? VK_BLEND_FACTOR_SRC_ALPHA : VK_BLEND_FACTOR_ONE;
+    blend_state.dstColorBlendFactor = key->blend ? VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA : VK_BLEND_FACTOR_ZERO;
     blend_state.colorBlendOp = VK_BLEND_OP_ADD;
     blend_state.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
     blend_state.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
@@ -215,14 +626,241 @@ bs_Pipeline bs_pipeline(bs_Renderer* renderer, bs_VertexShader* vs, bs_FragmentS
     pipeline_ci.pColorBlendState = &color_blending_ci;
     pipeline_ci.pDynamicState = &dynamic_state_i;
     pipeline_ci.layout = layout;
-    pipeline_ci.renderPass = renderer->render_pass;
+    pipeline_ci.renderPass = key->render_pass;
     pipeline_ci.subpass = 0;
     pipeline_ci.basePipelineIndex = -1;
 
-    BS_VK_ERR(vkCreateGraphicsPipelines(bs_vkDevice(), VK_NULL_HANDLE, 1, &pipeline_ci, NULL, (VkPipeline*)&pipeline.state), "Failed to create graphics pipeline");
+    // the pipeline cache is internally synchronized, so compile jobs can share it
+    return vkCreateGraphicsPipelines(bs_vkDevice(), pipeline_cache, 1, &pipeline_ci, NULL, out);
+}
+
+static void bs_compileJob(void* param, bs_U32 index) {
+    bs_PipelineEntry* entry = param;
 
-    vkDestroyShaderModule(bs_vkDevice(), vs->module, NULL);
-    vkDestroyShaderModule(bs_vkDevice(), fs->module, NULL);
+    if(bs_createPipeline(&entry->key, entry->layout->layout, &entry->vs, &entry->fs, &entry->pipeline) == VK_SUCCESS) {
+        bs_atomicAdd(&entry->status, BS_PIPELINE_READY);
+    } else {
+        entry->pipeline = VK_NULL_HANDLE;
+        bs_atomicAdd(&failed_compiles, 1);
+        bs_atomicAdd(&entry->status, BS_PIPELINE_FAILED);
+    }
+
+    bs_atomicAdd(&compiles.pending, -1);
+}
+
+// finds or creates the registry entry, new entries are compiled right away or queued as a job
+static bs_PipelineEntry* bs_pipelineEntry(bs_Renderer* renderer, bs_VertexShader* vs, bs_FragmentShader* fs, bool async) {
+    bs_PipelineKey key;
+    memset(&key, 0, sizeof(key));
+    key.vs = vs->id;
+    key.fs = fs->id;
+    key.attribs = vs->attribs;
+    key.render_pass = renderer->render_pass;
+    key.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    key.polygon_mode = VK_POLYGON_MODE_FILL;
+    key.cull_mode = VK_CULL_MODE_BACK_BIT;
+    key.front_face = VK_FRONT_FACE_CLOCKWISE;
+    key.blend = VK_TRUE;
+
+    bs_U64 hash = bs_hash(&key, sizeof(key));
+
+    for(bs_RegistryEntry* it = bs_registryFirst(&pipelines, hash); it != NULL; it = it->next) {
+        bs_PipelineEntry* entry = (bs_PipelineEntry*)it;
+        if(it->hash == hash && memcmp(&entry->key, &key, sizeof(key)) == 0) {
+            // a blocking request for a pipeline that is still compiling in the background
+            if(!async) {
+                bs_waitJobs(&entry->compile);
+            }
+
+            return entry;
+        }
+    }
+
+    bs_PipelineEntry* entry = bs_alloc(sizeof(bs_PipelineEntry));
+    memset(entry, 0, sizeof(bs_PipelineEntry));
+    entry->link.hash = hash;
+    entry->key = key;
+    // created up front so compile jobs never touch the layout registry
+    entry->layout = bs_layoutEntry(vs->reflection, fs->reflection);
+    entry->vs = *vs;
+    entry->fs = *fs;
+
+    bs_registryInsert(&pipelines, &entry->link);
+
+    if(async) {
+        bs_atomicAdd(&compiles.pending, 1);
+        bs_pushBackgroundJob(bs_compileJob, entry, 0, &entry->compile);
+    } else {
+        BS_VK_ERR(bs_createPipeline(&key, entry->layout->layout, vs, fs, &entry->pipeline), "Failed to create graphics pipeline");
+        entry->status = BS_PIPELINE_READY;
+    }
+
+    return entry;
+}
+
+bs_Pipeline bs_pipeline(bs_Renderer* renderer, bs_VertexShader* vs, bs_FragmentShader* fs) {
+    bs_PipelineEntry* entry = bs_pipelineEntry(renderer, vs, fs, false);
+
+    if(entry->status == BS_PIPELINE_FAILED) {
+        bs_throw("Failed to create graphics pipeline");
+    }
+
+    bs_Pipeline pipeline = { 0 };
+    pipeline.vs = vs;
+    pipeline.state = entry->pipeline;
+    pipeline.entry = entry;
+    return pipeline;
+}
+
+bs_Pipeline bs_pipelineAsync(bs_Renderer* renderer, bs_VertexShader* vs, bs_FragmentShader* fs) {
+    bs_PipelineEntry* entry = bs_pipelineEntry(renderer, vs, fs, true);
+
+    bs_Pipeline pipeline = { 0 };
+    pipeline.vs = vs;
+    pipeline.entry = entry;
+
+    if(bs_atomicLoad(&entry->status) == BS_PIPELINE_READY) {
+        pipeline.state = entry->pipeline;
+    }
 
     return pipeline;
-}
\ No newline at end of file
+}
+
+bool bs_pipelineReady(bs_Pipeline* pipeline) {
+    if(pipeline->state != NULL) return true;
+    return pipeline->entry != NULL && bs_atomicLoad(&((bs_PipelineEntry*)pipeline->entry)->status) == BS_PIPELINE_READY;
+}
+
+bool bs_pipelineFailed(bs_Pipeline* pipeline) {
+    return pipeline->entry != NULL && bs_atomicLoad(&((bs_PipelineEntry*)pipeline->entry)->status) == BS_PIPELINE_FAILED;
+}
+
+void bs_fallbackPipeline(bs_Pipeline* pipeline) {
+    fallback = pipeline == NULL ? NULL : pipeline->entry;
+}
+
+// the entry a batch using the pipeline draws with
+static bs_PipelineEntry* bs_drawEntry(bs_Pipeline* pipeline) {
+    bs_PipelineEntry* entry = pipeline->entry;
+    if(entry == NULL) {
+        return NULL;
+    }
+
+    if(pipeline->state != NULL || bs_atomicLoad(&entry->status) == BS_PIPELINE_READY) {
+        return entry;
+    }
+
+    // the fallback has to read the same vertices
+    if(fallback != NULL && fallback->key.attribs == entry->key.attribs && bs_atomicLoad(&fallback->status) == BS_PIPELINE_READY) {
+        return fallback;
+    }
+
+    return NULL;
+}
+
+void* bs_pipelineState(bs_Pipeline* pipeline) {
+    if(pipeline->state != NULL) {
+        return pipeline->state;
+    }
+
+    bs_PipelineEntry* entry = bs_drawEntry(pipeline);
+    return entry == NULL ? NULL : entry->pipeline;
+}
+
+void* bs_bindPipelineLayout(void* command_buffer, bs_Pipeline* pipeline) {
+    bs_PipelineEntry* entry = bs_drawEntry(pipeline);
+    if(entry == NULL) {
+        return NULL;
+    }
+
+    bs_LayoutEntry* layout = entry->layout;
+    if(layout->bindless) {
+        VkDescriptorSet set = bs_bindlessSet();
+        vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, layout->layout, BS_BINDLESS_SET, 1, &set, 0, NULL);
+    }
+
+    if(layout->num_spaces == 0) {
+        return layout->layout;
+    }
+
+    if(layout->space_set == NULL) {
+        bs_throw("Pipeline uses a shader space that hasn't been created");
+    }
+
+    bs_U32 offsets[BS_MAX_SHADER_BINDINGS];
+    bs_spaceOffsets(layout->key.bindings, layout->num_spaces, offsets);
+
+    VkDescriptorSet set = layout->space_set;
+    vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, layout->layout, BS_SPACE_SET, 1, &set, layout->num_spaces, offsets);
+    return layout->layout;
+}
+
+void* bs_vkPipelineLayout(bs_Pipeline* pipeline) {
+    return ((bs_PipelineEntry*)pipeline->entry)->layout->layout;
+}
+
+void* bs_vkDescriptorSetLayout(bs_Pipeline* pipeline, bs_U32 set) {
+    bs_LayoutEntry* layout = ((bs_PipelineEntry*)pipeline->entry)->layout;
+    return set < layout->num_sets ? layout->set_layouts[set] : NULL;
+}
+
+bs_U32 bs_pendingPipelines() {
+    return bs_atomicLoad(&compiles.pending);
+}
+
+bs_U32 bs_failedPipelines() {
+    return bs_atomicLoad(&failed_compiles);
+}
+
+void bs_freePipelines() {
+    bs_waitJobs(&compiles);
+
+    for(bs_U32 i = 0; i < pipelines.num_buckets; i++) {
+        bs_RegistryEntry* it = pipelines.buckets[i];
+        while(it != NULL) {
+            bs_RegistryEntry* next = it->next;
+            vkDestroyPipeline(bs_vkDevice(), ((bs_PipelineEntry*)it)->pipeline, NULL);
+            bs_free(it);
+            it = next;
+        }
+    }
+
+    // modules that were never released
+    for(bs_U32 i = 0; i < modules.num_buckets; i++) {
+        bs_RegistryEntry* it = modules.buckets[i];
+        while(it != NULL) {
+            bs_RegistryEntry* next = it->next;
+            bs_ModuleEntry* entry = (bs_ModuleEntry*)it;
+            vkDestroyShaderModule(bs_vkDevice(), entry->module, NULL);
+            bs_free(entry->path);
+            bs_free(entry);
+            it = next;
+        }
+    }
+
+    for(bs_U32 i = 0; i < layouts.num_buckets; i++) {
+        bs_RegistryEntry* it = layouts.buckets[i];
+        while(it != NULL) {
+            bs_RegistryEntry* next = it->next;
+            bs_LayoutEntry* entry = (bs_LayoutEntry*)it;
+
+            vkDestroyPipelineLayout(bs_vkDevice(), entry->layout, NULL);
+            for(bs_U32 j = 0; j < entry->num_sets; j++) {
+                if(entry->bindless && j == BS_BINDLESS_SET) continue;
+                vkDestroyDescriptorSetLayout(bs_vkDevice(), entry->set_layouts[j], NULL);
+            }
+
+            bs_free(entry);
+            it = next;
+        }
+    }
+
+    bs_free(pipelines.buckets);
+    bs_free(modules.buckets);
+    bs_free(layouts.buckets);
+    memset(&pipelines, 0, sizeof(pipelines));
+    memset(&modules, 0, sizeof(modules));
+    memset(&layouts, 0, sizeof(layouts));
+    fallback = NULL;
+    failed_compiles = 0;
+}
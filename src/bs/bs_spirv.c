@@ -0,0 +1,375 @@
+#include <bs_types.h>
+#include <bs_ini.h>
+#include <bs_mem.h>
+#include <bs_spirv.h>
+
+#include <string.h>
+
+#include <vulkan.h>
+
+#define BS_SPIRV_MAGIC 0x07230203
+
+// opcodes
+#define BS_OP_NAME 5
+#define BS_OP_ENTRY_POINT 15
+#define BS_OP_TYPE_INT 21
+#define BS_OP_TYPE_FLOAT 22
+#define BS_OP_TYPE_VECTOR 23
+#define BS_OP_TYPE_MATRIX 24
+#define BS_OP_TYPE_IMAGE 25
+#define BS_OP_TYPE_SAMPLER 26
+#define BS_OP_TYPE_SAMPLED_IMAGE 27
+#define BS_OP_TYPE_ARRAY 28
+#define BS_OP_TYPE_RUNTIME_ARRAY 29
+#define BS_OP_TYPE_STRUCT 30
+#define BS_OP_TYPE_POINTER 32
+#define BS_OP_CONSTANT 43
+#define BS_OP_VARIABLE 59
+#define BS_OP_DECORATE 71
+#define BS_OP_MEMBER_DECORATE 72
+#define BS_OP_TYPE_ACCELERATION_STRUCTURE 5341
+
+// decorations
+#define BS_DECORATION_BLOCK 2
+#define BS_DECORATION_BUFFER_BLOCK 3
+#define BS_DECORATION_ARRAY_STRIDE 6
+#define BS_DECORATION_BUILTIN 11
+#define BS_DECORATION_LOCATION 30
+#define BS_DECORATION_BINDING 33
+#define BS_DECORATION_SET 34
+#define BS_DECORATION_OFFSET 35
+
+// storage classes
+#define BS_STORAGE_UNIFORM_CONSTANT 0
+#define BS_STORAGE_INPUT 1
+#define BS_STORAGE_UNIFORM 2
+#define BS_STORAGE_PUSH_CONSTANT 9
+#define BS_STORAGE_STORAGE_BUFFER 12
+
+#define BS_ID_LOCATION 1
+#define BS_ID_BINDING 2
+#define BS_ID_SET 4
+#define BS_ID_BLOCK 8
+#define BS_ID_BUFFER_BLOCK 16
+#define BS_ID_BUILTIN 32
+
+typedef struct {
+    // the instruction that defined the id, NULL if it isn't a type, constant or variable
+    const bs_U32* inst;
+    const char* name;
+
+    bs_U32 location;
+    bs_U32 binding;
+    bs_U32 set;
+    bs_U32 array_stride;
+    bs_U8 flags;
+} bs_SpirvId;
+
+typedef struct {
+    bs_U32 structure;
+    bs_U32 offset;
+    bs_U32 member;
+} bs_SpirvMember;
+
+typedef struct {
+    const bs_U32* words;
+    bs_U32 num_words;
+
+    bs_SpirvId* ids;
+    bs_U32 bound;
+
+    // bs_SpirvMember, offsets of struct members
+    bs_Buffer members;
+} bs_Spirv;
+
+static const char* attribute_names[BS_NUM_ATTRIBUTES] = {
+    "bs_Position", "bs_Texture", "bs_Color", "bs_Normal", "bs_BoneId", "bs_Weight", "bs_Entity", "bs_Image"
+};
+
+static bs_SpirvId* bs_spirvId(bs_Spirv* spirv, bs_U32 id) {
+    if(id >= spirv->bound) {
+        bs_throw("Invalid SPIR-V id");
+    }
+
+    return spirv->ids + id;
+}
+
+// the instruction defining a type, follows pointers
+static const bs_U32* bs_spirvType(bs_Spirv* spirv, bs_U32 id) {
+    const bs_U32* inst = bs_spirvId(spirv, id)->inst;
+    if(inst == NULL) {
+        bs_throw("Undefined SPIR-V type");
+    }
+
+    return (inst[0] & 0xFFFF) == BS_OP_TYPE_POINTER ? bs_spirvType(spirv, inst[3]) : inst;
+}
+
+static bs_U32 bs_spirvConstant(bs_Spirv* spirv, bs_U32 id) {
+    const bs_U32* inst = bs_spirvId(spirv, id)->inst;
+    return (inst != NULL && (inst[0] & 0xFFFF) == BS_OP_CONSTANT) ? inst[3] : 1;
+}
+
+// size of a type in a push constant block, matrices are assumed to be column major with vec4 aligned columns
+static bs_U32 bs_spirvTypeSize(bs_Spirv* spirv, bs_U32 id) {
+    const bs_U32* inst = bs_spirvType(spirv, id);
+
+    switch(inst[0] & 0xFFFF) {
+        case BS_OP_TYPE_INT:
+        case BS_OP_TYPE_FLOAT:
+            return inst[2] / 8;
+        case BS_OP_TYPE_VECTOR:
+            return bs_spirvTypeSize(spirv, inst[2]) * inst[3];
+        case BS_OP_TYPE_MATRIX: {
+            bs_U32 column = bs_spirvTypeSize(spirv, inst[2]);
+            return ((column + 15) & ~15) * inst[3];
+        }
+        case BS_OP_TYPE_ARRAY: {
+            bs_U32 stride = bs_spirvId(spirv, inst[1])->array_stride;
+            if(stride == 0) stride = bs_spirvTypeSize(spirv, inst[2]);
+            return stride * bs_spirvConstant(spirv, inst[3]);
+        }
+        case BS_OP_TYPE_STRUCT: {
+            bs_U32 size = 0;
+            bs_U32 num_members = (inst[0] >> 16) - 2;
+
+            for(bs_U32 i = 0; i < spirv->members.num_units; i++) {
+                bs_SpirvMember* member = bs_bufferData(&spirv->members, i);
+                if(member->structure != inst[1] || member->member >= num_members) continue;
+
+                bs_U32 end = member->offset + bs_spirvTypeSize(spirv, inst[2 + member->member]);
+                if(end > size) size = end;
+            }
+
+            return size;
+        }
+    }
+
+    return 0;
+}
+
+static bs_U32 bs_spirvFormat(bs_Spirv* spirv, const bs_U32* type) {
+    bs_U32 count = 1;
+    if((type[0] & 0xFFFF) == BS_OP_TYPE_VECTOR) {
+        count = type[3];
+        type = bs_spirvType(spirv, type[2]);
+    }
+
+    if(count < 1 || count > 4 || type[2] != 32) {
+        return VK_FORMAT_UNDEFINED;
+    }
+
+    static const VkFormat floats[] = { VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT };
+    static const VkFormat sints[] = { VK_FORMAT_R32_SINT, VK_FORMAT_R32G32_SINT, VK_FORMAT_R32G32B32_SINT, VK_FORMAT_R32G32B32A32_SINT };
+    static const VkFormat uints[] = { VK_FORMAT_R32_UINT, VK_FORMAT_R32G32_UINT, VK_FORMAT_R32G32B32_UINT, VK_FORMAT_R32G32B32A32_UINT };
+
+    switch(type[0] & 0xFFFF) {
+        case BS_OP_TYPE_FLOAT: return floats[count - 1];
+        case BS_OP_TYPE_INT: return type[3] ? sints[count - 1] : uints[count - 1];
+    }
+
+    return VK_FORMAT_UNDEFINED;
+}
+
+static void bs_spirvInput(bs_Spirv* spirv, bs_SpirvId* variable, const bs_U32* type, bs_ShaderReflection* reflection) {
+    if((variable->flags & BS_ID_BUILTIN) || !(variable->flags & BS_ID_LOCATION)) {
+        return;
+    }
+
+    if(reflection->num_inputs == BS_MAX_SHADER_INPUTS) {
+        bs_throw("Shader has more than BS_MAX_SHADER_INPUTS inputs");
+    }
+
+    bs_ShaderInput* input = reflection->inputs + reflection->num_inputs++;
+    input->location = variable->location;
+    input->format = bs_spirvFormat(spirv, type);
+    input->attribute = BS_NUM_ATTRIBUTES;
+    input->named = variable->name != NULL && variable->name[0] != '\0';
+
+    for(int i = 0; i < BS_NUM_ATTRIBUTES && variable->name != NULL; i++) {
+        if(strcmp(variable->name, attribute_names[i]) == 0) {
+            input->attribute = i;
+            break;
+        }
+    }
+}
+
+static void bs_spirvBinding(bs_Spirv* spirv, bs_SpirvId* variable, const bs_U32* type, bs_U32 storage, bs_ShaderReflection* reflection) {
+    // arrays of resources take one binding with multiple descriptors
+    bs_U32 count = 1;
+    for(;;) {
+        bs_U32 op = type[0] & 0xFFFF;
+
+        if(op == BS_OP_TYPE_ARRAY) {
+            count *= bs_spirvConstant(spirv, type[3]);
+        } else if(op == BS_OP_TYPE_RUNTIME_ARRAY) {
+            count = 0;
+        } else {
+            break;
+        }
+
+        type = bs_spirvType(spirv, type[2]);
+    }
+
+    VkDescriptorType descriptor_type = VK_DESCRIPTOR_TYPE_MAX_ENUM;
+    bs_U8 flags = bs_spirvId(spirv, type[1])->flags;
+
+    switch(type[0] & 0xFFFF) {
+        case BS_OP_TYPE_STRUCT:
+            if(storage == BS_STORAGE_STORAGE_BUFFER || (flags & BS_ID_BUFFER_BLOCK)) {
+                descriptor_type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            } else if(storage == BS_STORAGE_UNIFORM) {
+                descriptor_type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+            }
+            break;
+        case BS_OP_TYPE_SAMPLED_IMAGE:
+            descriptor_type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            break;
+        case BS_OP_TYPE_SAMPLER:
+            descriptor_type = VK_DESCRIPTOR_TYPE_SAMPLER;
+            break;
+        case BS_OP_TYPE_IMAGE: {
+            bs_U32 dim = type[3], sampled = type[7];
+
+            // Dim Buffer and SubpassData
+            if(dim == 5) descriptor_type = sampled == 2 ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+            else if(dim == 6) descriptor_type = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+            else descriptor_type = sampled == 2 ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+            break;
+        }
+        case BS_OP_TYPE_ACCELERATION_STRUCTURE:
+            descriptor_type = VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR;
+            break;
+    }
+
+    if(descriptor_type == VK_DESCRIPTOR_TYPE_MAX_ENUM) {
+        return;
+    }
+
+    if(reflection->num_bindings == BS_MAX_SHADER_BINDINGS) {
+        bs_throw("Shader has more than BS_MAX_SHADER_BINDINGS descriptor bindings");
+    }
+
+    if(variable->set >= BS_MAX_DESCRIPTOR_SETS) {
+        bs_throw("Shader uses a descriptor set past BS_MAX_DESCRIPTOR_SETS");
+    }
+
+    bs_ShaderBinding* binding = reflection->bindings + reflection->num_bindings++;
+    binding->set = variable->set;
+    binding->binding = variable->binding;
+    binding->type = descriptor_type;
+    binding->count = count;
+    binding->stages = reflection->stage;
+}
+
+static void bs_spirvDecorate(bs_SpirvId* id, bs_U32 decoration, bs_U32 value) {
+    switch(decoration) {
+        case BS_DECORATION_BLOCK: id->flags |= BS_ID_BLOCK; break;
+        case BS_DECORATION_BUFFER_BLOCK: id->flags |= BS_ID_BUFFER_BLOCK; break;
+        case BS_DECORATION_ARRAY_STRIDE: id->array_stride = value; break;
+        case BS_DECORATION_BUILTIN: id->flags |= BS_ID_BUILTIN; break;
+        case BS_DECORATION_LOCATION: id->location = value; id->flags |= BS_ID_LOCATION; break;
+        case BS_DECORATION_BINDING: id->binding = value; id->flags |= BS_ID_BINDING; break;
+        case BS_DECORATION_SET: id->set = value; id->flags |= BS_ID_SET; break;
+    }
+}
+
+static VkShaderStageFlags bs_spirvStage(bs_U32 execution_model) {
+    switch(execution_model) {
+        case 0: return VK_SHADER_STAGE_VERTEX_BIT;
+        case 1: return VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+        case 2: return VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+        case 3: return VK_SHADER_STAGE_GEOMETRY_BIT;
+        case 4: return VK_SHADER_STAGE_FRAGMENT_BIT;
+        case 5: return VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+
+    return 0;
+}
+
+// a module is laid out as debug names, then annotations, then types, constants and variables,
+// so everything a variable needs is known by the time it is declared
+void bs_reflectSpirv(const void* code, bs_U64 size, bs_ShaderReflection* reflection) {
+    memset(reflection, 0, sizeof(bs_ShaderReflection));
+
+    bs_Spirv spirv = { 0 };
+    spirv.words = code;
+    spirv.num_words = size / sizeof(bs_U32);
+
+    if(spirv.num_words < 5 || spirv.words[0] != BS_SPIRV_MAGIC) {
+        bs_throw("Invalid SPIR-V header");
+    }
+
+    spirv.bound = spirv.words[3];
+    spirv.ids = bs_alloc(spirv.bound * sizeof(bs_SpirvId));
+    memset(spirv.ids, 0, spirv.bound * sizeof(bs_SpirvId));
+    spirv.members = bs_buffer(sizeof(bs_SpirvMember), 16, 16, 0);
+
+    for(bs_U32 i = 5; i < spirv.num_words;) {
+        const bs_U32* inst = spirv.words + i;
+        bs_U32 op = inst[0] & 0xFFFF;
+        bs_U32 num_words = inst[0] >> 16;
+
+        if(num_words == 0 || i + num_words > spirv.num_words) {
+            bs_throw("Invalid SPIR-V instruction");
+        }
+
+        i += num_words;
+
+        switch(op) {
+            case BS_OP_NAME:
+                bs_spirvId(&spirv, inst[1])->name = (const char*)(inst + 2);
+                break;
+            case BS_OP_ENTRY_POINT:
+                if(reflection->stage == 0) {
+                    reflection->stage = bs_spirvStage(inst[1]);
+                }
+                break;
+            case BS_OP_DECORATE:
+                bs_spirvDecorate(bs_spirvId(&spirv, inst[1]), inst[2], num_words > 3 ? inst[3] : 0);
+                break;
+            case BS_OP_MEMBER_DECORATE:
+                if(inst[3] == BS_DECORATION_OFFSET) {
+                    bs_SpirvMember member = { inst[1], inst[4], inst[2] };
+                    bs_bufferAppend(&spirv.members, &member);
+                }
+                break;
+            case BS_OP_TYPE_INT:
+            case BS_OP_TYPE_FLOAT:
+            case BS_OP_TYPE_VECTOR:
+            case BS_OP_TYPE_MATRIX:
+            case BS_OP_TYPE_IMAGE:
+            case BS_OP_TYPE_SAMPLER:
+            case BS_OP_TYPE_SAMPLED_IMAGE:
+            case BS_OP_TYPE_ARRAY:
+            case BS_OP_TYPE_RUNTIME_ARRAY:
+            case BS_OP_TYPE_STRUCT:
+            case BS_OP_TYPE_POINTER:
+            case BS_OP_TYPE_ACCELERATION_STRUCTURE:
+                bs_spirvId(&spirv, inst[1])->inst = inst;
+                break;
+            case BS_OP_CONSTANT:
+                bs_spirvId(&spirv, inst[2])->inst = inst;
+                break;
+            case BS_OP_VARIABLE: {
+                bs_SpirvId* variable = bs_spirvId(&spirv, inst[2]);
+                variable->inst = inst;
+
+                bs_U32 storage = inst[3];
+                const bs_U32* type = bs_spirvType(&spirv, inst[1]);
+
+                if(storage == BS_STORAGE_INPUT) {
+                    bs_spirvInput(&spirv, variable, type, reflection);
+                } else if(storage == BS_STORAGE_PUSH_CONSTANT) {
+                    bs_U32 push_size = bs_spirvTypeSize(&spirv, type[1]);
+                    if(push_size > reflection->push_constant_size) reflection->push_constant_size = push_size;
+                } else if(storage == BS_STORAGE_UNIFORM_CONSTANT || storage == BS_STORAGE_UNIFORM || storage == BS_STORAGE_STORAGE_BUFFER) {
+                    bs_spirvBinding(&spirv, variable, type, storage, reflection);
+                }
+                break;
+            }
+        }
+    }
+
+    bs_free(spirv.ids);
+    bs_free(spirv.members.data);
+}
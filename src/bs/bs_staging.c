@@ -0,0 +1,335 @@
+#include <bs_types.h>
+#include <bs_ini.h>
+#include <bs_staging.h>
+#include <bs_vram.h>
+
+#include <string.h>
+
+#include <vulkan.h>
+
+void bs_prepareBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer* buffer, bs_VramAllocation* allocation);
+
+// one persistently mapped ring, uploads are recorded into a command buffer until
+// bs_flushUploads(), every submit gets an id and a fence so ring space can be reclaimed
+// without waiting for the whole queue
+// with a transfer only family the copies are submitted to its queue, anything that needs
+// the graphics queue goes into a second command buffer that waits on them
+static struct {
+    VkBuffer buffer;
+    bs_VramAllocation allocation;
+    bs_U8* mapped;
+
+    VkDeviceSize size;
+    VkDeviceSize head;
+    VkDeviceSize used;
+
+    struct {
+        VkCommandBuffer command_buffer;
+        // VK_NULL_HANDLE without a transfer queue
+        VkCommandBuffer graphics_buffer;
+        VkSemaphore copied;
+        VkFence fence;
+        VkDeviceSize bytes;
+    } submits[BS_STAGING_SUBMITS];
+
+    bool transfer_queue;
+    VkCommandPool transfer_pool;
+
+    bool recording;
+    VkDeviceSize recorded_bytes;
+
+    bs_U64 next_id;
+    bs_U64 completed_id;
+
+    // record deferred work such as image copies right before a submit
+    void (*flush_callbacks[BS_STAGING_CALLBACKS])(void* command_buffer);
+    bs_U32 num_flush_callbacks;
+} staging = { 0 };
+
+void bs_prepareStaging(bs_U64 size) {
+    staging.size = size;
+    staging.next_id = 1;
+
+    bs_prepareBuffer(
+        size,
+        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        &staging.buffer, &staging.allocation
+    );
+
+    staging.mapped = staging.allocation.mapped;
+    staging.transfer_queue = bs_vkTransferFamily() != bs_vkGraphicsFamily();
+
+    VkCommandBuffer command_buffers[BS_STAGING_SUBMITS];
+    VkCommandBuffer graphics_buffers[BS_STAGING_SUBMITS] = { 0 };
+    VkCommandBufferAllocateInfo alloc_i = { 0 };
+    alloc_i.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    alloc_i.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    alloc_i.commandPool = bs_vkCmdPool();
+    alloc_i.commandBufferCount = BS_STAGING_SUBMITS;
+
+    if(staging.transfer_queue) {
+        VkCommandPoolCreateInfo pool_ci = { 0 };
+        pool_ci.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        pool_ci.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+        pool_ci.queueFamilyIndex = bs_vkTransferFamily();
+        BS_VK_ERR(vkCreateCommandPool(bs_vkDevice(), &pool_ci, NULL, &staging.transfer_pool), "Failed to create transfer command pool");
+
+        BS_VK_ERR(vkAllocateCommandBuffers(bs_vkDevice(), &alloc_i, graphics_buffers), "Failed to allocate upload command buffers");
+        alloc_i.commandPool = staging.transfer_pool;
+    }
+
+    BS_VK_ERR(vkAllocateCommandBuffers(bs_vkDevice(), &alloc_i, command_buffers), "Failed to allocate upload command buffers");
+
+    VkFenceCreateInfo fence_ci = { 0 };
+    fence_ci.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+    VkSemaphoreCreateInfo semaphore_ci = { 0 };
+    semaphore_ci.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+    for(int i = 0; i < BS_STAGING_SUBMITS; i++) {
+        staging.submits[i].command_buffer = command_buffers[i];
+        staging.submits[i].graphics_buffer = graphics_buffers[i];
+        BS_VK_ERR(vkCreateFence(bs_vkDevice(), &fence_ci, NULL, &staging.submits[i].fence), "Failed to create upload fence");
+
+        if(staging.transfer_queue) {
+            BS_VK_ERR(vkCreateSemaphore(bs_vkDevice(), &semaphore_ci, NULL, &staging.submits[i].copied), "Failed to create upload semaphore");
+        }
+    }
+}
+
+// frees ring space of finished submits, blocks on the oldest one if wait is set
+static void bs_retireUploads(bool wait) {
+    while(staging.completed_id + 1 < staging.next_id) {
+        bs_U64 id = staging.completed_id + 1;
+        VkFence fence = staging.submits[id % BS_STAGING_SUBMITS].fence;
+
+        if(wait) {
+            vkWaitForFences(bs_vkDevice(), 1, &fence, VK_TRUE, UINT64_MAX);
+            wait = false;
+        } else if(vkGetFenceStatus(bs_vkDevice(), fence) != VK_SUCCESS) {
+            break;
+        }
+
+        staging.used -= staging.submits[id % BS_STAGING_SUBMITS].bytes;
+        staging.completed_id = id;
+    }
+
+    if(staging.used == 0) {
+        staging.head = 0;
+    }
+}
+
+static VkCommandBuffer bs_stagingCommandBuffer() {
+    VkCommandBuffer command_buffer = staging.submits[staging.next_id % BS_STAGING_SUBMITS].command_buffer;
+    VkCommandBuffer graphics_buffer = staging.submits[staging.next_id % BS_STAGING_SUBMITS].graphics_buffer;
+    if(staging.recording) {
+        return command_buffer;
+    }
+
+    // the slot is reused every BS_STAGING_SUBMITS submits
+    while(staging.completed_id + BS_STAGING_SUBMITS < staging.next_id) {
+        bs_retireUploads(true);
+    }
+
+    VkCommandBufferBeginInfo begin_i = { 0 };
+    begin_i.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    begin_i.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    vkResetCommandBuffer(command_buffer, 0);
+    BS_VK_ERR(vkBeginCommandBuffer(command_buffer, &begin_i), "Failed to begin upload recording");
+
+    if(graphics_buffer != VK_NULL_HANDLE) {
+        vkResetCommandBuffer(graphics_buffer, 0);
+        BS_VK_ERR(vkBeginCommandBuffer(graphics_buffer, &begin_i), "Failed to begin upload recording");
+    }
+
+    staging.recording = true;
+    return command_buffer;
+}
+
+static VkDeviceSize bs_stagingAlloc(VkDeviceSize size, VkDeviceSize alignment) {
+    for(;;) {
+        bs_retireUploads(false);
+
+        VkDeviceSize offset = (staging.head + alignment - 1) & ~(alignment - 1);
+        VkDeviceSize padding = offset - staging.head;
+
+        // wrap around, the tail end of the ring is wasted until this submit retires
+        if(offset + size > staging.size) {
+            padding = staging.size - staging.head;
+            offset = 0;
+        }
+
+        if(staging.used + padding + size <= staging.size) {
+            staging.head = offset + size;
+            staging.used += padding + size;
+            staging.recorded_bytes += padding + size;
+            return offset;
+        }
+
+        // ring is full, submit what has been recorded so far and wait for the oldest upload
+        bs_flushUploads();
+        bs_retireUploads(true);
+    }
+}
+
+bs_U64 bs_stagingWrite(const void* data, bs_U64 size, bs_U64 alignment) {
+    if(size > staging.size / 2) {
+        bs_throw("Staging write is larger than half the staging ring");
+    }
+
+    VkDeviceSize offset = bs_stagingAlloc(size, alignment < 16 ? 16 : alignment);
+    memcpy(staging.mapped + offset, data, size);
+
+    // the ring space is only reclaimed by the submit that's recording
+    bs_stagingCommandBuffer();
+    return offset;
+}
+
+void* bs_uploadCommandBuffer() {
+    return bs_stagingCommandBuffer();
+}
+
+void* bs_uploadGraphicsCommandBuffer() {
+    VkCommandBuffer command_buffer = bs_stagingCommandBuffer();
+    return staging.transfer_queue ? staging.submits[staging.next_id % BS_STAGING_SUBMITS].graphics_buffer : command_buffer;
+}
+
+void* bs_stagingBuffer() {
+    return staging.buffer;
+}
+
+bs_U64 bs_recordingUploadId() {
+    return staging.next_id;
+}
+
+void bs_stagingFlushCallback(void (*callback)(void* command_buffer)) {
+    if(staging.num_flush_callbacks == BS_STAGING_CALLBACKS) {
+        bs_throw("More than BS_STAGING_CALLBACKS staging flush callbacks");
+    }
+
+    staging.flush_callbacks[staging.num_flush_callbacks++] = callback;
+}
+
+void bs_stagingUpload(void* dst_buffer, bs_U64 dst_offset, const void* data, bs_U64 size) {
+    const bs_U8* src = data;
+    VkDeviceSize max_chunk = staging.size / 2;
+
+    while(size > 0) {
+        VkDeviceSize chunk = size < max_chunk ? size : max_chunk;
+        VkDeviceSize offset = bs_stagingAlloc(chunk, 16);
+        memcpy(staging.mapped + offset, src, chunk);
+
+        VkBufferCopy region = { 0 };
+        region.srcOffset = offset;
+        region.dstOffset = dst_offset;
+        region.size = chunk;
+        vkCmdCopyBuffer(bs_stagingCommandBuffer(), staging.buffer, dst_buffer, 1, &region);
+
+        src += chunk;
+        dst_offset += chunk;
+        size -= chunk;
+    }
+}
+
+bs_U64 bs_flushUploads() {
+    if(!staging.recording) {
+        return 0;
+    }
+
+    bs_U64 id = staging.next_id;
+    VkCommandBuffer command_buffer = staging.submits[id % BS_STAGING_SUBMITS].command_buffer;
+    VkCommandBuffer graphics_buffer = staging.transfer_queue ? staging.submits[id % BS_STAGING_SUBMITS].graphics_buffer : command_buffer;
+    VkFence fence = staging.submits[id % BS_STAGING_SUBMITS].fence;
+
+    for(bs_U32 i = 0; i < staging.num_flush_callbacks; i++) {
+        staging.flush_callbacks[i](command_buffer);
+    }
+
+    // make the copies visible to anything submitted after this on the graphics queue
+    VkMemoryBarrier barrier = { 0 };
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+
+    vkCmdPipelineBarrier(
+        graphics_buffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+        0, 1, &barrier, 0, NULL, 0, NULL
+    );
+
+    BS_VK_ERR(vkEndCommandBuffer(command_buffer), "Failed to record uploads");
+
+    VkSubmitInfo submit_i = { 0 };
+    submit_i.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submit_i.commandBufferCount = 1;
+    submit_i.pCommandBuffers = &command_buffer;
+
+    // the graphics half waits on the copies, so its fence covers both
+    if(staging.transfer_queue) {
+        VkSemaphore copied = staging.submits[id % BS_STAGING_SUBMITS].copied;
+        VkPipelineStageFlags wait_stage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+
+        submit_i.signalSemaphoreCount = 1;
+        submit_i.pSignalSemaphores = &copied;
+        BS_VK_ERR(vkQueueSubmit(bs_vkTransferQueue(), 1, &submit_i, VK_NULL_HANDLE), "Failed to submit uploads");
+
+        BS_VK_ERR(vkEndCommandBuffer(graphics_buffer), "Failed to record uploads");
+
+        memset(&submit_i, 0, sizeof(submit_i));
+        submit_i.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submit_i.waitSemaphoreCount = 1;
+        submit_i.pWaitSemaphores = &copied;
+        submit_i.pWaitDstStageMask = &wait_stage;
+        submit_i.commandBufferCount = 1;
+        submit_i.pCommandBuffers = &graphics_buffer;
+    }
+
+    vkResetFences(bs_vkDevice(), 1, &fence);
+    BS_VK_ERR(vkQueueSubmit(bs_vkGraphicsQueue(), 1, &submit_i, fence), "Failed to submit uploads");
+
+    staging.submits[id % BS_STAGING_SUBMITS].bytes = staging.recorded_bytes;
+    staging.recorded_bytes = 0;
+    staging.recording = false;
+    staging.next_id++;
+
+    return id;
+}
+
+bool bs_uploadComplete(bs_U64 id) {
+    bs_retireUploads(false);
+    return id <= staging.completed_id;
+}
+
+void bs_waitUpload(bs_U64 id) {
+    while(staging.completed_id < id && staging.completed_id + 1 < staging.next_id) {
+        bs_retireUploads(true);
+    }
+}
+
+void bs_freeStaging() {
+    bs_waitUpload(bs_flushUploads());
+    bs_waitUpload(staging.next_id - 1);
+
+    VkCommandBuffer command_buffers[BS_STAGING_SUBMITS];
+    VkCommandBuffer graphics_buffers[BS_STAGING_SUBMITS];
+    for(int i = 0; i < BS_STAGING_SUBMITS; i++) {
+        command_buffers[i] = staging.submits[i].command_buffer;
+        graphics_buffers[i] = staging.submits[i].graphics_buffer;
+        vkDestroyFence(bs_vkDevice(), staging.submits[i].fence, NULL);
+        if(staging.transfer_queue) vkDestroySemaphore(bs_vkDevice(), staging.submits[i].copied, NULL);
+    }
+
+    if(staging.transfer_queue) {
+        vkFreeCommandBuffers(bs_vkDevice(), bs_vkCmdPool(), BS_STAGING_SUBMITS, graphics_buffers);
+        vkDestroyCommandPool(bs_vkDevice(), staging.transfer_pool, NULL);
+    } else {
+        vkFreeCommandBuffers(bs_vkDevice(), bs_vkCmdPool(), BS_STAGING_SUBMITS, command_buffers);
+    }
+    vkDestroyBuffer(bs_vkDevice(), staging.buffer, NULL);
+    bs_vramFree(&staging.allocation);
+
+    memset(&staging, 0, sizeof(staging));
+}
@@ -1,230 +1,1110 @@
-// GL
-#include <glad/glad.h>
-#include <cglm/cglm.h>
-
 // Basilisk
-#include <bs_shaders.h>
-#include <bs_core.h>
+#include <bs_types.h>
+#include <bs_ini.h>
 #include <bs_math.h>
 #include <bs_mem.h>
+#include <bs_pack.h>
+#include <bs_vram.h>
+#include <bs_staging.h>
+#include <bs_descriptors.h>
 #include <bs_textures.h>
 
+#ifndef BS_NO_PNG
 #include <lodepng.h>
+#endif
+
+#include <bs_jobs.h>
+#include <bs_io.h>
 
 // STD
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <stddef.h>
-#include <windows.h>
-#include <winreg.h>
 
-bs_Texture* curr_texture;
-int filter = GL_NEAREST;
+#include <vulkan.h>
 
-bs_Buffer image_buf;
-bs_Buffer image_data_buf;
+// rows of one level waiting in the staging ring, recorded by bs_recordTextureUploads()
+// large textures are split into several of these which can end up in different submits
+typedef struct {
+    VkImage image;
+    VkFormat format;
+    bs_U32 w, h;
+    bs_U32 mip_levels;
+    // levels in the staging ring, the rest are blitted
+    bs_U32 copied_levels;
+
+    bs_U32 level;
+    bs_U32 y, rows;
+    VkDeviceSize offset;
+
+    // the first chunk moves the image to transfer dst, the last one generates the mips and makes it readable
+    bool first, last;
+} bs_TextureUpload;
+
+typedef struct {
+    VkImage image;
+    VkImageView view;
+    bs_VramAllocation allocation;
+    bs_U64 upload;
+} bs_RetiredTexture;
+
+static struct {
+    // bs_TextureUpload
+    bs_Buffer pending;
+    // bs_RetiredTexture, per frame in flight
+    bs_Buffer retired[BS_MAX_FRAMES_IN_FLIGHT];
+} textures = { 0 };
+
+#define BS_LOAD_QUEUED 0
+#define BS_LOAD_READING 1
+#define BS_LOAD_DECODING 2
+#define BS_LOAD_DECODED 3
+#define BS_LOAD_FAILED 4
+
+typedef struct {
+    // NULL once the image was freed while decoding
+    bs_Image* image;
+    char* path;
+    float priority;
+    // position in the queue heap while queued
+    bs_U32 heap_index;
 
-bs_Space image_shader_space;
+    // loose files are read through bs_readAsync() before they're decoded, packed ones are decoded in place
+    bs_IoRequest read;
+
+    // written by the decode job, read once state is past BS_LOAD_DECODING
+    volatile bs_I32 state;
+    bs_Texture decoded;
+} bs_ImageLoad;
+
+static struct {
+    // bs_ImageLoad*, max heap on priority
+    bs_Buffer queue;
+    // bs_ImageLoad*, being read or decoded
+    bs_Buffer decoding;
+    bs_JobCounter decodes;
+} streaming = { 0 };
+
+// bs_Image*, images are allocated individually so the pointers stay valid
+bs_Buffer image_buf;
 
 // Space Communication-
 void bs_pushImageBuffers() {
-    image_buf = bs_buffer(0, sizeof(bs_Image), 16, 32, 0);
-    image_data_buf = bs_buffer(0, sizeof(bs_ImageShaderData), 16, 32, 0x4000 / sizeof(bs_ImageShaderData));
+    image_buf = bs_buffer(sizeof(bs_Image*), 32, 32, 0);
 
     bs_image(NULL, 0);
-}
 
-void bs_pushImages() {
-    image_shader_space = bs_shaderSpace(image_data_buf, BS_SPACE_IMAGES, BS_STD140);
+    streaming.queue = bs_buffer(sizeof(bs_ImageLoad*), 64, 64, 0);
+    streaming.decoding = bs_buffer(sizeof(bs_ImageLoad*), 16, 16, 0);
 }
 
 bs_Image* bs_getLastImage() {
-    return bs_bufferData(&image_buf, image_buf.size - 1);
+    return *(bs_Image**)bs_bufferData(&image_buf, image_buf.num_units - 1);
 }
 //-Space Communication
 
 void bs_saveTexture32(const char* name, unsigned char* data, int w, int h) {
+#ifndef BS_NO_PNG
     lodepng_encode32_file(name, data, w, h);
+#endif
+}
+
+bs_U32 bs_texelSize(bs_U32 format) {
+    switch(format) {
+        case VK_FORMAT_R8_UNORM: return 1;
+        case VK_FORMAT_R8G8_UNORM: return 2;
+        case VK_FORMAT_R16_UINT: return 2;
+        case VK_FORMAT_R8G8B8A8_UNORM: return 4;
+        case VK_FORMAT_R8G8B8A8_SRGB: return 4;
+        case VK_FORMAT_B10G11R11_UFLOAT_PACK32: return 4;
+        case VK_FORMAT_R16G16B16A16_SFLOAT: return 8;
+        case VK_FORMAT_R32G32B32A32_SFLOAT: return 16;
+    }
+
+    bs_throw("Unsupported texture format");
+    return 0;
+}
+
+// bytes per 4x4 block, 0 for uncompressed formats
+static bs_U32 bs_blockSize(bs_U32 format) {
+    switch(format) {
+        case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+        case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+        case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+        case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+        case VK_FORMAT_BC4_UNORM_BLOCK:
+        case VK_FORMAT_BC4_SNORM_BLOCK:
+            return 8;
+        case VK_FORMAT_BC2_UNORM_BLOCK:
+        case VK_FORMAT_BC2_SRGB_BLOCK:
+        case VK_FORMAT_BC3_UNORM_BLOCK:
+        case VK_FORMAT_BC3_SRGB_BLOCK:
+        case VK_FORMAT_BC5_UNORM_BLOCK:
+        case VK_FORMAT_BC5_SNORM_BLOCK:
+        case VK_FORMAT_BC7_UNORM_BLOCK:
+        case VK_FORMAT_BC7_SRGB_BLOCK:
+            return 16;
+    }
+
+    return 0;
+}
+
+bs_U64 bs_levelSize(bs_U32 format, bs_U32 w, bs_U32 h) {
+    bs_U32 block_size = bs_blockSize(format);
+    if(block_size != 0) {
+        return (bs_U64)((w + 3) / 4) * ((h + 3) / 4) * block_size;
+    }
+
+    return (bs_U64)w * h * bs_texelSize(format);
+}
+
+// - uploads -
+static void bs_imageBarrier(VkImageMemoryBarrier* barrier, VkImage image, bs_U32 first_level, bs_U32 num_levels, VkImageLayout old_layout, VkImageLayout new_layout, VkAccessFlags src_access, VkAccessFlags dst_access) {
+    memset(barrier, 0, sizeof(VkImageMemoryBarrier));
+    barrier->sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier->srcAccessMask = src_access;
+    barrier->dstAccessMask = dst_access;
+    barrier->oldLayout = old_layout;
+    barrier->newLayout = new_layout;
+    barrier->srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier->dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier->image = image;
+    barrier->subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier->subresourceRange.baseMipLevel = first_level;
+    barrier->subresourceRange.levelCount = num_levels;
+    barrier->subresourceRange.layerCount = 1;
+}
+
+// every pending texture goes through the same steps, so each step is a single barrier for all of them:
+// undefined -> transfer dst, copy the staged rows, then per generated level: previous level -> transfer src
+// and blit it down, finally every level -> shader read only
+// chunks of a texture split across submits only do the steps their part needs, the image stays transfer dst in between
+// with a transfer queue the copies run there, the last chunk hands the image to the graphics queue for the rest
+static void bs_recordTextureUploads(void* transfer_buffer) {
+    bs_U32 num_uploads = textures.pending.num_units;
+    if(num_uploads == 0) {
+        return;
+    }
+
+    bs_TextureUpload* uploads = (bs_TextureUpload*)textures.pending.data;
+    VkImageMemoryBarrier* barriers = bs_alloc(num_uploads * 3 * sizeof(VkImageMemoryBarrier));
+    bs_U32 max_levels = 1;
+    bs_U32 num_barriers = 0;
+
+    for(bs_U32 i = 0; i < num_uploads; i++) {
+        if(uploads[i].last && uploads[i].mip_levels > max_levels) max_levels = uploads[i].mip_levels;
+        if(!uploads[i].first) continue;
+
+        bs_imageBarrier(barriers + num_barriers++, uploads[i].image, 0, uploads[i].mip_levels, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0, VK_ACCESS_TRANSFER_WRITE_BIT);
+    }
+
+    if(num_barriers > 0) {
+        vkCmdPipelineBarrier(transfer_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 0, NULL, num_barriers, barriers);
+    }
+
+    for(bs_U32 i = 0; i < num_uploads; i++) {
+        bs_U32 w = uploads[i].w >> uploads[i].level;
+
+        VkBufferImageCopy region = { 0 };
+        region.bufferOffset = uploads[i].offset;
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = uploads[i].level;
+        region.imageSubresource.layerCount = 1;
+        region.imageOffset.y = uploads[i].y;
+        region.imageExtent.width = w > 0 ? w : 1;
+        region.imageExtent.height = uploads[i].rows;
+        region.imageExtent.depth = 1;
+
+        vkCmdCopyBufferToImage(transfer_buffer, bs_stagingBuffer(), uploads[i].image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+    }
+
+    // release on the transfer queue and acquire on the graphics queue, both with the same layouts
+    VkCommandBuffer command_buffer = bs_uploadGraphicsCommandBuffer();
+    if(command_buffer != transfer_buffer) {
+        num_barriers = 0;
+        for(bs_U32 i = 0; i < num_uploads; i++) {
+            if(!uploads[i].last) continue;
+
+            VkImageMemoryBarrier* barrier = barriers + num_barriers++;
+            bs_imageBarrier(barrier, uploads[i].image, 0, uploads[i].mip_levels, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_ACCESS_TRANSFER_WRITE_BIT, 0);
+            barrier->srcQueueFamilyIndex = bs_vkTransferFamily();
+            barrier->dstQueueFamilyIndex = bs_vkGraphicsFamily();
+        }
+
+        if(num_barriers > 0) {
+            vkCmdPipelineBarrier(transfer_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, NULL, 0, NULL, num_barriers, barriers);
+
+            for(bs_U32 i = 0; i < num_barriers; i++) {
+                barriers[i].srcAccessMask = 0;
+                barriers[i].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+            }
+
+            vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 0, NULL, num_barriers, barriers);
+        }
+    }
+
+    for(bs_U32 level = 1; level < max_levels; level++) {
+        num_barriers = 0;
+        for(bs_U32 i = 0; i < num_uploads; i++) {
+            if(!uploads[i].last || level < uploads[i].copied_levels || level >= uploads[i].mip_levels) continue;
+            bs_imageBarrier(barriers + num_barriers++, uploads[i].image, level - 1, 1, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+        }
+
+        if(num_barriers == 0) {
+            continue;
+        }
+
+        vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 0, NULL, num_barriers, barriers);
+
+        for(bs_U32 i = 0; i < num_uploads; i++) {
+            if(!uploads[i].last || level < uploads[i].copied_levels || level >= uploads[i].mip_levels) continue;
+
+            bs_I32 src_w = uploads[i].w >> (level - 1), src_h = uploads[i].h >> (level - 1);
+            bs_I32 dst_w = uploads[i].w >> level, dst_h = uploads[i].h >> level;
+
+            VkImageBlit blit = { 0 };
+            blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            blit.srcSubresource.mipLevel = level - 1;
+            blit.srcSubresource.layerCount = 1;
+            blit.srcOffsets[1].x = src_w > 0 ? src_w : 1;
+            blit.srcOffsets[1].y = src_h > 0 ? src_h : 1;
+            blit.srcOffsets[1].z = 1;
+
+            blit.dstSubresource = blit.srcSubresource;
+            blit.dstSubresource.mipLevel = level;
+            blit.dstOffsets[1].x = dst_w > 0 ? dst_w : 1;
+            blit.dstOffsets[1].y = dst_h > 0 ? dst_h : 1;
+            blit.dstOffsets[1].z = 1;
+
+            vkCmdBlitImage(
+                command_buffer,
+                uploads[i].image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                uploads[i].image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                1, &blit, VK_FILTER_LINEAR
+            );
+        }
+    }
+
+    // copied levels stay transfer dst, except the last one if later levels were blitted from it, so did every generated level but the last
+    num_barriers = 0;
+    for(bs_U32 i = 0; i < num_uploads; i++) {
+        if(!uploads[i].last) continue;
+
+        bs_U32 levels = uploads[i].mip_levels, copied = uploads[i].copied_levels;
+        if(levels == copied) {
+            bs_imageBarrier(barriers + num_barriers++, uploads[i].image, 0, levels, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT);
+            continue;
+        }
+
+        if(copied > 1) {
+            bs_imageBarrier(barriers + num_barriers++, uploads[i].image, 0, copied - 1, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT);
+        }
+
+        bs_imageBarrier(barriers + num_barriers++, uploads[i].image, copied - 1, levels - copied, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_ACCESS_TRANSFER_READ_BIT, VK_ACCESS_SHADER_READ_BIT);
+        bs_imageBarrier(barriers + num_barriers++, uploads[i].image, levels - 1, 1, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT);
+    }
+
+    if(num_barriers > 0) {
+        vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, NULL, 0, NULL, num_barriers, barriers);
+    }
+
+    bs_free(barriers);
+    textures.pending.num_units = 0;
+}
+
+void bs_textureUploadLevels(bs_Texture* texture, const void* data, bs_U32 num_levels) {
+    if(textures.pending.unit_size == 0) {
+        textures.pending = bs_buffer(sizeof(bs_TextureUpload), 32, 32, 0);
+        bs_stagingFlushCallback(bs_recordTextureUploads);
+    }
+
+    if(num_levels == 0 || num_levels > texture->mip_levels) {
+        bs_throw("Texture upload has more levels than the texture");
+    }
+
+    if(num_levels < texture->mip_levels && bs_blockSize(texture->format) != 0) {
+        bs_throw("Mip levels of compressed textures can't be generated");
+    }
+
+    // offsets of copies have to be a multiple of the texel or block size, compressed levels are split on block rows
+    bs_U32 block_size = bs_blockSize(texture->format);
+    bs_U32 alignment = block_size != 0 ? block_size : bs_texelSize(texture->format);
+    bs_U32 row_height = block_size != 0 ? 4 : 1;
+
+    // every level is its own write, levels that don't fit into half the ring are split into row ranges
+    // so the ring can be flushed and reclaimed between them
+    const bs_U8* src = data;
+    bool first = true;
+
+    for(bs_U32 level = 0; level < num_levels; level++) {
+        bs_U32 w = texture->w >> level, h = texture->h >> level;
+        if(w == 0) w = 1;
+        if(h == 0) h = 1;
+
+        bs_U32 max_rows = (BS_STAGING_SIZE / 2) / bs_levelSize(texture->format, w, row_height) * row_height;
+        if(max_rows == 0) {
+            bs_throw("Texture row is larger than half the staging ring");
+        }
+
+        for(bs_U32 y = 0; y < h; y += max_rows) {
+            bs_U32 rows = h - y < max_rows ? h - y : max_rows;
+            bs_U64 size = bs_levelSize(texture->format, w, rows);
+            VkDeviceSize offset = bs_stagingWrite(src, size, alignment);
+            src += size;
+
+            // appended after the write, a flush in there records the chunks before this one
+            bs_TextureUpload* upload = bs_bufferAppend(&textures.pending, NULL);
+            upload->image = texture->image;
+            upload->format = texture->format;
+            upload->w = texture->w;
+            upload->h = texture->h;
+            upload->mip_levels = texture->mip_levels;
+            upload->copied_levels = num_levels;
+            upload->level = level;
+            upload->y = y;
+            upload->rows = rows;
+            upload->offset = offset;
+            upload->first = first;
+            upload->last = level == num_levels - 1 && y + rows == h;
+            first = false;
+        }
+    }
+
+    // the writes above may have flushed, so the id is read after them
+    texture->upload = bs_recordingUploadId();
+}
+
+void bs_textureUpload(bs_Texture* texture, const void* data) {
+    bs_textureUploadLevels(texture, data, 1);
 }
 
 // Texture Initialization
-void bs_texture(bs_Texture *texture, bs_vec2 dim, int type) {
+// floor(log2(max(w, h))) + 1
+static bs_U32 bs_fullChain(bs_U32 w, bs_U32 h) {
+    bs_U32 levels = 1;
+    for(bs_U32 size = w > h ? w : h; size > 1; size >>= 1) {
+        levels++;
+    }
+
+    return levels;
+}
+
+static void bs_createTexture(bs_Texture* texture, bs_vec2 dim, bs_U32 format, bs_U32 mip_levels, VkImageUsageFlags usage, VkImageAspectFlags aspect) {
     memset(texture, 0, sizeof(bs_Texture));
+    texture->w = dim.x;
+    texture->h = dim.y;
+    texture->format = format;
+
+    bs_U32 full_chain = bs_fullChain(texture->w, texture->h);
+    if(mip_levels == 0 || mip_levels > full_chain) {
+        mip_levels = full_chain;
+    }
+
+    // mips are generated with linear blits, compressed textures bring all of theirs
+    if(mip_levels > 1 && bs_blockSize(format) == 0) {
+        VkFormatProperties properties;
+        vkGetPhysicalDeviceFormatProperties(bs_vkPhysicalDevice(), format, &properties);
+
+        VkFormatFeatureFlags required = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+        if((properties.optimalTilingFeatures & required) != required) {
+            mip_levels = 1;
+        }
+    }
+
+    texture->mip_levels = mip_levels;
+    if(mip_levels > 1 && bs_blockSize(format) == 0) {
+        usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    }
+
+    VkImageCreateInfo image_ci = { 0 };
+    image_ci.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    image_ci.imageType = VK_IMAGE_TYPE_2D;
+    image_ci.format = format;
+    image_ci.extent.width = texture->w;
+    image_ci.extent.height = texture->h;
+    image_ci.extent.depth = 1;
+    image_ci.mipLevels = mip_levels;
+    image_ci.arrayLayers = 1;
+    image_ci.samples = VK_SAMPLE_COUNT_1_BIT;
+    image_ci.tiling = VK_IMAGE_TILING_OPTIMAL;
+    image_ci.usage = usage;
+    image_ci.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    image_ci.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    VkImage image = VK_NULL_HANDLE;
+    BS_VK_ERR(vkCreateImage(bs_vkDevice(), &image_ci, NULL, &image), "Failed to create texture image");
+
+    VkMemoryRequirements mem_req;
+    vkGetImageMemoryRequirements(bs_vkDevice(), image, &mem_req);
+
+    texture->allocation = bs_vramAlloc(mem_req.size, mem_req.alignment, mem_req.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true);
+    vkBindImageMemory(bs_vkDevice(), image, texture->allocation.memory, texture->allocation.offset);
+
+    VkImageViewCreateInfo view_ci = { 0 };
+    view_ci.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    view_ci.image = image;
+    view_ci.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    view_ci.format = format;
+    view_ci.subresourceRange.aspectMask = aspect;
+    view_ci.subresourceRange.levelCount = mip_levels;
+    view_ci.subresourceRange.layerCount = 1;
 
-    glGenTextures(1, &texture->id);
-    glBindTexture(type, texture->id);
+    VkImageView view = VK_NULL_HANDLE;
+    BS_VK_ERR(vkCreateImageView(bs_vkDevice(), &view_ci, NULL, &view), "Failed to create texture image view");
 
-    curr_texture = texture;
-    curr_texture->num_frames = 1;
+    texture->image = image;
+    texture->view = view;
+}
+
+void bs_texture(bs_Texture* texture, bs_vec2 dim, bs_U32 format, bs_U32 mip_levels) {
+    bs_createTexture(texture, dim, format, mip_levels, VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT, VK_IMAGE_ASPECT_COLOR_BIT);
+}
+
+void bs_freeTexture(bs_Texture* texture) {
+    if(texture->image == NULL) {
+        return;
+    }
 
-    curr_texture->w = dim.x;
-    curr_texture->h = dim.y;
+    // never recorded, its staged data is reclaimed with the rest of the submit
+    for(bs_U32 i = 0; i < textures.pending.num_units;) {
+        bs_TextureUpload* upload = bs_bufferData(&textures.pending, i);
+        if(upload->image != texture->image) {
+            i++;
+            continue;
+        }
+
+        *upload = *(bs_TextureUpload*)bs_bufferData(&textures.pending, textures.pending.num_units - 1);
+        textures.pending.num_units--;
+    }
+
+    bs_Buffer* retired = textures.retired + bs_frameData()->swapchain_frame;
+    if(retired->unit_size == 0) {
+        *retired = bs_buffer(sizeof(bs_RetiredTexture), 16, 0, 0);
+    }
 
-    curr_texture->texw = 1.0;
-    curr_texture->texh = 1.0;
+    bs_RetiredTexture* entry = bs_bufferAppend(retired, NULL);
+    entry->image = texture->image;
+    entry->view = texture->view;
+    entry->allocation = texture->allocation;
+    entry->upload = texture->upload;
+
+    memset(texture, 0, sizeof(bs_Texture));
+}
+
+static void bs_destroyRetired(bs_Buffer* retired) {
+    for(bs_U32 i = 0; i < retired->num_units; i++) {
+        bs_RetiredTexture* entry = bs_bufferData(retired, i);
+
+        // a frame's fence doesn't cover upload submits that came before it
+        bs_waitUpload(entry->upload);
+        vkDestroyImageView(bs_vkDevice(), entry->view, NULL);
+        vkDestroyImage(bs_vkDevice(), entry->image, NULL);
+        bs_vramFree(&entry->allocation);
+    }
+
+    retired->num_units = 0;
+}
 
-    curr_texture->type = type;
+void bs_recycleTextures() {
+    bs_destroyRetired(textures.retired + bs_frameData()->swapchain_frame);
 }
 
-bs_U32 bs_textureDataFile(const char* path, bool update_dimensions) {
+bs_U32 bs_textureDataFile(bs_Texture* texture, const char* path, bool update_dimensions) {
     if (path == NULL) return 0;
+#ifndef BS_NO_PNG
     unsigned int w, h;
-    bs_U32 err = lodepng_decode32_file(&curr_texture->data, &w, &h, path);
+    bs_U32 err = lodepng_decode32_file(&texture->data, &w, &h, path);
 
     if(err != 0) return err;
 
     if(update_dimensions) {
-        curr_texture->w = w;
-        curr_texture->h = h;
+        texture->w = w;
+        texture->h = h;
     }
 
     return 0;
+#else
+    return 1;
+#endif
 }
 
-void bs_textureMinMag(int min_filter, int mag_filter) {
-    glTexParameteri(curr_texture->type, GL_TEXTURE_MIN_FILTER, min_filter);
-    glTexParameteri(curr_texture->type, GL_TEXTURE_MAG_FILTER, mag_filter);
+// - containers -
+static bs_U32 bs_read32(const bs_U8* p) {
+    bs_U32 value;
+    memcpy(&value, p, sizeof(value));
+    return value;
 }
 
-void bs_pushTexture(int internal_format, int format, int type) {
-    glTexImage2D(
-        curr_texture->type,
-        0,
-        internal_format,
-        curr_texture->w,
-        curr_texture->h,
-        0,
-        format,
-        type,
-        curr_texture->data
-    );
+static bs_U64 bs_read64(const bs_U8* p) {
+    bs_U64 value;
+    memcpy(&value, p, sizeof(value));
+    return value;
 }
 
-bs_Image* bs_imageTtfAtlas(int dim, bs_U8* data) {
-    bs_Image* img = bs_bufferAppend(&image_buf, NULL);
-    bs_ImageShaderData* img_data = bs_bufferAppend(&image_data_buf, NULL);
+// unlike bs_loadFile() this doesn't throw, it's called from decode jobs
+static bs_U8* bs_readTextureFile(const char* path, bs_U64* size) {
+    FILE* f = fopen(path, "rb");
+    if(f == NULL) {
+        return NULL;
+    }
+
+    fseek(f, 0, SEEK_END);
+    long length = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    bs_U8* data = length > 0 ? malloc(length) : NULL;
+    if(data != NULL && fread(data, 1, length, f) != (size_t)length) {
+        free(data);
+        data = NULL;
+    }
+
+    fclose(f);
+    *size = length;
+    return data;
+}
+
+static bs_U64 bs_chainSize(bs_U32 format, bs_U32 w, bs_U32 h, bs_U32 num_levels) {
+    bs_U64 size = 0;
+    for(bs_U32 level = 0; level < num_levels; level++) {
+        bs_U32 level_w = w >> level, level_h = h >> level;
+        size += bs_levelSize(format, level_w > 0 ? level_w : 1, level_h > 0 ? level_h : 1);
+    }
+
+    return size;
+}
+
+static VkFormat bs_dxgiFormat(bs_U32 dxgi) {
+    switch(dxgi) {
+        case 71: return VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+        case 72: return VK_FORMAT_BC1_RGBA_SRGB_BLOCK;
+        case 74: return VK_FORMAT_BC2_UNORM_BLOCK;
+        case 75: return VK_FORMAT_BC2_SRGB_BLOCK;
+        case 77: return VK_FORMAT_BC3_UNORM_BLOCK;
+        case 78: return VK_FORMAT_BC3_SRGB_BLOCK;
+        case 80: return VK_FORMAT_BC4_UNORM_BLOCK;
+        case 81: return VK_FORMAT_BC4_SNORM_BLOCK;
+        case 83: return VK_FORMAT_BC5_UNORM_BLOCK;
+        case 84: return VK_FORMAT_BC5_SNORM_BLOCK;
+        case 98: return VK_FORMAT_BC7_UNORM_BLOCK;
+        case 99: return VK_FORMAT_BC7_SRGB_BLOCK;
+    }
+
+    return VK_FORMAT_UNDEFINED;
+}
+
+static VkFormat bs_fourccFormat(bs_U32 fourcc) {
+    switch(fourcc) {
+        case BS_FOURCC('D', 'X', 'T', '1'): return VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+        case BS_FOURCC('D', 'X', 'T', '3'): return VK_FORMAT_BC2_UNORM_BLOCK;
+        case BS_FOURCC('D', 'X', 'T', '5'): return VK_FORMAT_BC3_UNORM_BLOCK;
+        case BS_FOURCC('A', 'T', 'I', '1'): return VK_FORMAT_BC4_UNORM_BLOCK;
+        case BS_FOURCC('B', 'C', '4', 'U'): return VK_FORMAT_BC4_UNORM_BLOCK;
+        case BS_FOURCC('A', 'T', 'I', '2'): return VK_FORMAT_BC5_UNORM_BLOCK;
+        case BS_FOURCC('B', 'C', '5', 'U'): return VK_FORMAT_BC5_UNORM_BLOCK;
+    }
+
+    return VK_FORMAT_UNDEFINED;
+}
+
+static bs_U32 bs_parseDds(bs_Texture* texture, const bs_U8* file, bs_U64 size) {
+    if(size < 128 || bs_read32(file + 4) != 124) {
+        return BS_TEXTURE_ERR_CORRUPT;
+    }
+
+    bs_U32 h = bs_read32(file + 12);
+    bs_U32 w = bs_read32(file + 16);
+    bs_U32 num_levels = bs_read32(file + 28);
+    bs_U32 fourcc = bs_read32(file + 84);
+    bs_U64 data_offset = 128;
+
+    VkFormat format;
+    if(fourcc == BS_FOURCC('D', 'X', '1', '0')) {
+        if(size < 148) {
+            return BS_TEXTURE_ERR_CORRUPT;
+        }
+
+        // 3 is a 2D texture, cube maps and arrays aren't supported
+        if(bs_read32(file + 132) != 3 || (bs_read32(file + 136) & 0x4) != 0 || bs_read32(file + 140) > 1) {
+            return BS_TEXTURE_ERR_UNSUPPORTED;
+        }
+
+        format = bs_dxgiFormat(bs_read32(file + 128));
+        data_offset = 148;
+    } else {
+        format = bs_fourccFormat(fourcc);
+    }
+
+    if(format == VK_FORMAT_UNDEFINED) {
+        return BS_TEXTURE_ERR_UNSUPPORTED;
+    }
+
+    if(num_levels == 0) num_levels = 1;
+    if(w == 0 || h == 0) {
+        return BS_TEXTURE_ERR_CORRUPT;
+    }
+
+    // levels past 1x1 can't be uploaded, the ones before them are still usable
+    if(num_levels > bs_fullChain(w, h)) num_levels = bs_fullChain(w, h);
+
+    // levels are stored largest first and tightly packed, which is what bs_textureUploadLevels() takes
+    bs_U64 chain_size = bs_chainSize(format, w, h, num_levels);
+    if(data_offset + chain_size > size) {
+        return BS_TEXTURE_ERR_CORRUPT;
+    }
+
+    texture->data = malloc(chain_size);
+    memcpy(texture->data, file + data_offset, chain_size);
+    texture->w = w;
+    texture->h = h;
+    texture->format = format;
+    texture->mip_levels = num_levels;
+    return 0;
+}
+
+static bs_U32 bs_parseKtx2(bs_Texture* texture, const bs_U8* file, bs_U64 size) {
+    if(size < 80) {
+        return BS_TEXTURE_ERR_CORRUPT;
+    }
+
+    VkFormat format = bs_read32(file + 12);
+    bs_U32 w = bs_read32(file + 20);
+    bs_U32 h = bs_read32(file + 24);
+    bs_U32 depth = bs_read32(file + 28);
+    bs_U32 layers = bs_read32(file + 32);
+    bs_U32 faces = bs_read32(file + 36);
+    bs_U32 num_levels = bs_read32(file + 40);
+    bs_U32 supercompression = bs_read32(file + 44);
+
+    if(depth > 1 || layers > 1 || faces != 1 || supercompression != 0) {
+        return BS_TEXTURE_ERR_UNSUPPORTED;
+    }
+
+    if(bs_blockSize(format) == 0 && format != VK_FORMAT_R8G8B8A8_UNORM && format != VK_FORMAT_R8G8B8A8_SRGB) {
+        return BS_TEXTURE_ERR_UNSUPPORTED;
+    }
+
+    // 0 asks the loader to generate the chain, which only the first level is needed for
+    if(num_levels == 0) num_levels = 1;
+
+    if(w == 0 || h == 0 || 80 + (bs_U64)num_levels * 24 > size) {
+        return BS_TEXTURE_ERR_CORRUPT;
+    }
+
+    // levels past 1x1 can't be uploaded, the ones before them are still usable
+    if(num_levels > bs_fullChain(w, h)) num_levels = bs_fullChain(w, h);
+
+    // the file stores the smallest level first, the level index says where each one is
+    bs_U64 chain_size = bs_chainSize(format, w, h, num_levels);
+    if(chain_size > size) {
+        return BS_TEXTURE_ERR_CORRUPT;
+    }
 
-    // create texture
-    bs_Texture tex;
-    bs_texture(&tex, bs_v2s(dim), GL_TEXTURE_2D);
-    bs_textureMinMag(GL_NEAREST, GL_NEAREST);
-    tex.data = data;
-    bs_pushTexture(GL_RGBA, GL_RED, GL_UBYTE);
+    bs_U8* data = malloc(chain_size);
+    bs_U64 offset = 0;
 
-    // get handle from texture
-    bs_U64 handle = glGetTextureHandleARB(tex.id);
-    glMakeTextureHandleResidentARB(handle);
+    for(bs_U32 level = 0; level < num_levels; level++) {
+        const bs_U8* entry = file + 80 + level * 24;
+        bs_U64 byte_offset = bs_read64(entry);
+        bs_U64 byte_length = bs_read64(entry + 8);
 
-    img_data->handle = handle;
-    img_data->coords = bs_v2s(0.0);
+        bs_U32 level_w = w >> level, level_h = h >> level;
+        bs_U64 level_size = bs_levelSize(format, level_w > 0 ? level_w : 1, level_h > 0 ? level_h : 1);
 
-    img->data = img_data;
-    img->buffer_location = image_buf.size - 1;
+        // compared without adding them, a huge offset would wrap around
+        if(byte_length != level_size || byte_offset > size || byte_length > size - byte_offset) {
+            free(data);
+            return BS_TEXTURE_ERR_CORRUPT;
+        }
+
+        memcpy(data + offset, file + byte_offset, level_size);
+        offset += level_size;
+    }
+
+    texture->data = data;
+    texture->w = w;
+    texture->h = h;
+    texture->format = format;
+    texture->mip_levels = num_levels;
+    return 0;
+}
+
+bs_U32 bs_textureMemory(bs_Texture* texture, const bs_U8* file, bs_U64 size) {
+    static const bs_U8 ktx2_identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+    if(file == NULL) {
+        return BS_TEXTURE_ERR_FILE;
+    }
+
+    bs_U32 err = BS_TEXTURE_ERR_UNSUPPORTED;
+    if(size >= 4 && bs_read32(file) == BS_FOURCC('D', 'D', 'S', ' ')) {
+        err = bs_parseDds(texture, file, size);
+    } else if(size >= 12 && memcmp(file, ktx2_identifier, 12) == 0) {
+        err = bs_parseKtx2(texture, file, size);
+    } else {
+#ifndef BS_NO_PNG
+        unsigned int w, h;
+        if(lodepng_decode32(&texture->data, &w, &h, file, size) == 0) {
+            texture->w = w;
+            texture->h = h;
+            texture->format = VK_FORMAT_R8G8B8A8_SRGB;
+            texture->mip_levels = 1;
+            err = 0;
+        } else {
+            err = BS_TEXTURE_ERR_CORRUPT;
+        }
+#endif
+    }
+
+    return err;
+}
+
+bs_U32 bs_textureFile(bs_Texture* texture, const char* path) {
+    bs_U64 size = 0;
+    bs_U8* file = NULL;
+
+    // packed files are parsed in place
+    bs_MappedFile packed;
+    bool in_pack = bs_packFile(path, &packed);
+    if(in_pack) {
+        file = (bs_U8*)packed.data;
+        size = packed.size;
+    } else {
+        file = bs_readTextureFile(path, &size);
+    }
+
+    bs_U32 err = bs_textureMemory(texture, file, size);
+
+    if(in_pack) {
+        bs_unmapFile(&packed);
+    } else {
+        free(file);
+    }
+
+    return err;
+}
+
+// compressed textures come with their chain, everything else gets a full one generated.
+// without blit support that's a single level, so given levels past it are left out
+static void bs_textureDecoded(bs_Texture* texture, const bs_Texture* decoded) {
+    bs_texture(texture, bs_v2(decoded->w, decoded->h), decoded->format, bs_blockSize(decoded->format) != 0 ? decoded->mip_levels : 0);
+    bs_textureUploadLevels(texture, decoded->data, decoded->mip_levels < texture->mip_levels ? decoded->mip_levels : texture->mip_levels);
+}
+
+static bs_Image* bs_pushImage(const bs_Texture* decoded) {
+    bs_Image* img = bs_alloc(sizeof(bs_Image));
+    bs_bufferAppend(&image_buf, &img);
+
+    bs_textureDecoded(&img->texture, decoded);
+    img->buffer_location = bs_bindlessImage(img->texture.view);
+    img->state = BS_IMAGE_READY;
+    img->load = NULL;
 
     return img;
 }
 
+bs_Image* bs_imageTtfAtlas(int dim, bs_U8* data) {
+    bs_Texture decoded = { 0 };
+    decoded.w = decoded.h = dim;
+    decoded.format = VK_FORMAT_R8_UNORM;
+    decoded.mip_levels = 1;
+    decoded.data = data;
+
+    return bs_pushImage(&decoded);
+}
+
 bs_Image* bs_image(char* path, bs_U32 num_frames) {
-    bs_Image* img = bs_bufferAppend(&image_buf, NULL);
-    bs_ImageShaderData* img_data = bs_bufferAppend(&image_data_buf, NULL);
+    bs_RGBA color = BS_WHITE;
+    bs_Texture decoded = { 0 };
+
+    if(path == NULL) {
+        decoded.w = decoded.h = 1;
+        decoded.format = VK_FORMAT_R8G8B8A8_UNORM;
+        decoded.mip_levels = 1;
+        decoded.data = (unsigned char*)&color;
+        return bs_pushImage(&decoded);
+    }
+
+    if(bs_textureFile(&decoded, path) != 0) {
+        bs_throw("Failed to load image");
+    }
 
-    // create texture
-    bs_Texture tex;
-    bs_texture(&tex, bs_v2s(0), GL_TEXTURE_2D);
-    bs_textureMinMag(GL_NEAREST, GL_NEAREST);
-    if (path != NULL) {
-        bs_textureDataFile(path, true);
+    bs_Image* img = bs_pushImage(&decoded);
+    free(decoded.data);
+
+    return img;
+}
+
+// - streaming -
+static bs_ImageLoad** bs_loadQueue() {
+    return (bs_ImageLoad**)streaming.queue.data;
+}
+
+static void bs_swapLoads(bs_U32 a, bs_U32 b) {
+    bs_ImageLoad** heap = bs_loadQueue();
+    bs_ImageLoad* temp = heap[a];
+    heap[a] = heap[b];
+    heap[b] = temp;
+    heap[a]->heap_index = a;
+    heap[b]->heap_index = b;
+}
+
+static void bs_siftUp(bs_U32 i) {
+    bs_ImageLoad** heap = bs_loadQueue();
+    while(i > 0 && heap[(i - 1) / 2]->priority < heap[i]->priority) {
+        bs_swapLoads(i, (i - 1) / 2);
+        i = (i - 1) / 2;
     }
-    else {
-        // todo remove malloc
-        bs_RGBA color = BS_WHITE;
-        tex.data = bs_alloc(sizeof(bs_RGBA));
-        memcpy(tex.data, &color, sizeof(bs_RGBA));
-        tex.w = tex.h = 1;
+}
+
+static void bs_siftDown(bs_U32 i) {
+    bs_ImageLoad** heap = bs_loadQueue();
+    bs_U32 count = streaming.queue.num_units;
+
+    for(;;) {
+        bs_U32 largest = i;
+        bs_U32 left = i * 2 + 1, right = i * 2 + 2;
+        if(left < count && heap[left]->priority > heap[largest]->priority) largest = left;
+        if(right < count && heap[right]->priority > heap[largest]->priority) largest = right;
+        if(largest == i) return;
+
+        bs_swapLoads(i, largest);
+        i = largest;
+    }
+}
+
+static void bs_removeQueued(bs_U32 i) {
+    bs_U32 last = streaming.queue.num_units - 1;
+    if(i != last) {
+        bs_swapLoads(i, last);
+    }
+
+    streaming.queue.num_units--;
+    if(i < streaming.queue.num_units) {
+        bs_siftDown(i);
+        bs_siftUp(i);
     }
-    bs_pushTexture(GL_RGBA, GL_RGBA, GL_UBYTE);
+}
+
+static void bs_freeLoad(bs_ImageLoad* load) {
+    free(load->decoded.data);
+    bs_free(load->read.dst);
+    bs_free(load->path);
+    bs_free(load);
+}
+
+static void bs_cancelLoad(bs_ImageLoad* load) {
+    // a running read or decode still owns the load, it's freed once collected
+    if(load->state == BS_LOAD_QUEUED) {
+        bs_removeQueued(load->heap_index);
+        bs_freeLoad(load);
+    } else {
+        load->image = NULL;
+    }
+}
+
+static void bs_decodeJob(void* param, bs_U32 index) {
+    bs_ImageLoad* load = param;
+
+    bs_U32 err;
+    if(load->read.dst != NULL) {
+        err = bs_textureMemory(&load->decoded, load->read.dst, load->read.size);
+        load->read.dst = bs_free(load->read.dst);
+    } else {
+        err = bs_textureFile(&load->decoded, load->path);
+    }
+
+    bs_atomicAdd(&load->state, err == 0 ? BS_LOAD_DECODED - BS_LOAD_DECODING : BS_LOAD_FAILED - BS_LOAD_DECODING);
+}
+
+// runs on the main thread, canceled loads skip the decode
+static void bs_imageRead(bs_IoRequest* request) {
+    bs_ImageLoad* load = request->user;
+    if(request->state == BS_IO_FAILED || load->image == NULL) {
+        load->state = BS_LOAD_FAILED;
+        return;
+    }
+
+    load->state = BS_LOAD_DECODING;
+    bs_pushBackgroundJob(bs_decodeJob, load, 0, &streaming.decodes);
+}
+
+bs_Image* bs_imageAsync(const char* path, float priority) {
+    bs_Image* img = bs_alloc(sizeof(bs_Image));
+    memset(img, 0, sizeof(bs_Image));
+    bs_bufferAppend(&image_buf, &img);
 
-    // get handle from texture
-    bs_U64 handle = glGetTextureHandleARB(tex.id);
-    glMakeTextureHandleResidentARB(handle);
+    bs_ImageLoad* load = bs_alloc(sizeof(bs_ImageLoad));
+    memset(load, 0, sizeof(bs_ImageLoad));
+    load->image = img;
+    load->priority = priority;
+    load->path = bs_alloc(strlen(path) + 1);
+    strcpy(load->path, path);
 
-    img_data->handle = handle;
-    img_data->coords = bs_v2s(0.0);
+    img->state = BS_IMAGE_LOADING;
+    img->load = load;
 
-    img->data = img_data;
-    img->buffer_location = image_buf.size - 1;
+    load->heap_index = streaming.queue.num_units;
+    bs_bufferAppend(&streaming.queue, &load);
+    bs_siftUp(load->heap_index);
 
     return img;
 }
 
-void bs_selectTexture(bs_Texture* texture, bs_U32 tex_unit) {
-    if (curr_texture == texture) return;
+void bs_imagePriority(bs_Image* image, float priority) {
+    bs_ImageLoad* load = image->load;
+    if(load == NULL || load->state != BS_LOAD_QUEUED) {
+        return;
+    }
+
+    float old_priority = load->priority;
+    load->priority = priority;
 
-    curr_texture = texture;
-    glActiveTexture(GL_TEXTURE0 + tex_unit);
-    glBindTexture(texture->type, texture->id);
+    if(priority > old_priority) bs_siftUp(load->heap_index);
+    else bs_siftDown(load->heap_index);
 }
 
-void bs_textureArray(bs_Texture *tex, bs_vec2 max_dim, int num_textures) {
-    bs_texture(tex, max_dim, GL_TEXTURE_2D_ARRAY);
-    glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, GL_RGBA8, max_dim.x, max_dim.y, num_textures);
-    bs_textureMinMag(GL_NEAREST, GL_NEAREST);
+bool bs_imageReady(bs_Image* image) {
+    return image->state == BS_IMAGE_READY;
 }
 
-bs_U32 bs_textureArrayAppendPNG(const char *path) {
-    bs_U32 err = bs_textureDataFile(path, true);
-    if (err != 0) return err;
+bs_U32 bs_pendingImages() {
+    return streaming.queue.num_units + streaming.decoding.num_units;
+}
 
-    glTexSubImage3D(
-        curr_texture->type,
-        0,
-        0, 0, curr_texture->frame.z,
-        curr_texture->w, curr_texture->h, 1,
-        GL_RGBA,
-        GL_UBYTE,
-        curr_texture->data
-    );
+void bs_streamImages() {
+    if(streaming.queue.unit_size == 0) {
+        return;
+    }
 
-    curr_texture->frame.z++;
-    free(curr_texture->data);
+    // uploads happen here on the main thread since the staging ring isn't thread safe
+    bs_U64 uploaded = 0;
+    for(bs_U32 i = 0; i < streaming.decoding.num_units;) {
+        bs_ImageLoad* load = *(bs_ImageLoad**)bs_bufferData(&streaming.decoding, i);
+        bs_I32 state = bs_atomicLoad(&load->state);
 
-    return 0;
+        if(state == BS_LOAD_READING || state == BS_LOAD_DECODING || (state == BS_LOAD_DECODED && uploaded > BS_STREAM_BYTES_PER_FRAME)) {
+            i++;
+            continue;
+        }
+
+        bs_Image* img = load->image;
+        if(img != NULL && state == BS_LOAD_DECODED) {
+            bs_textureDecoded(&img->texture, &load->decoded);
+
+            // a fresh slot isn't sampled by any frame in flight, so the image can be used in this frame already
+            img->buffer_location = bs_bindlessImage(img->texture.view);
+            img->state = BS_IMAGE_READY;
+            uploaded += bs_chainSize(load->decoded.format, load->decoded.w, load->decoded.h, load->decoded.mip_levels);
+        } else if(img != NULL) {
+            img->state = BS_IMAGE_FAILED;
+        }
+
+        if(img != NULL) {
+            img->load = NULL;
+        }
+
+        bs_freeLoad(load);
+        *(bs_ImageLoad**)bs_bufferData(&streaming.decoding, i) = *(bs_ImageLoad**)bs_bufferData(&streaming.decoding, streaming.decoding.num_units - 1);
+        streaming.decoding.num_units--;
+    }
+
+    // a couple of decodes per thread keeps every worker busy without holding many decoded images at once.
+    // reads don't occupy a worker, bs_imageRead() hands them to a decode job once they completed
+    bs_U32 max_decoding = bs_numJobThreads() * 2;
+    while(streaming.queue.num_units > 0 && streaming.decoding.num_units < max_decoding) {
+        bs_ImageLoad* load = bs_loadQueue()[0];
+        bs_removeQueued(0);
+        bs_bufferAppend(&streaming.decoding, &load);
+
+        if(bs_inPack(load->path)) {
+            load->state = BS_LOAD_DECODING;
+            bs_pushBackgroundJob(bs_decodeJob, load, 0, &streaming.decodes);
+            continue;
+        }
+
+        load->state = BS_LOAD_READING;
+        load->read.path = load->path;
+        load->read.callback = bs_imageRead;
+        load->read.user = load;
+        bs_readAsync(&load->read);
+    }
 }
 
-void bs_linearFiltering() {
-    filter = GL_LINEAR;
+void bs_freeImage(bs_Image* image) {
+    if(image->load != NULL) {
+        bs_cancelLoad(image->load);
+    }
+
+    if(image->state == BS_IMAGE_READY) {
+        bs_freeBindlessImage(image->buffer_location);
+        bs_freeTexture(&image->texture);
+    }
+
+    for(bs_U32 i = 0; i < image_buf.num_units; i++) {
+        bs_Image** it = bs_bufferData(&image_buf, i);
+        if(*it != image) continue;
+
+        *it = *(bs_Image**)bs_bufferData(&image_buf, image_buf.num_units - 1);
+        image_buf.num_units--;
+        break;
+    }
+
+    bs_free(image);
 }
 
-void bs_nearestFiltering() {
-    filter = GL_NEAREST;
+void bs_freeTextures() {
+    bs_waitJobs(&streaming.decodes);
+
+    for(bs_U32 i = 0; i < streaming.queue.num_units; i++) {
+        bs_freeLoad(bs_loadQueue()[i]);
+    }
+
+    for(bs_U32 i = 0; i < streaming.decoding.num_units; i++) {
+        bs_freeLoad(*(bs_ImageLoad**)bs_bufferData(&streaming.decoding, i));
+    }
+
+    for(bs_U32 i = 0; i < image_buf.num_units; i++) {
+        bs_Image* image = *(bs_Image**)bs_bufferData(&image_buf, i);
+        bs_freeTexture(&image->texture);
+        bs_free(image);
+    }
+
+    bs_waitUpload(bs_flushUploads());
+
+    for(bs_U32 i = 0; i < BS_MAX_FRAMES_IN_FLIGHT; i++) {
+        bs_destroyRetired(textures.retired + i);
+        bs_free(textures.retired[i].data);
+    }
+
+    bs_free(textures.pending.data);
+    bs_free(streaming.queue.data);
+    bs_free(streaming.decoding.data);
+    bs_free(image_buf.data);
+    memset(&textures, 0, sizeof(textures));
+    memset(&streaming, 0, sizeof(streaming));
+    memset(&image_buf, 0, sizeof(image_buf));
 }
 
-static void bs_textureColor(bs_Texture *texture, bs_vec2 dim, int internal_format, int format, int type, bs_U8* data) {
-    bs_texture(texture, dim, GL_TEXTURE_2D);
-    bs_textureMinMag(filter, filter);
-    texture->data = data;
-    bs_pushTexture(internal_format, format, type);
-    texture->attachment = GL_COLOR_ATTACHMENT0;
+static void bs_textureColor(bs_Texture *texture, bs_vec2 dim, bs_U32 format, bs_U8* data) {
+    bs_texture(texture, dim, format, 1);
+    if(data != NULL) {
+        bs_textureUpload(texture, data);
+    }
 }
 
-// Maybe make these macros?
-void bs_depthStencil(bs_Texture *texture, bs_vec2 dim, bs_U8* data) {
-    bs_textureColor(texture, dim, GL_DEPTH24_STENCIL8, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, data);
-    texture->attachment = GL_DEPTH_STENCIL_ATTACHMENT;
+void bs_depthStencil(bs_Texture *texture, bs_vec2 dim) {
+    bs_createTexture(texture, dim, VK_FORMAT_D24_UNORM_S8_UINT, 1, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_IMAGE_ASPECT_DEPTH_BIT);
 }
 
-void bs_depth(bs_Texture *texture, bs_vec2 dim, bs_U8* data) {
-    bs_textureColor(texture, dim, GL_DEPTH_COMPONENT, GL_DEPTH_COMPONENT, GL_FLOAT, data);
-    texture->attachment = GL_DEPTH_ATTACHMENT;
+void bs_depth(bs_Texture *texture, bs_vec2 dim) {
+    bs_createTexture(texture, dim, VK_FORMAT_D32_SFLOAT, 1, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_IMAGE_ASPECT_DEPTH_BIT);
 }
 
-void bs_textureR(bs_Texture* texture, bs_vec2 dim, bs_U8* data) { bs_textureColor(texture, dim, GL_R8, GL_RED, GL_UNSIGNED_BYTE, data); }
-void bs_textureRG(bs_Texture *texture, bs_vec2 dim, bs_U8* data) { bs_textureColor(texture, dim, GL_RG8, GL_RG, GL_UNSIGNED_BYTE, data); }
-void bs_textureRGB(bs_Texture *texture, bs_vec2 dim, bs_U8* data) { bs_textureColor(texture, dim, GL_RGB8, GL_RGB, GL_UNSIGNED_BYTE, data); }
-void bs_textureRGB16f(bs_Texture *texture, bs_vec2 dim, bs_U8* data) { bs_textureColor(texture, dim, GL_RGB16F, GL_RGB, GL_FLOAT, data); }
-void bs_textureRGB32f(bs_Texture *texture, bs_vec2 dim, bs_U8* data) { bs_textureColor(texture, dim, GL_RGB32F, GL_RGB, GL_FLOAT, data); }
-void bs_textureRGBA(bs_Texture *texture, bs_vec2 dim, bs_U8* data) { bs_textureColor(texture, dim, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, data); }
-void bs_textureRGBA16f(bs_Texture *texture, bs_vec2 dim, bs_U8* data) { bs_textureColor(texture, dim, GL_RGBA16F, GL_RGBA, GL_FLOAT, data); }
-void bs_textureRGBA32f(bs_Texture *texture, bs_vec2 dim, bs_U8* data) { bs_textureColor(texture, dim, GL_RGBA32F, GL_RGBA, GL_FLOAT, data); }
-void bs_texture_11_11_10(bs_Texture *texture, bs_vec2 dim, bs_U8* data) { bs_textureColor(texture, dim, GL_R11F_G11F_B10F, GL_RGB, GL_FLOAT, data); }
-void bs_textureR16U(bs_Texture *texture, bs_vec2 dim, bs_U8* data) { bs_textureColor(texture, dim, GL_RGB16UI, GL_RED_INTEGER, GL_UNSIGNED_INT, data); }
\ No newline at end of file
+void bs_textureR(bs_Texture* texture, bs_vec2 dim, bs_U8* data) { bs_textureColor(texture, dim, VK_FORMAT_R8_UNORM, data); }
+void bs_textureRG(bs_Texture *texture, bs_vec2 dim, bs_U8* data) { bs_textureColor(texture, dim, VK_FORMAT_R8G8_UNORM, data); }
+void bs_textureRGBA(bs_Texture *texture, bs_vec2 dim, bs_U8* data) { bs_textureColor(texture, dim, VK_FORMAT_R8G8B8A8_UNORM, data); }
+void bs_textureRGBA16f(bs_Texture *texture, bs_vec2 dim, bs_U8* data) { bs_textureColor(texture, dim, VK_FORMAT_R16G16B16A16_SFLOAT, data); }
+void bs_textureRGBA32f(bs_Texture *texture, bs_vec2 dim, bs_U8* data) { bs_textureColor(texture, dim, VK_FORMAT_R32G32B32A32_SFLOAT, data); }
+void bs_texture_11_11_10(bs_Texture *texture, bs_vec2 dim, bs_U8* data) { bs_textureColor(texture, dim, VK_FORMAT_B10G11R11_UFLOAT_PACK32, data); }
+void bs_textureR16U(bs_Texture *texture, bs_vec2 dim, bs_U8* data) { bs_textureColor(texture, dim, VK_FORMAT_R16_UINT, data); }
@@ -7,6 +7,7 @@
 #include <bs_ttf.h>
 #include <bs_wnd.h>
 #include <bs_mem.h>
+#include <bs_pack.h>
 #include <bs_math.h>
 #include <bs_core.h>
 #include <bs_shaders.h>
@@ -422,9 +423,11 @@ static void bs_rasterizeGlyph(bs_Glyf* glyf, int idx, char* out_bmp, int dim, in
 
 bs_Font bs_loadFont(const char* path, const char* alphabet, const char* output_name) {
     bs_Font ttf = { 0 };
-    const char* buf = bs_loadFile(path, &ttf.data_len);
 
-    ttf.buf = buf;
+    // tables are looked up all over the file
+    bs_MappedFile file = bs_mapAsset(path, BS_MAP_RANDOM);
+    ttf.buf = (char*)file.data;
+    ttf.data_len = file.size;
     ttf.glyf.buf = NULL;
 
     // metadata gathering
@@ -488,6 +491,8 @@ bs_Font bs_loadFont(const char* path, const char* alphabet, const char* output_n
 
     bs_textureR(&ttf.texture, bs_v2s(dim), atlas);
 
-    free(buf);
+    bs_unmapFile(&file);
+    ttf.buf = NULL;
+    ttf.glyf.buf = NULL;
     return ttf;
 }
\ No newline at end of file
@@ -0,0 +1,308 @@
+#include <bs_types.h>
+#include <bs_mem.h>
+#include <bs_ini.h>
+#include <bs_vram.h>
+
+#include <string.h>
+
+#include <vulkan.h>
+
+typedef struct {
+    VkDeviceSize offset;
+    VkDeviceSize size;
+} bs_VramRange;
+
+typedef struct {
+    VkDeviceMemory memory;
+    VkDeviceSize size;
+    VkDeviceSize used;
+    bs_U8* mapped;
+
+    bool dedicated;
+    bs_U32 num_allocations;
+
+    // bs_VramRange, sorted by offset and never adjacent
+    bs_Buffer free_ranges;
+} bs_VramBlock;
+
+// pools are indexed by memory type * 2 + optimal, linear buffers and optimal images never
+// share a block so bufferImageGranularity never has to be accounted for
+static struct {
+    VkPhysicalDeviceMemoryProperties props;
+    bool queried;
+
+    bs_Buffer pools[VK_MAX_MEMORY_TYPES * 2];
+} vram = { 0 };
+
+static void bs_vramQuery() {
+    if(vram.queried) return;
+
+    vkGetPhysicalDeviceMemoryProperties(bs_vkPhysicalDevice(), &vram.props);
+    vram.queried = true;
+}
+
+bs_U32 bs_vramMemoryType(bs_U32 filter, bs_U32 properties) {
+    bs_vramQuery();
+
+    for (uint32_t i = 0; i < vram.props.memoryTypeCount; i++) {
+        if ((filter & (1 << i)) && (vram.props.memoryTypes[i].propertyFlags & properties) == properties) {
+            return i;
+        }
+    }
+
+    bs_throw("Failed to find memory type");
+    return 0;
+}
+
+static VkDeviceSize bs_vramBlockSize(bs_U32 type) {
+    VkDeviceSize heap_size = vram.props.memoryHeaps[vram.props.memoryTypes[type].heapIndex].size;
+    VkDeviceSize size = heap_size / 8;
+
+    return size < BS_VRAM_BLOCK_SIZE ? size : BS_VRAM_BLOCK_SIZE;
+}
+
+static void bs_vramInsertRange(bs_Buffer* ranges, bs_U32 index, VkDeviceSize offset, VkDeviceSize size) {
+    bs_bufferAppend(ranges, NULL);
+
+    bs_VramRange* data = (bs_VramRange*)ranges->data;
+    memmove(data + index + 1, data + index, (ranges->num_units - 1 - index) * sizeof(bs_VramRange));
+
+    data[index].offset = offset;
+    data[index].size = size;
+}
+
+static void bs_vramRemoveRange(bs_Buffer* ranges, bs_U32 index) {
+    bs_VramRange* data = (bs_VramRange*)ranges->data;
+    memmove(data + index, data + index + 1, (ranges->num_units - 1 - index) * sizeof(bs_VramRange));
+    ranges->num_units--;
+}
+
+// first fit, the padding in front of an aligned range stays in the free list
+static bool bs_vramBlockAlloc(bs_VramBlock* block, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize* out_offset) {
+    for(bs_U32 i = 0; i < block->free_ranges.num_units; i++) {
+        bs_VramRange* range = bs_bufferData(&block->free_ranges, i);
+
+        VkDeviceSize offset = (range->offset + alignment - 1) / alignment * alignment;
+        VkDeviceSize padding = offset - range->offset;
+        if(padding + size > range->size) continue;
+
+        VkDeviceSize tail = range->size - padding - size;
+
+        if(padding == 0 && tail == 0) {
+            bs_vramRemoveRange(&block->free_ranges, i);
+        } else if(padding == 0) {
+            range->offset += size;
+            range->size = tail;
+        } else {
+            range->size = padding;
+            if(tail != 0) {
+                bs_vramInsertRange(&block->free_ranges, i + 1, offset + size, tail);
+            }
+        }
+
+        block->used += size;
+        block->num_allocations++;
+        *out_offset = offset;
+        return true;
+    }
+
+    return false;
+}
+
+static void bs_vramBlockFree(bs_VramBlock* block, VkDeviceSize offset, VkDeviceSize size) {
+    bs_Buffer* ranges = &block->free_ranges;
+
+    // find the first free range after the freed one
+    bs_U32 lo = 0, hi = ranges->num_units;
+    while(lo < hi) {
+        bs_U32 mid = (lo + hi) / 2;
+        if(((bs_VramRange*)bs_bufferData(ranges, mid))->offset < offset) lo = mid + 1;
+        else hi = mid;
+    }
+
+    bs_VramRange* prev = lo > 0 ? bs_bufferData(ranges, lo - 1) : NULL;
+    bs_VramRange* next = lo < ranges->num_units ? bs_bufferData(ranges, lo) : NULL;
+
+    bool merge_prev = prev != NULL && prev->offset + prev->size == offset;
+    bool merge_next = next != NULL && offset + size == next->offset;
+
+    if(merge_prev && merge_next) {
+        prev->size += size + next->size;
+        bs_vramRemoveRange(ranges, lo);
+    } else if(merge_prev) {
+        prev->size += size;
+    } else if(merge_next) {
+        next->offset = offset;
+        next->size += size;
+    } else {
+        bs_vramInsertRange(ranges, lo, offset, size);
+    }
+
+    block->used -= size;
+    block->num_allocations--;
+}
+
+static bs_U32 bs_vramBlock(bs_Buffer* pool, bs_U32 type, VkDeviceSize size, bool dedicated) {
+    VkMemoryAllocateInfo alloc_i = { 0 };
+    alloc_i.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    alloc_i.allocationSize = size;
+    alloc_i.memoryTypeIndex = type;
+
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    BS_VK_ERR(vkAllocateMemory(bs_vkDevice(), &alloc_i, NULL, &memory), "Failed to allocate device memory block");
+
+    // reuse the slot of a released block
+    bs_U32 index = 0;
+    for(; index < pool->num_units; index++) {
+        if(((bs_VramBlock*)bs_bufferData(pool, index))->memory == VK_NULL_HANDLE) break;
+    }
+
+    bs_VramBlock* block = (index == pool->num_units) ? bs_bufferAppend(pool, NULL) : bs_bufferData(pool, index);
+    block->memory = memory;
+    block->size = size;
+    block->used = 0;
+    block->mapped = NULL;
+    block->dedicated = dedicated;
+    block->num_allocations = 0;
+
+    if(block->free_ranges.unit_size == 0) {
+        block->free_ranges = bs_buffer(sizeof(bs_VramRange), 16, 16, 0);
+    }
+
+    block->free_ranges.num_units = 0;
+    bs_vramInsertRange(&block->free_ranges, 0, 0, size);
+
+    if(vram.props.memoryTypes[type].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+        BS_VK_ERR(vkMapMemory(bs_vkDevice(), memory, 0, VK_WHOLE_SIZE, 0, (void**)&block->mapped), "Failed to map device memory block");
+    }
+
+    return index;
+}
+
+static void bs_vramReleaseBlock(bs_VramBlock* block) {
+    if(block->mapped != NULL) {
+        vkUnmapMemory(bs_vkDevice(), block->memory);
+    }
+
+    vkFreeMemory(bs_vkDevice(), block->memory, NULL);
+    block->memory = VK_NULL_HANDLE;
+    block->mapped = NULL;
+    block->free_ranges.num_units = 0;
+}
+
+bs_VramAllocation bs_vramAlloc(bs_U64 size, bs_U64 alignment, bs_U32 type_filter, bs_U32 properties, bool optimal) {
+    bs_U32 type = bs_vramMemoryType(type_filter, properties);
+    bs_U32 pool_index = type * 2 + (optimal ? 1 : 0);
+    bs_Buffer* pool = vram.pools + pool_index;
+
+    if(pool->unit_size == 0) {
+        *pool = bs_buffer(sizeof(bs_VramBlock), 4, 4, 0);
+    }
+
+    if(alignment == 0) {
+        alignment = 1;
+    }
+
+    bs_VramAllocation allocation = { 0 };
+    allocation.pool = pool_index;
+    allocation.size = size;
+
+    VkDeviceSize block_size = bs_vramBlockSize(type);
+    VkDeviceSize offset = 0;
+    bool found = false;
+
+    // large resources get their own allocation rather than fragmenting a block
+    if(size > block_size / 2) {
+        allocation.block = bs_vramBlock(pool, type, size, true);
+        found = bs_vramBlockAlloc(bs_bufferData(pool, allocation.block), size, alignment, &offset);
+    }
+
+    for(bs_U32 i = 0; i < pool->num_units && !found; i++) {
+        bs_VramBlock* block = bs_bufferData(pool, i);
+        if(block->memory == VK_NULL_HANDLE || block->dedicated) continue;
+        if(block->size - block->used < size) continue;
+
+        if(bs_vramBlockAlloc(block, size, alignment, &offset)) {
+            allocation.block = i;
+            found = true;
+        }
+    }
+
+    if(!found) {
+        allocation.block = bs_vramBlock(pool, type, block_size, false);
+        found = bs_vramBlockAlloc(bs_bufferData(pool, allocation.block), size, alignment, &offset);
+    }
+
+    if(!found) {
+        bs_throw("Failed to suballocate device memory");
+    }
+
+    bs_VramBlock* block = bs_bufferData(pool, allocation.block);
+    allocation.memory = block->memory;
+    allocation.offset = offset;
+    allocation.mapped = block->mapped == NULL ? NULL : block->mapped + offset;
+
+    return allocation;
+}
+
+void bs_vramFree(bs_VramAllocation* allocation) {
+    if(allocation->memory == NULL) return;
+
+    bs_Buffer* pool = vram.pools + allocation->pool;
+    bs_VramBlock* block = bs_bufferData(pool, allocation->block);
+    bs_vramBlockFree(block, allocation->offset, allocation->size);
+
+    if(block->num_allocations == 0) {
+        // keep one empty block per pool around so alloc/free pairs don't hit the driver
+        bool keep = !block->dedicated;
+        for(bs_U32 i = 0; i < pool->num_units && keep; i++) {
+            bs_VramBlock* other = bs_bufferData(pool, i);
+            if(other != block && other->memory != VK_NULL_HANDLE && !other->dedicated && other->num_allocations == 0) {
+                keep = false;
+            }
+        }
+
+        if(!keep) {
+            bs_vramReleaseBlock(block);
+        }
+    }
+
+    memset(allocation, 0, sizeof(bs_VramAllocation));
+}
+
+bs_VramStats bs_vramStats() {
+    bs_VramStats stats = { 0 };
+
+    for(int i = 0; i < VK_MAX_MEMORY_TYPES * 2; i++) {
+        for(bs_U32 j = 0; j < vram.pools[i].num_units; j++) {
+            bs_VramBlock* block = bs_bufferData(vram.pools + i, j);
+            if(block->memory == VK_NULL_HANDLE) continue;
+
+            if(block->dedicated) stats.num_dedicated++;
+            else stats.num_blocks++;
+
+            stats.num_allocations += block->num_allocations;
+            stats.block_bytes += block->size;
+            stats.used_bytes += block->used;
+        }
+    }
+
+    return stats;
+}
+
+void bs_freeVram() {
+    for(int i = 0; i < VK_MAX_MEMORY_TYPES * 2; i++) {
+        for(bs_U32 j = 0; j < vram.pools[i].num_units; j++) {
+            bs_VramBlock* block = bs_bufferData(vram.pools + i, j);
+
+            if(block->memory != VK_NULL_HANDLE) {
+                bs_vramReleaseBlock(block);
+            }
+
+            bs_free(block->free_ranges.data);
+        }
+
+        vram.pools[i].data = bs_free(vram.pools[i].data);
+        vram.pools[i].num_units = vram.pools[i].capacity = 0;
+    }
+}
@@ -0,0 +1,630 @@
+#include <bs_types.h>
+#include <bs_math.h>
+#include <bs_ini.h>
+#include <bs_mem.h>
+#include <bs_io.h>
+#include <bs_staging.h>
+#include <bs_shaders.h>
+#include <bs_descriptors.h>
+#include <bs_textures.h>
+#include <bs_vtex.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vulkan.h>
+
+#define BS_VTEX_PAGE_TEXELS (BS_VTEX_PAGE_SIZE + 2 * BS_VTEX_BORDER)
+#define BS_VTEX_PAGE_BYTES (BS_VTEX_PAGE_TEXELS * BS_VTEX_PAGE_TEXELS * 4)
+// magic, width, height, levels, page size, border
+#define BS_VTEX_HEADER_SIZE 24
+#define BS_VTEX_NONE 0xFFFFFFFF
+
+#define BS_PAGE_LOAD_FREE 0
+#define BS_PAGE_LOAD_READING 1
+#define BS_PAGE_LOAD_DONE 2
+#define BS_PAGE_LOAD_FAILED 3
+
+typedef struct {
+    // kept open for the page reads
+    bs_IoFile file;
+    bs_U32 w, h;
+    bs_U32 num_levels;
+    bs_U32 first_entry;
+
+    // relative to first_entry
+    bs_U32 level_offsets[BS_VTEX_MAX_LEVELS];
+    bs_U32 pages_x[BS_VTEX_MAX_LEVELS];
+    bs_U32 pages_y[BS_VTEX_MAX_LEVELS];
+
+    // pages of the coarsest level that aren't resident yet
+    bs_U32 base_missing;
+} bs_VtexSource;
+
+typedef struct {
+    // page table entry held by the page, BS_VTEX_NONE when free
+    bs_U32 entry;
+    bool pinned;
+
+    // least recently used list, pinned pages aren't in it
+    bs_U32 prev;
+    bs_U32 next;
+    bs_U64 last_used;
+} bs_PhysicalPage;
+
+typedef struct {
+    bs_I32 state;
+    bs_U32 entry;
+    bs_IoRequest read;
+    bs_U8* texels;
+} bs_PageLoad;
+
+typedef struct {
+    VkDeviceSize offset;
+    bs_U32 page;
+} bs_PageCopy;
+
+static struct {
+    bs_Texture atlas;
+    bs_U32 atlas_slot;
+    bs_U32 atlas_pages;
+
+    bs_Space pages_space;
+    bs_Space feedback_space;
+
+    // per page table entry
+    bs_U32* table;
+    bs_U32* physical;
+    bs_U8* source_of;
+    bs_U8* loading;
+    bs_U32 max_entries;
+    bs_U32 num_entries;
+    bs_U32 dirty_begin;
+    bs_U32 dirty_end;
+
+    bs_VtexSource sources[BS_VTEX_MAX_TEXTURES];
+    bs_U32 num_sources;
+
+    bs_PhysicalPage* pages;
+    bs_U32 num_pages;
+    bs_U32* free_pages;
+    bs_U32 num_free;
+    // most recently used first
+    bs_U32 lru_head;
+    bs_U32 lru_tail;
+
+    bs_PageLoad loads[BS_VTEX_MAX_LOADS];
+
+    // bs_U32 entries requested by this frame's feedback, per level
+    bs_Buffer requests[BS_VTEX_MAX_LEVELS];
+    // bs_PageCopy, staged this submit and recorded by bs_recordPageCopies()
+    bs_Buffer copies;
+} vtex = { 0 };
+
+// - page table -
+static void bs_entryCoords(bs_U32 entry, bs_VtexSource** source, bs_U32* level, bs_U32* x, bs_U32* y) {
+    *source = vtex.sources + vtex.source_of[entry];
+    bs_U32 local = entry - (*source)->first_entry;
+
+    *level = 0;
+    while(*level + 1 < (*source)->num_levels && local >= (*source)->level_offsets[*level + 1]) {
+        (*level)++;
+    }
+
+    local -= (*source)->level_offsets[*level];
+    *x = local % (*source)->pages_x[*level];
+    *y = local / (*source)->pages_x[*level];
+}
+
+static bs_U32 bs_entryIndex(bs_VtexSource* source, bs_U32 level, bs_U32 x, bs_U32 y) {
+    return source->first_entry + source->level_offsets[level] + y * source->pages_x[level] + x;
+}
+
+// the page itself if it's resident, otherwise the closest coarser one that is
+static bs_U32 bs_entryValue(bs_VtexSource* source, bs_U32 level, bs_U32 x, bs_U32 y) {
+    for(bs_U32 k = level; k < source->num_levels; k++) {
+        // levels are floored, so the last page of a level can belong past the last page of the next one
+        bs_U32 kx = x >> (k - level), ky = y >> (k - level);
+        if(kx >= source->pages_x[k]) kx = source->pages_x[k] - 1;
+        if(ky >= source->pages_y[k]) ky = source->pages_y[k] - 1;
+
+        bs_U32 page = vtex.physical[bs_entryIndex(source, k, kx, ky)];
+        if(page != BS_VTEX_NONE) {
+            return (page % vtex.atlas_pages) | ((page / vtex.atlas_pages) << 10) | (k << 20) | BS_VTEX_ENTRY_VALID;
+        }
+    }
+
+    return 0;
+}
+
+// recomputes an entry and every finer entry under it, called whenever its residency changes
+static void bs_refreshEntries(bs_U32 entry) {
+    bs_VtexSource* source;
+    bs_U32 level, x, y;
+    bs_entryCoords(entry, &source, &level, &x, &y);
+
+    for(bs_I32 l = level; l >= 0; l--) {
+        bs_U32 scale = level - l;
+        bs_U32 x0 = x << scale, y0 = y << scale;
+        bs_U32 x1 = x + 1 == source->pages_x[level] ? source->pages_x[l] : (x + 1) << scale;
+        bs_U32 y1 = y + 1 == source->pages_y[level] ? source->pages_y[l] : (y + 1) << scale;
+        if(x1 > source->pages_x[l]) x1 = source->pages_x[l];
+        if(y1 > source->pages_y[l]) y1 = source->pages_y[l];
+
+        for(bs_U32 py = y0; py < y1; py++) {
+            for(bs_U32 px = x0; px < x1; px++) {
+                bs_U32 index = bs_entryIndex(source, l, px, py);
+                bs_U32 value = bs_entryValue(source, l, px, py);
+                if(vtex.table[index] == value) continue;
+
+                vtex.table[index] = value;
+                if(vtex.dirty_begin == vtex.dirty_end) {
+                    vtex.dirty_begin = index;
+                    vtex.dirty_end = index + 1;
+                } else {
+                    if(index < vtex.dirty_begin) vtex.dirty_begin = index;
+                    if(index + 1 > vtex.dirty_end) vtex.dirty_end = index + 1;
+                }
+            }
+        }
+    }
+}
+
+// - physical pages -
+static void bs_unlinkPage(bs_U32 page) {
+    bs_PhysicalPage* p = vtex.pages + page;
+    if(p->prev != BS_VTEX_NONE) vtex.pages[p->prev].next = p->next;
+    else vtex.lru_head = p->next;
+
+    if(p->next != BS_VTEX_NONE) vtex.pages[p->next].prev = p->prev;
+    else vtex.lru_tail = p->prev;
+}
+
+static void bs_pushPage(bs_U32 page) {
+    bs_PhysicalPage* p = vtex.pages + page;
+    p->prev = BS_VTEX_NONE;
+    p->next = vtex.lru_head;
+
+    if(vtex.lru_head != BS_VTEX_NONE) vtex.pages[vtex.lru_head].prev = page;
+    else vtex.lru_tail = page;
+
+    vtex.lru_head = page;
+}
+
+static void bs_touchPage(bs_U32 page, bs_U64 frame_num) {
+    bs_PhysicalPage* p = vtex.pages + page;
+    p->last_used = frame_num;
+
+    if(p->pinned || vtex.lru_head == page) {
+        return;
+    }
+
+    bs_unlinkPage(page);
+    bs_pushPage(page);
+}
+
+// a free page, or the least recently used one if no frame asked for it this time around
+static bs_U32 bs_acquirePage(bs_U64 frame_num) {
+    if(vtex.num_free > 0) {
+        return vtex.free_pages[--vtex.num_free];
+    }
+
+    bs_U32 page = vtex.lru_tail;
+    if(page == BS_VTEX_NONE || vtex.pages[page].last_used == frame_num) {
+        return BS_VTEX_NONE;
+    }
+
+    bs_unlinkPage(page);
+
+    bs_U32 entry = vtex.pages[page].entry;
+    vtex.physical[entry] = BS_VTEX_NONE;
+    bs_refreshEntries(entry);
+
+    return page;
+}
+
+// - uploads -
+static void bs_atlasBarrier(VkCommandBuffer command_buffer, VkImageLayout old_layout, VkImageLayout new_layout, VkAccessFlags src_access, VkAccessFlags dst_access, VkPipelineStageFlags src_stage, VkPipelineStageFlags dst_stage) {
+    VkImageMemoryBarrier barrier = { 0 };
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcAccessMask = src_access;
+    barrier.dstAccessMask = dst_access;
+    barrier.oldLayout = old_layout;
+    barrier.newLayout = new_layout;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = vtex.atlas.image;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.levelCount = 1;
+    barrier.subresourceRange.layerCount = 1;
+
+    vkCmdPipelineBarrier(command_buffer, src_stage, dst_stage, 0, 0, NULL, 0, NULL, 1, &barrier);
+}
+
+// the first barrier also orders the copies after frames submitted earlier that might still sample a reused page
+// the atlas is sampled every frame, so its copies stay on the graphics queue instead of moving ownership back and forth
+static void bs_recordPageCopies(void* transfer_buffer) {
+    if(vtex.copies.num_units == 0) {
+        return;
+    }
+
+    VkCommandBuffer command_buffer = bs_uploadGraphicsCommandBuffer();
+
+    VkPipelineStageFlags shader_stages = VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+    bs_atlasBarrier(command_buffer, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_ACCESS_SHADER_READ_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, shader_stages, VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+    VkBufferImageCopy regions[BS_VTEX_MAX_LOADS];
+    for(bs_U32 i = 0; i < vtex.copies.num_units;) {
+        bs_U32 num_regions = 0;
+
+        for(; i < vtex.copies.num_units && num_regions < BS_VTEX_MAX_LOADS; i++) {
+            bs_PageCopy* copy = bs_bufferData(&vtex.copies, i);
+            VkBufferImageCopy* region = regions + num_regions++;
+
+            memset(region, 0, sizeof(VkBufferImageCopy));
+            region->bufferOffset = copy->offset;
+            region->imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            region->imageSubresource.layerCount = 1;
+            region->imageOffset.x = (copy->page % vtex.atlas_pages) * BS_VTEX_PAGE_TEXELS;
+            region->imageOffset.y = (copy->page / vtex.atlas_pages) * BS_VTEX_PAGE_TEXELS;
+            region->imageExtent.width = BS_VTEX_PAGE_TEXELS;
+            region->imageExtent.height = BS_VTEX_PAGE_TEXELS;
+            region->imageExtent.depth = 1;
+        }
+
+        vkCmdCopyBufferToImage(command_buffer, bs_stagingBuffer(), vtex.atlas.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, num_regions, regions);
+    }
+
+    bs_atlasBarrier(command_buffer, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, shader_stages);
+    vtex.copies.num_units = 0;
+}
+
+static void bs_pageRead(bs_IoRequest* request) {
+    bs_PageLoad* load = request->user;
+    load->state = request->state == BS_IO_DONE ? BS_PAGE_LOAD_DONE : BS_PAGE_LOAD_FAILED;
+}
+
+// - public -
+void bs_prepareVirtualTextures(bs_U32 max_entries, bs_U32 atlas_pages) {
+    if(atlas_pages == 0 || atlas_pages > 1024) {
+        bs_throw("Virtual texture atlas has to be 1 to 1024 pages wide");
+    }
+
+    // page table entries fit 1024 pages per side, the device may fit fewer
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(bs_vkPhysicalDevice(), &properties);
+    bs_U32 max_pages = properties.limits.maxImageDimension2D / BS_VTEX_PAGE_TEXELS;
+    if(atlas_pages > max_pages) {
+        atlas_pages = max_pages;
+    }
+
+    vtex.atlas_pages = atlas_pages;
+    vtex.max_entries = max_entries;
+
+    bs_texture(&vtex.atlas, bs_v2s(atlas_pages * BS_VTEX_PAGE_TEXELS), VK_FORMAT_R8G8B8A8_SRGB, 1);
+    bs_atlasBarrier(bs_uploadGraphicsCommandBuffer(), VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 0, VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+    vtex.atlas_slot = bs_bindlessImage(vtex.atlas.view);
+
+    bs_Buffer pages_buf = { 0 };
+    pages_buf.unit_size = sizeof(bs_U32);
+    pages_buf.max_units = max_entries;
+    vtex.pages_space = bs_shaderSpace(pages_buf, BS_SPACE_VTEX_PAGES, BS_STD430);
+
+    bs_Buffer feedback_buf = { 0 };
+    feedback_buf.unit_size = sizeof(bs_U32);
+    feedback_buf.max_units = (max_entries + 31) / 32;
+    vtex.feedback_space = bs_shaderSpace(feedback_buf, BS_SPACE_VTEX_FEEDBACK, BS_STD430);
+
+    vtex.table = bs_alloc(max_entries * sizeof(bs_U32));
+    vtex.physical = bs_alloc(max_entries * sizeof(bs_U32));
+    vtex.source_of = bs_alloc(max_entries);
+    vtex.loading = bs_alloc(max_entries);
+
+    vtex.num_pages = atlas_pages * atlas_pages;
+    vtex.pages = bs_alloc(vtex.num_pages * sizeof(bs_PhysicalPage));
+    vtex.free_pages = bs_alloc(vtex.num_pages * sizeof(bs_U32));
+    vtex.lru_head = vtex.lru_tail = BS_VTEX_NONE;
+
+    // popped from the back, so page 0 is handed out first
+    for(bs_U32 i = 0; i < vtex.num_pages; i++) {
+        vtex.pages[i].entry = BS_VTEX_NONE;
+        vtex.free_pages[i] = vtex.num_pages - 1 - i;
+    }
+
+    vtex.num_free = vtex.num_pages;
+
+    for(bs_U32 i = 0; i < BS_VTEX_MAX_LOADS; i++) {
+        vtex.loads[i].texels = bs_alloc(BS_VTEX_PAGE_BYTES);
+    }
+
+    for(bs_U32 i = 0; i < BS_VTEX_MAX_LEVELS; i++) {
+        vtex.requests[i] = bs_buffer(sizeof(bs_U32), 64, 64, 0);
+    }
+
+    vtex.copies = bs_buffer(sizeof(bs_PageCopy), BS_VTEX_UPLOADS_PER_FRAME, BS_VTEX_UPLOADS_PER_FRAME, 0);
+    bs_stagingFlushCallback(bs_recordPageCopies);
+}
+
+bs_VirtualTexture bs_virtualTexture(const char* path) {
+    if(vtex.num_sources == BS_VTEX_MAX_TEXTURES) {
+        bs_throw("More than BS_VTEX_MAX_TEXTURES virtual textures");
+    }
+
+    bs_U32 header[BS_VTEX_HEADER_SIZE / 4];
+    FILE* f = fopen(path, "rb");
+    if(f == NULL) {
+        bs_throw("Failed to open virtual texture");
+    }
+
+    size_t read = fread(header, 1, BS_VTEX_HEADER_SIZE, f);
+    fclose(f);
+
+    if(read != BS_VTEX_HEADER_SIZE || header[0] != BS_FOURCC('B', 'S', 'V', 'T')) {
+        bs_throw("Not a virtual texture page file");
+    }
+
+    if(header[4] != BS_VTEX_PAGE_SIZE || header[5] != BS_VTEX_BORDER || header[3] == 0 || header[3] > BS_VTEX_MAX_LEVELS) {
+        bs_throw("Virtual texture was cooked with a different page layout");
+    }
+
+    bs_U32 id = vtex.num_sources;
+    bs_VtexSource* source = vtex.sources + id;
+    memset(source, 0, sizeof(bs_VtexSource));
+    source->w = header[1];
+    source->h = header[2];
+    source->num_levels = header[3];
+    source->first_entry = vtex.num_entries;
+
+    bs_U32 num_entries = 0;
+    for(bs_U32 level = 0; level < source->num_levels; level++) {
+        bs_U32 w = source->w >> level, h = source->h >> level;
+        source->pages_x[level] = ((w > 0 ? w : 1) + BS_VTEX_PAGE_SIZE - 1) / BS_VTEX_PAGE_SIZE;
+        source->pages_y[level] = ((h > 0 ? h : 1) + BS_VTEX_PAGE_SIZE - 1) / BS_VTEX_PAGE_SIZE;
+        source->level_offsets[level] = num_entries;
+        num_entries += source->pages_x[level] * source->pages_y[level];
+    }
+
+    if(vtex.num_entries + num_entries > vtex.max_entries) {
+        bs_throw("Virtual texture doesn't fit in the page table");
+    }
+
+    if(!bs_openIo(&source->file, path)) {
+        bs_throw("Failed to open virtual texture");
+    }
+
+    source->base_missing = source->pages_x[source->num_levels - 1] * source->pages_y[source->num_levels - 1];
+
+    for(bs_U32 i = source->first_entry; i < source->first_entry + num_entries; i++) {
+        vtex.table[i] = 0;
+        vtex.physical[i] = BS_VTEX_NONE;
+        vtex.source_of[i] = id;
+        vtex.loading[i] = 0;
+    }
+
+    vtex.num_entries += num_entries;
+    vtex.num_sources++;
+
+    bs_VirtualTexture handle = { 0 };
+    handle.id = id;
+    handle.first_entry = source->first_entry;
+    handle.num_entries = num_entries;
+    handle.w = source->w;
+    handle.h = source->h;
+    handle.num_levels = source->num_levels;
+    return handle;
+}
+
+bs_U32 bs_vtexAtlasSlot() {
+    return vtex.atlas_slot;
+}
+
+bs_U32 bs_residentPages() {
+    return vtex.num_pages - vtex.num_free;
+}
+
+static void bs_requestEntry(bs_U32 entry) {
+    bs_VtexSource* source;
+    bs_U32 level, x, y;
+    bs_entryCoords(entry, &source, &level, &x, &y);
+    bs_bufferAppend(vtex.requests + level, &entry);
+}
+
+static bs_U32 bs_lowestBit(bs_U32 bits) {
+    bs_U32 index = 0;
+    while((bits & 1) == 0) {
+        bits >>= 1;
+        index++;
+    }
+
+    return index;
+}
+
+static void bs_readFeedback(bs_U64 frame_num) {
+    bs_U32* words = bs_shaderSpaceFrame(&vtex.feedback_space, bs_frameData()->swapchain_frame);
+    bs_U32 num_words = (vtex.num_entries + 31) / 32;
+
+    for(bs_U32 w = 0; w < num_words; w++) {
+        bs_U32 bits = words[w];
+        if(bits == 0) continue;
+        words[w] = 0;
+
+        for(; bits != 0; bits &= bits - 1) {
+            bs_U32 entry = w * 32 + bs_lowestBit(bits);
+
+            if(vtex.physical[entry] != BS_VTEX_NONE) {
+                bs_touchPage(vtex.physical[entry], frame_num);
+                continue;
+            }
+
+            // the page drawn in its place has to survive until the real one arrives
+            bs_U32 fallback = vtex.table[entry];
+            if(fallback & BS_VTEX_ENTRY_VALID) {
+                bs_touchPage(BS_VTEX_ENTRY_Y(fallback) * vtex.atlas_pages + BS_VTEX_ENTRY_X(fallback), frame_num);
+            }
+
+            if(!vtex.loading[entry]) {
+                bs_requestEntry(entry);
+            }
+        }
+    }
+
+    // coarsest levels are requested until they're in, whether anything sampled them or not
+    for(bs_U32 i = 0; i < vtex.num_sources; i++) {
+        bs_VtexSource* source = vtex.sources + i;
+        if(source->base_missing == 0) continue;
+
+        bs_U32 top = source->num_levels - 1;
+        for(bs_U32 e = bs_entryIndex(source, top, 0, 0); e < source->first_entry + source->level_offsets[top] + source->pages_x[top] * source->pages_y[top]; e++) {
+            if(vtex.physical[e] == BS_VTEX_NONE && !vtex.loading[e]) {
+                bs_bufferAppend(vtex.requests + top, &e);
+            }
+        }
+    }
+}
+
+static void bs_uploadPages(bs_U64 frame_num) {
+    bs_U32 uploaded = 0;
+
+    for(bs_U32 i = 0; i < BS_VTEX_MAX_LOADS && uploaded < BS_VTEX_UPLOADS_PER_FRAME; i++) {
+        bs_PageLoad* load = vtex.loads + i;
+        bs_I32 state = load->state;
+        if(state == BS_PAGE_LOAD_FREE || state == BS_PAGE_LOAD_READING) continue;
+
+        if(state == BS_PAGE_LOAD_FAILED) {
+            vtex.loading[load->entry] = 0;
+            load->state = BS_PAGE_LOAD_FREE;
+            continue;
+        }
+
+        // every page was used this frame, the read is kept until one frees up
+        bs_U32 page = bs_acquirePage(frame_num);
+        if(page == BS_VTEX_NONE) {
+            break;
+        }
+
+        // appended after the write, a flush in there records and empties the copies before this one
+        VkDeviceSize offset = bs_stagingWrite(load->texels, BS_VTEX_PAGE_BYTES, 4);
+        bs_PageCopy* copy = bs_bufferAppend(&vtex.copies, NULL);
+        copy->offset = offset;
+        copy->page = page;
+
+        bs_VtexSource* source;
+        bs_U32 level, x, y;
+        bs_entryCoords(load->entry, &source, &level, &x, &y);
+
+        bs_PhysicalPage* p = vtex.pages + page;
+        p->entry = load->entry;
+        p->last_used = frame_num;
+        p->pinned = level == source->num_levels - 1;
+        if(p->pinned) {
+            source->base_missing--;
+        } else {
+            bs_pushPage(page);
+        }
+
+        vtex.physical[load->entry] = page;
+        vtex.loading[load->entry] = 0;
+        bs_refreshEntries(load->entry);
+
+        load->state = BS_PAGE_LOAD_FREE;
+        uploaded++;
+    }
+}
+
+// coarse pages first, every finer page falls back to them
+static void bs_startReads() {
+    bs_U32 slot = 0;
+
+    for(bs_I32 level = BS_VTEX_MAX_LEVELS - 1; level >= 0; level--) {
+        bs_Buffer* requests = vtex.requests + level;
+
+        for(bs_U32 i = 0; i < requests->num_units; i++) {
+            bs_U32 entry = *(bs_U32*)bs_bufferData(requests, i);
+            if(vtex.loading[entry] || vtex.physical[entry] != BS_VTEX_NONE) continue;
+
+            while(slot < BS_VTEX_MAX_LOADS && vtex.loads[slot].state != BS_PAGE_LOAD_FREE) slot++;
+            if(slot == BS_VTEX_MAX_LOADS) break;
+
+            bs_VtexSource* source = vtex.sources + vtex.source_of[entry];
+            bs_PageLoad* load = vtex.loads + slot;
+            load->state = BS_PAGE_LOAD_READING;
+            load->entry = entry;
+
+            bs_IoRequest* read = &load->read;
+            memset(read, 0, sizeof(bs_IoRequest));
+            read->file = &source->file;
+            read->offset = BS_VTEX_HEADER_SIZE + (bs_U64)(entry - source->first_entry) * BS_VTEX_PAGE_BYTES;
+            read->size = BS_VTEX_PAGE_BYTES;
+            read->dst = load->texels;
+            read->callback = bs_pageRead;
+            read->user = load;
+
+            vtex.loading[entry] = 1;
+            bs_readAsync(read);
+        }
+
+        // requests are rebuilt from every frame's feedback, so stale ones are dropped
+        requests->num_units = 0;
+    }
+}
+
+void bs_recordFeedbackBarrier(void* command_buffer) {
+    if(vtex.table == NULL) {
+        return;
+    }
+
+    // the fence alone doesn't make shader writes visible to the host, host coherent memory or not
+    VkMemoryBarrier barrier = { 0 };
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &barrier, 0, NULL, 0, NULL);
+}
+
+void bs_updateVirtualTextures() {
+    if(vtex.table == NULL) {
+        return;
+    }
+
+    bs_U64 frame_num = bs_frameData()->frame_num;
+    bs_readFeedback(frame_num);
+    bs_uploadPages(frame_num);
+    bs_startReads();
+
+    if(vtex.dirty_begin != vtex.dirty_end) {
+        bs_updateShaderSpace(&vtex.pages_space, vtex.table + vtex.dirty_begin, vtex.dirty_begin, vtex.dirty_end - vtex.dirty_begin);
+        vtex.dirty_begin = vtex.dirty_end = 0;
+    }
+}
+
+void bs_freeVirtualTextures() {
+    if(vtex.table == NULL) {
+        return;
+    }
+
+    // page reads write into the loads' texels
+    bs_waitIo();
+    bs_freeTexture(&vtex.atlas);
+
+    for(bs_U32 i = 0; i < vtex.num_sources; i++) {
+        bs_closeIo(&vtex.sources[i].file);
+    }
+
+    for(bs_U32 i = 0; i < BS_VTEX_MAX_LOADS; i++) {
+        bs_free(vtex.loads[i].texels);
+    }
+
+    for(bs_U32 i = 0; i < BS_VTEX_MAX_LEVELS; i++) {
+        bs_free(vtex.requests[i].data);
+    }
+
+    bs_free(vtex.copies.data);
+    bs_free(vtex.table);
+    bs_free(vtex.physical);
+    bs_free(vtex.source_of);
+    bs_free(vtex.loading);
+    bs_free(vtex.pages);
+    bs_free(vtex.free_pages);
+    memset(&vtex, 0, sizeof(vtex));
+}
@@ -1,6 +1,7 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <stdbool.h>
+#include <string.h>
 #include <bs_ini.h>
 
 #include <vulkan.h>
@@ -18,8 +19,16 @@ void tick() {
     bs_commitRenderer(&renderer);
 }
 
-int main() {
-    bs_ini(800, 600, "wnd");
+int main(int argc, char** argv) {
+    bs_Config config = bs_defaultConfig();
+
+    // renders a fixed number of frames without a window, e.g. on ci with lavapipe
+    if(argc > 1 && strcmp(argv[1], "--headless") == 0) {
+        config.headless = true;
+        config.headless_frames = 100;
+    }
+
+    bs_iniConfig(800, 600, "wnd", &config);
 
     renderer = bs_renderer(bs_swapchainExtents().x, bs_swapchainExtents().y);
     bs_attach(&renderer, BS_COLOR_ATTACHMENT);
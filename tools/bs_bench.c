@@ -0,0 +1,954 @@
+// Engine benchmarks, one per run so every result starts from a fresh process.
+// Benchmarks that need a device render headless and load tri_vs.spv and tri_fs.spv like bsvk,
+// so run them from the directory those were compiled into.
+// usage: bsbench <benchmark> [args], bsbench without arguments lists them
+
+#include <bs_types.h>
+#include <bs_math.h>
+#include <bs_ini.h>
+#include <bs_core.h>
+#include <bs_mem.h>
+#include <bs_shaders.h>
+#include <bs_staging.h>
+#include <bs_jobs.h>
+#include <bs_textures.h>
+#include <bs_json.h>
+#include <bs_io.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#define BS_BENCH_WIDTH 1280
+#define BS_BENCH_HEIGHT 720
+
+typedef struct {
+    const char* name;
+    const char* usage;
+    int (*run)(int argc, char** argv);
+} bs_Benchmark;
+
+static struct {
+    bs_Renderer renderer;
+    bs_VertexShader vs;
+    bs_FragmentShader fs;
+    bs_Pipeline pipeline;
+} bench = { 0 };
+
+// value of "--name <value>", fallback if it's not given
+static const char* bs_benchOption(int argc, char** argv, const char* name, const char* fallback) {
+    for(int i = 0; i < argc - 1; i++) {
+        if(strcmp(argv[i], name) == 0) return argv[i + 1];
+    }
+
+    return fallback;
+}
+
+static bool bs_benchFlag(int argc, char** argv, const char* name) {
+    for(int i = 0; i < argc; i++) {
+        if(strcmp(argv[i], name) == 0) return true;
+    }
+
+    return false;
+}
+
+// headless device with a color renderer and the triangle pipeline, config can be NULL
+static void bs_benchDevice(bs_Config* config) {
+    bs_Config default_config = bs_defaultConfig();
+    if(config == NULL) {
+        config = &default_config;
+    }
+
+    config->headless = true;
+    bs_iniConfig(BS_BENCH_WIDTH, BS_BENCH_HEIGHT, "bsbench", config);
+
+    bench.renderer = bs_renderer(BS_BENCH_WIDTH, BS_BENCH_HEIGHT);
+    bs_attach(&bench.renderer, BS_COLOR_ATTACHMENT);
+    bs_pushRenderer(&bench.renderer);
+
+    bench.vs = bs_vertexShader("tri_vs.spv");
+    bench.fs = bs_fragmentShader("tri_fs.spv");
+    bench.pipeline = bs_pipeline(&bench.renderer, &bench.vs, &bench.fs);
+}
+
+// - batches -
+// bsbench batches [--count <batches>] [--sync]
+// pushes every batch with its own upload, --sync waits for each one like the per-call staging buffer
+// and vkQueueWaitIdle of bs_pushBatch() used to, without it they share submits of the staging ring
+static int bs_benchBatches(int argc, char** argv) {
+    bs_U32 num_batches = atoi(bs_benchOption(argc, argv, "--count", "5000"));
+    bool sync = bs_benchFlag(argc, argv, "--sync");
+
+    bs_benchDevice(NULL);
+    bs_Batch* batches = bs_alloc(num_batches * sizeof(bs_Batch));
+    bs_RGBA color = BS_RED;
+
+    double start = bs_time();
+    for(bs_U32 i = 0; i < num_batches; i++) {
+        float x = (float)(i % 64) / 32.0 - 1.0;
+        float y = (float)(i / 64 % 64) / 32.0 - 1.0;
+
+        batches[i] = bs_batch(&bench.pipeline);
+        bs_pushTriangle(batches + i, bs_v3(x, y, 0.0), bs_v3(x + 0.03, y, 0.0), bs_v3(x, y + 0.03, 0.0), color, NULL);
+        bs_pushBatch(batches + i);
+
+        if(sync) {
+            bs_waitUpload(bs_flushUploads());
+        }
+    }
+
+    bs_waitUpload(bs_flushUploads());
+    double elapsed = bs_time() - start;
+
+    printf("%u batches%s: %.2f ms, %.2f us per batch\n", num_batches, sync ? " (wait per batch)" : "", elapsed * 1000.0, elapsed * 1e6 / num_batches);
+    return 0;
+}
+
+// - draws -
+// frames that aren't timed, e.g. while the indirect buffer grows to its size
+#define BS_BENCH_WARMUP_FRAMES 10
+
+static struct {
+    bs_Batch batch;
+    bs_U32 num_draws;
+    bool indirect;
+
+    bs_U32 frame;
+    double record_time;
+} draws = { 0 };
+
+// the render pass is ended in the timed part, queued indirect draws are recorded there
+static void bs_benchDrawsTick() {
+    bs_BatchPart range = bs_batchRange(0, 3);
+    double start = bs_time();
+
+    bs_selectRenderer(&bench.renderer);
+    bs_selectBatch(&draws.batch);
+    for(bs_U32 i = 0; i < draws.num_draws; i++) {
+        if(draws.indirect) {
+            bs_renderBatchIndirect(&draws.batch, range, i);
+        } else {
+            bs_renderBatch(&draws.batch, range, BS_TRIANGLES);
+        }
+    }
+
+    bs_commitRenderer(&bench.renderer);
+
+    if(draws.frame++ >= BS_BENCH_WARMUP_FRAMES) {
+        draws.record_time += bs_time() - start;
+    }
+}
+
+// bsbench draws [--count <draws>] [--frames <frames>] [--indirect]
+// cpu time per frame of drawing the same triangle count times, with a vkCmdDrawIndexed each or as queued indirect draws
+static int bs_benchDraws(int argc, char** argv) {
+    bs_U32 num_frames = atoi(bs_benchOption(argc, argv, "--frames", "200"));
+    draws.num_draws = atoi(bs_benchOption(argc, argv, "--count", "100000"));
+    draws.indirect = bs_benchFlag(argc, argv, "--indirect");
+
+    bs_Config config = bs_defaultConfig();
+    config.headless_frames = num_frames + BS_BENCH_WARMUP_FRAMES;
+    bs_benchDevice(&config);
+
+    bs_RGBA color = BS_RED;
+    draws.batch = bs_batch(&bench.pipeline);
+    bs_pushTriangle(&draws.batch, bs_v3(0.0, -0.5, 0.0), bs_v3(0.5, 0.5, 0.0), bs_v3(-0.5, 0.5, 0.0), color, NULL);
+    bs_pushBatch(&draws.batch);
+
+    bs_run(bs_benchDrawsTick);
+
+    double per_frame = draws.record_time / num_frames;
+    printf("%u %s draws: %.3f ms recording per frame, %.1f ns per draw\n", draws.num_draws, draws.indirect ? "indirect" : "direct", per_frame * 1000.0, per_frame * 1e9 / draws.num_draws);
+    return 0;
+}
+
+// - record -
+static struct {
+    bs_Batch batch;
+    bs_U32 num_draws;
+    bs_U32 num_jobs;
+
+    bs_U32 frame;
+    double record_time;
+} record = { 0 };
+
+static void bs_benchRecordJob(void* param, bs_U32 index) {
+    bs_BatchPart range = bs_batchRange(0, 3);
+    bs_U32 begin = (bs_U64)record.num_draws * index / record.num_jobs;
+    bs_U32 end = (bs_U64)record.num_draws * (index + 1) / record.num_jobs;
+
+    bs_selectBatch(&record.batch);
+    for(bs_U32 i = begin; i < end; i++) {
+        bs_renderBatch(&record.batch, range, BS_TRIANGLES);
+    }
+}
+
+static void bs_benchRecordTick() {
+    double start = bs_time();
+    bs_recordJobs(&bench.renderer, bs_benchRecordJob, NULL, record.num_jobs);
+
+    if(record.frame++ >= BS_BENCH_WARMUP_FRAMES) {
+        record.record_time += bs_time() - start;
+    }
+}
+
+// bsbench record [--count <draws>] [--jobs <jobs>] [--threads <threads>] [--frames <frames>]
+// draws split over jobs that record secondary command buffers, run it with --threads 1, 2, 4 and 8 for the scaling
+static int bs_benchRecord(int argc, char** argv) {
+    bs_U32 num_frames = atoi(bs_benchOption(argc, argv, "--frames", "200"));
+    record.num_draws = atoi(bs_benchOption(argc, argv, "--count", "100000"));
+    record.num_jobs = atoi(bs_benchOption(argc, argv, "--jobs", "64"));
+
+    bs_Config config = bs_defaultConfig();
+    config.headless_frames = num_frames + BS_BENCH_WARMUP_FRAMES;
+    config.job_threads = atoi(bs_benchOption(argc, argv, "--threads", "0"));
+    bs_benchDevice(&config);
+
+    bs_RGBA color = BS_RED;
+    record.batch = bs_batch(&bench.pipeline);
+    bs_pushTriangle(&record.batch, bs_v3(0.0, -0.5, 0.0), bs_v3(0.5, 0.5, 0.0), bs_v3(-0.5, 0.5, 0.0), color, NULL);
+    bs_pushBatch(&record.batch);
+
+    bs_run(bs_benchRecordTick);
+
+    double per_frame = record.record_time / num_frames;
+    printf("%u draws in %u jobs on %u threads: %.3f ms recording per frame\n", record.num_draws, record.num_jobs, bs_numJobThreads(), per_frame * 1000.0);
+    return 0;
+}
+
+// - pipelines -
+// bsbench pipelines [--cold] [--cache <path>] [<vs.spv> <fs.spv>]...
+// startup with every shader pair compiled for a color and a color + depth renderer, --cold deletes the cache first.
+// A cold run followed by a warm one compares compiling from scratch with compiling from the saved cache
+static int bs_benchPipelines(int argc, char** argv) {
+    bs_Config config = bs_defaultConfig();
+    config.pipeline_cache = bs_benchOption(argc, argv, "--cache", BS_PIPELINE_CACHE_PATH);
+
+    bool cold = bs_benchFlag(argc, argv, "--cold");
+    if(cold) {
+        remove(config.pipeline_cache);
+    }
+
+    double start = bs_time();
+    bs_benchDevice(&config);
+    double startup_time = bs_time() - start;
+
+    bs_Renderer depth_renderer = bs_renderer(BS_BENCH_WIDTH, BS_BENCH_HEIGHT);
+    bs_attach(&depth_renderer, BS_COLOR_ATTACHMENT);
+    bs_attach(&depth_renderer, BS_DEPTH_ATTACHMENT);
+    bs_pushRenderer(&depth_renderer);
+
+    // the triangle pipeline of bs_benchDevice() counts too
+    bs_U32 num_pipelines = 1;
+    start = bs_time();
+    bs_pipeline(&depth_renderer, &bench.vs, &bench.fs);
+    num_pipelines++;
+
+    for(int i = 0; i < argc - 1; i++) {
+        bool pair = strstr(argv[i], ".spv") != NULL && strstr(argv[i + 1], ".spv") != NULL;
+        if(!pair || (i > 0 && strcmp(argv[i - 1], "--cache") == 0)) continue;
+
+        bs_VertexShader vs = bs_vertexShader(argv[i]);
+        bs_FragmentShader fs = bs_fragmentShader(argv[i + 1]);
+        bs_pipeline(&bench.renderer, &vs, &fs);
+        bs_pipeline(&depth_renderer, &vs, &fs);
+        num_pipelines += 2;
+        i++;
+    }
+
+    double compile_time = bs_time() - start;
+    bs_savePipelineCache(config.pipeline_cache);
+
+    printf("%s: %u pipelines, bs_ini with the first one %.2f ms, the rest %.2f ms\n", cold ? "cold" : "warm", num_pipelines, startup_time * 1000.0, compile_time * 1000.0);
+    return 0;
+}
+
+// - upload -
+// noise, so the PNGs don't compress to nothing
+static void bs_benchWritePngs(bs_U32 num_textures, bs_U32 size) {
+    bs_U8* texels = bs_alloc(size * size * 4);
+    bs_U32 state = 1;
+
+    for(bs_U32 i = 0; i < num_textures; i++) {
+        for(bs_U32 j = 0; j < size * size * 4; j++) {
+            state = state * 1664525 + 1013904223;
+            texels[j] = state >> 24;
+        }
+
+        char path[64];
+        snprintf(path, sizeof(path), "bsbench_%04u.png", i);
+        bs_saveTexture32(path, texels, size, size);
+    }
+
+    bs_free(texels);
+}
+
+// the .png arguments, or --count PNGs of --size texels written by bs_benchWritePngs()
+static char** bs_benchPngs(int argc, char** argv, bs_U32* num_paths) {
+    bs_U32 num_textures = atoi(bs_benchOption(argc, argv, "--count", "1000"));
+    bs_U32 size = atoi(bs_benchOption(argc, argv, "--size", "256"));
+
+    char** paths = bs_alloc((argc + num_textures) * sizeof(char*));
+    *num_paths = 0;
+    for(int i = 0; i < argc; i++) {
+        if(strstr(argv[i], ".png") != NULL) paths[(*num_paths)++] = argv[i];
+    }
+
+    if(*num_paths == 0) {
+        bs_benchWritePngs(num_textures, size);
+        for(bs_U32 i = 0; i < num_textures; i++) {
+            paths[*num_paths] = bs_alloc(64);
+            snprintf(paths[(*num_paths)++], 64, "bsbench_%04u.png", i);
+        }
+    }
+
+    return paths;
+}
+
+// bsbench upload [--count <textures>] [--size <texels>] [<file.png>...]
+// decodes every file, then uploads them with a full mip chain and waits for the last upload.
+// Without files it writes count PNGs of size x size texels into the working directory first
+static int bs_benchUpload(int argc, char** argv) {
+    bs_U32 num_paths = 0;
+    char** paths = bs_benchPngs(argc, argv, &num_paths);
+
+    bs_benchDevice(NULL);
+    bs_Texture* decoded = bs_alloc(num_paths * sizeof(bs_Texture));
+    bs_Texture* textures = bs_alloc(num_paths * sizeof(bs_Texture));
+    bs_U64 bytes = 0;
+
+    double start = bs_time();
+    for(bs_U32 i = 0; i < num_paths; i++) {
+        memset(decoded + i, 0, sizeof(bs_Texture));
+        if(bs_textureFile(decoded + i, paths[i]) != 0) {
+            printf("failed to load %s\n", paths[i]);
+            return 1;
+        }
+
+        bytes += bs_levelSize(decoded[i].format, decoded[i].w, decoded[i].h);
+    }
+
+    double decode_time = bs_time() - start;
+
+    start = bs_time();
+    for(bs_U32 i = 0; i < num_paths; i++) {
+        bs_texture(textures + i, bs_v2(decoded[i].w, decoded[i].h), decoded[i].format, decoded[i].mip_levels > 1 ? decoded[i].mip_levels : 0);
+        bs_textureUploadLevels(textures + i, decoded[i].data, decoded[i].mip_levels);
+    }
+
+    bs_waitUpload(bs_flushUploads());
+    double upload_time = bs_time() - start;
+
+    printf("%u textures, %.1f MB: decoding %.2f ms, uploading with mips %.2f ms (%.1f MB/s)\n",
+        num_paths, bytes / 1e6, decode_time * 1000.0, upload_time * 1000.0, bytes / 1e6 / upload_time);
+    return 0;
+}
+
+// - stream -
+static struct {
+    bs_Image** images;
+    bs_U32 num_images;
+
+    double start;
+    double elapsed;
+    bs_U32 frames;
+} stream = { 0 };
+
+static void bs_benchStreamTick() {
+    stream.frames++;
+
+    bs_selectRenderer(&bench.renderer);
+    bs_commitRenderer(&bench.renderer);
+
+    // bs_streamImages() ran before tick, so every image that's done is in the table by now
+    if(bs_pendingImages() == 0) {
+        stream.elapsed = bs_time() - stream.start;
+        bs_exit();
+    }
+}
+
+// bsbench stream [--count <textures>] [--size <texels>] [--threads <threads>] [<file.png>...]
+// time until every image queued with bs_imageAsync() is ready while frames keep rendering,
+// run it with --threads 1, 2, 4 and 8 for the scaling of the decode jobs
+static int bs_benchStream(int argc, char** argv) {
+    bs_U32 num_paths = 0;
+    char** paths = bs_benchPngs(argc, argv, &num_paths);
+
+    bs_Config config = bs_defaultConfig();
+    config.job_threads = atoi(bs_benchOption(argc, argv, "--threads", "0"));
+    bs_benchDevice(&config);
+    bs_pushImageBuffers();
+
+    stream.images = bs_alloc(num_paths * sizeof(bs_Image*));
+    stream.num_images = num_paths;
+    stream.start = bs_time();
+
+    // loaded in order
+    for(bs_U32 i = 0; i < num_paths; i++) {
+        stream.images[i] = bs_imageAsync(paths[i], -(float)i);
+    }
+
+    bs_run(bs_benchStreamTick);
+
+    bs_U32 num_failed = 0;
+    for(bs_U32 i = 0; i < num_paths; i++) {
+        if(!bs_imageReady(stream.images[i])) num_failed++;
+    }
+
+    printf("%u images on %u threads: %.2f ms over %u frames, %u failed\n", num_paths, bs_numJobThreads(), stream.elapsed * 1000.0, stream.frames, num_failed);
+    return 0;
+}
+
+// - arena -
+// glTF manifest with a mesh of POSITION, NORMAL, TEXCOORD_0 and indices accessors per node, each accessor with a view of its own
+static char* bs_benchGltf(bs_U32 num_accessors) {
+    bs_U32 num_meshes = num_accessors / 4 > 0 ? num_accessors / 4 : 1;
+    num_accessors = num_meshes * 4;
+
+    // no entry is longer than 256 bytes
+    bs_U64 capacity = (bs_U64)num_accessors * 512 + 256;
+    char* json = bs_alloc(capacity);
+    bs_U64 len = 0;
+
+    len += snprintf(json + len, capacity - len, "{\"asset\":{\"version\":\"2.0\"},\"buffers\":[{\"uri\":\"bench.bin\",\"byteLength\":%u}],\"bufferViews\":[", num_accessors * 1024);
+    for(bs_U32 i = 0; i < num_accessors; i++) {
+        len += snprintf(json + len, capacity - len, "%s{\"buffer\":0,\"byteOffset\":%u,\"byteLength\":1024}", i > 0 ? "," : "", i * 1024);
+    }
+
+    static const char* types[] = { "VEC3", "VEC3", "VEC2", "SCALAR" };
+    static const bs_U32 component_types[] = { 5126, 5126, 5126, 5125 };
+    len += snprintf(json + len, capacity - len, "],\"accessors\":[");
+    for(bs_U32 i = 0; i < num_accessors; i++) {
+        len += snprintf(json + len, capacity - len,
+            "%s{\"bufferView\":%u,\"byteOffset\":0,\"componentType\":%u,\"count\":64,\"type\":\"%s\",\"min\":[-1.0,-1.0,-1.0],\"max\":[1.0,1.0,1.0]}",
+            i > 0 ? "," : "", i, component_types[i % 4], types[i % 4]);
+    }
+
+    len += snprintf(json + len, capacity - len, "],\"meshes\":[");
+    for(bs_U32 i = 0; i < num_meshes; i++) {
+        len += snprintf(json + len, capacity - len,
+            "%s{\"name\":\"mesh_%u\",\"primitives\":[{\"attributes\":{\"POSITION\":%u,\"NORMAL\":%u,\"TEXCOORD_0\":%u},\"indices\":%u,\"mode\":4}]}",
+            i > 0 ? "," : "", i, i * 4, i * 4 + 1, i * 4 + 2, i * 4 + 3);
+    }
+
+    len += snprintf(json + len, capacity - len, "],\"nodes\":[");
+    for(bs_U32 i = 0; i < num_meshes; i++) {
+        len += snprintf(json + len, capacity - len,
+            "%s{\"name\":\"node_%u\",\"mesh\":%u,\"translation\":[%u.0,0.0,0.0]}", i > 0 ? "," : "", i, i, i);
+    }
+
+    snprintf(json + len, capacity - len, "],\"scene\":0}");
+    return json;
+}
+
+// the field lookups bs_loadModel() does per node, mesh, primitive and accessor.
+// Heap arrays are freed like a loader without an arena has to, the sum keeps the lookups from being optimized out
+static bs_I64 bs_benchGltfWalk(bs_Json* json, bool heap) {
+    bs_JsonArray nodes = bs_jsonField(json, "nodes").as_array;
+    bs_JsonArray meshes = bs_jsonField(json, "meshes").as_array;
+    bs_JsonArray accessors = bs_jsonField(json, "accessors").as_array;
+    bs_JsonArray views = bs_jsonField(json, "bufferViews").as_array;
+    static const char* attributes[] = { "POSITION", "NORMAL", "TEXCOORD_0" };
+    bs_I64 sum = 0;
+
+    for(int i = 0; i < nodes.size; i++) {
+        bs_Json* mesh = meshes.as_objects + bs_jsonField(nodes.as_objects + i, "mesh").as_int;
+        bs_JsonArray primitives = bs_jsonField(mesh, "primitives").as_array;
+
+        for(int j = 0; j < primitives.size; j++) {
+            bs_Json attribute_json = bs_jsonField(primitives.as_objects + j, "attributes").as_object;
+            bs_I64 used[4];
+            used[3] = bs_jsonField(primitives.as_objects + j, "indices").as_int;
+            for(int k = 0; k < 3; k++) {
+                used[k] = bs_jsonField(&attribute_json, attributes[k]).as_int;
+            }
+
+            for(int k = 0; k < 4; k++) {
+                bs_Json* accessor = accessors.as_objects + used[k];
+                bs_Json* view = views.as_objects + bs_jsonField(accessor, "bufferView").as_int;
+                sum += bs_jsonField(accessor, "count").as_int + bs_jsonField(accessor, "componentType").as_int;
+                sum += bs_jsonField(view, "byteOffset").as_int + bs_jsonField(view, "byteLength").as_int;
+            }
+        }
+
+        if(heap) bs_free(primitives.as_objects);
+    }
+
+    if(heap) {
+        bs_free(nodes.as_objects);
+        bs_free(meshes.as_objects);
+        bs_free(accessors.as_objects);
+        bs_free(views.as_objects);
+    }
+
+    return sum;
+}
+
+// bsbench arena [--accessors <accessors>] [--loads <loads>]
+// loads the same glTF manifest loads times on the heap and through an arena reset between loads
+static int bs_benchArena(int argc, char** argv) {
+    bs_U32 num_accessors = atoi(bs_benchOption(argc, argv, "--accessors", "10000"));
+    bs_U32 num_loads = atoi(bs_benchOption(argc, argv, "--loads", "100"));
+    char* raw = bs_benchGltf(num_accessors);
+    bs_I64 sum = 0;
+
+    bs_U64 allocs = bs_heapStats().num_allocs;
+    double start = bs_time();
+    for(bs_U32 i = 0; i < num_loads; i++) {
+        bs_Json json = bs_jsonWith(raw, NULL);
+        sum += bs_benchGltfWalk(&json, true);
+
+        // bs_freeJson() leaves the json as is, what the lexer allocated is freed here
+        bs_free(json.tokens);
+        bs_free(json.keys);
+        bs_free(json.token_data);
+    }
+
+    double heap_time = bs_time() - start;
+    bs_U64 heap_allocs = bs_heapStats().num_allocs - allocs;
+
+    bs_Arena arena = bs_arena(0);
+    allocs = bs_heapStats().num_allocs;
+    start = bs_time();
+    for(bs_U32 i = 0; i < num_loads; i++) {
+        bs_Json json = bs_jsonWith(raw, &arena.allocator);
+        sum += bs_benchGltfWalk(&json, false);
+        bs_arenaReset(&arena);
+    }
+
+    double arena_time = bs_time() - start;
+    bs_U64 arena_allocs = bs_heapStats().num_allocs - allocs;
+
+    printf("%u loads of %.1f KB with %u accessors (%lld)\n", num_loads, strlen(raw) / 1e3, num_accessors, (long long)sum);
+    printf("heap:  %.3f ms per load, %.1f heap allocations per load\n", heap_time * 1000.0 / num_loads, (double)heap_allocs / num_loads);
+    printf("arena: %.3f ms per load, %.1f heap allocations per load, %llu KB peak\n", arena_time * 1000.0 / num_loads, (double)arena_allocs / num_loads, (unsigned long long)arena.allocator.stats.peak_bytes / 1024);
+
+    bs_freeArena(&arena);
+    bs_free(raw);
+    return 0;
+}
+
+// - append -
+// bs_bufferResizeCheck() before geometric growth, every increment units were reallocated and zeroed
+static void bs_benchLinearAppend(bs_Buffer* buf, void* data) {
+    if(buf->num_units + 1 >= buf->capacity) {
+        bs_U32 prev_capacity = buf->capacity;
+        buf->capacity += buf->increment;
+        buf->data = bs_realloc(buf->data, buf->capacity * buf->unit_size);
+        memset(bs_bufferData(buf, prev_capacity), 0, (buf->capacity - prev_capacity) * buf->unit_size);
+    }
+
+    memcpy(bs_bufferData(buf, buf->num_units++), data, buf->unit_size);
+}
+
+#define BS_BENCH_MAX_BUFFERS 16
+
+// bsbench append [--count <units>] [--size <bytes>] [--increment <units>] [--buffers <buffers>]
+// appends count units one at a time with the old linear growth, geometric growth, geometric growth without zeroing
+// and into buffers reserved up front. Buffers are appended to in turn like the vertex and index buffers of a batch,
+// so the allocator can't keep growing a single one in place
+static int bs_benchAppend(int argc, char** argv) {
+    bs_U32 num_units = atoi(bs_benchOption(argc, argv, "--count", "1000000"));
+    bs_U32 unit_size = atoi(bs_benchOption(argc, argv, "--size", "64"));
+    bs_U32 increment = atoi(bs_benchOption(argc, argv, "--increment", "256"));
+    bs_U32 num_buffers = atoi(bs_benchOption(argc, argv, "--buffers", "2"));
+    if(num_buffers < 1) num_buffers = 1;
+    if(num_buffers > BS_BENCH_MAX_BUFFERS) num_buffers = BS_BENCH_MAX_BUFFERS;
+
+    static const char* names[] = { "linear", "geometric", "no zero fill", "reserved" };
+    bs_U8* unit = bs_alloc(unit_size);
+    memset(unit, 0xAB, unit_size);
+
+    for(int mode = 0; mode < 4; mode++) {
+        bs_Buffer bufs[BS_BENCH_MAX_BUFFERS];
+        bs_U32 num_growths = 0;
+        bs_U64 bytes = bs_heapStats().total_bytes;
+        double start = bs_time();
+
+        for(bs_U32 i = 0; i < num_buffers; i++) {
+            bufs[i] = bs_buffer(unit_size, increment, 0, 0);
+            if(mode == 2) bufs[i].flags |= BS_BUFFER_NO_ZERO_FILL;
+
+            if(mode == 3) {
+                bs_bufferReserve(bufs + i, num_units);
+                num_growths++;
+            }
+        }
+
+        for(bs_U32 i = 0; i < num_units; i++) {
+            for(bs_U32 j = 0; j < num_buffers; j++) {
+                bs_U32 capacity = bufs[j].capacity;
+
+                if(mode == 0) {
+                    bs_benchLinearAppend(bufs + j, unit);
+                } else {
+                    bs_bufferAppend(bufs + j, unit);
+                }
+
+                num_growths += bufs[j].capacity != capacity;
+            }
+        }
+
+        double elapsed = bs_time() - start;
+        bytes = bs_heapStats().total_bytes - bytes;
+        bs_U64 num_appends = (bs_U64)num_units * num_buffers;
+
+        printf("%-12s %u x %u x %u bytes: %.2f ms, %.1f ns per append, %u growths, %.1f MB requested\n",
+            names[mode], num_buffers, num_units, unit_size, elapsed * 1000.0, elapsed * 1e9 / num_appends, num_growths, bytes / 1e6);
+
+        for(bs_U32 i = 0; i < num_buffers; i++) {
+            bs_freeBuffer(bufs + i);
+        }
+    }
+
+    bs_free(unit);
+    return 0;
+}
+
+// - map -
+static bs_U64 bs_benchPeakRss() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters = { 0 };
+    K32GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+    return counters.PeakWorkingSetSize;
+#else
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return (bs_U64)usage.ru_maxrss * 1024;
+#endif
+}
+
+// written in chunks, so a freshly written file doesn't count towards the peak
+static void bs_benchWriteFile(const char* path, bs_U64 size) {
+    FILE* file = fopen(path, "wb");
+    if(file == NULL) {
+        bs_throw("Failed to create the benchmark file");
+    }
+
+    bs_U32 chunk_size = 1024 * 1024;
+    bs_U32* chunk = bs_alloc(chunk_size);
+    bs_U32 state = 1;
+
+    for(bs_U64 written = 0; written < size; written += chunk_size) {
+        for(bs_U32 i = 0; i < chunk_size / 4; i++) {
+            state = state * 1664525 + 1013904223;
+            chunk[i] = state;
+        }
+
+        fwrite(chunk, 1, size - written < chunk_size ? size - written : chunk_size, file);
+    }
+
+    bs_free(chunk);
+    fclose(file);
+}
+
+// bsbench map <file> [copy|map] [--size <MB>]
+// reads every byte of a file once, like the glTF loader copying accessors out of its buffer,
+// after bs_loadFile() or through bs_mapFile(). Peak RSS is per process, so copy and map are separate runs.
+// A missing file is written with size MB first
+static int bs_benchMap(int argc, char** argv) {
+    if(argc < 1) {
+        printf("bsbench map needs a file\n");
+        return 1;
+    }
+
+    const char* path = argv[0];
+    bool map = argc > 1 && strcmp(argv[1], "map") == 0;
+    bs_U64 size = (bs_U64)atoi(bs_benchOption(argc, argv, "--size", "500")) * 1024 * 1024;
+
+    FILE* existing = fopen(path, "rb");
+    if(existing == NULL) {
+        bs_benchWriteFile(path, size);
+    } else {
+        fclose(existing);
+    }
+
+    bs_U64 rss = bs_benchPeakRss();
+    bs_U64 heap_bytes = bs_heapStats().total_bytes;
+    double start = bs_time();
+
+    const bs_U8* data = NULL;
+    bs_U64 data_size = 0;
+    char* loaded = NULL;
+    bs_MappedFile mapped = { 0 };
+
+    if(map) {
+        mapped = bs_mapFile(path, BS_MAP_SEQUENTIAL);
+        data = mapped.data;
+        data_size = mapped.size;
+    } else {
+        int len = 0;
+        loaded = bs_loadFile(path, &len);
+        data = (const bs_U8*)loaded;
+        data_size = len;
+    }
+
+    double open_time = bs_time() - start;
+
+    bs_U64 sum = 0;
+    for(bs_U64 i = 0; i + 8 <= data_size; i += 8) {
+        bs_U64 word;
+        memcpy(&word, data + i, 8);
+        sum += word;
+    }
+
+    double elapsed = bs_time() - start;
+    heap_bytes = bs_heapStats().total_bytes - heap_bytes;
+
+    // mapped pages count towards RSS as well, but they're clean and can be dropped, the heap copy can't
+    printf("%s %.1f MB (%llx): %s %.2f ms, read through %.2f ms, peak RSS %.1f MB (%.1f MB before), %.1f MB from the heap\n",
+        map ? "bs_mapFile" : "bs_loadFile", data_size / 1e6, (unsigned long long)sum, map ? "mapped" : "loaded",
+        open_time * 1000.0, elapsed * 1000.0, bs_benchPeakRss() / 1e6, rss / 1e6, heap_bytes / 1e6);
+
+    if(map) {
+        bs_unmapFile(&mapped);
+    } else {
+        bs_free(loaded);
+    }
+
+    return 0;
+}
+
+// - io -
+// reads the whole file in reads of read_size bytes queued at once, one request each
+static double bs_benchReads(bs_IoFile* file, bs_U8* dst, bs_U64 read_size, bs_U32* num_failed) {
+    bs_U32 num_reads = (file->size + read_size - 1) / read_size;
+    bs_IoRequest* requests = bs_alloc(num_reads * sizeof(bs_IoRequest));
+    memset(requests, 0, num_reads * sizeof(bs_IoRequest));
+
+    double start = bs_time();
+    for(bs_U32 i = 0; i < num_reads; i++) {
+        requests[i].file = file;
+        requests[i].offset = i * read_size;
+        requests[i].size = file->size - requests[i].offset < read_size ? file->size - requests[i].offset : read_size;
+        requests[i].dst = dst + requests[i].offset;
+        bs_readAsync(requests + i);
+    }
+
+    bs_waitIo();
+    double elapsed = bs_time() - start;
+
+    for(bs_U32 i = 0; i < num_reads; i++) {
+        *num_failed += requests[i].state != BS_IO_DONE;
+    }
+
+    bs_free(requests);
+    return elapsed;
+}
+
+// bsbench io <file> [--small <KB>] [--large <MB>] [--threads <threads>] [--size <MB>]
+// throughput of reading a file in many small reads against a few large ones through bs_readAsync(),
+// after a read that isn't timed so both come from the page cache. A missing file is written with size MB first
+static int bs_benchIo(int argc, char** argv) {
+    if(argc < 1) {
+        printf("bsbench io needs a file\n");
+        return 1;
+    }
+
+    const char* path = argv[0];
+    bs_U64 small_size = (bs_U64)atoi(bs_benchOption(argc, argv, "--small", "4")) * 1024;
+    bs_U64 large_size = (bs_U64)atoi(bs_benchOption(argc, argv, "--large", "4")) * 1024 * 1024;
+
+    FILE* existing = fopen(path, "rb");
+    if(existing == NULL) {
+        bs_benchWriteFile(path, (bs_U64)atoi(bs_benchOption(argc, argv, "--size", "256")) * 1024 * 1024);
+    } else {
+        fclose(existing);
+    }
+
+    // no device, only the job threads the thread pool backend reads on
+    bs_prepareJobs(atoi(bs_benchOption(argc, argv, "--threads", "0")));
+    bs_prepareIo();
+
+    bs_IoFile file;
+    if(!bs_openIo(&file, path)) {
+        printf("failed to open %s\n", path);
+        return 1;
+    }
+
+    bs_U8* dst = bs_alloc(file.size);
+    bs_U32 num_failed = 0;
+    bs_benchReads(&file, dst, large_size, &num_failed);
+
+    double small_time = bs_benchReads(&file, dst, small_size, &num_failed);
+    double large_time = bs_benchReads(&file, dst, large_size, &num_failed);
+
+    printf("%.1f MB with %s on %u threads, %u failed\n", file.size / 1e6, bs_ioBackend() == BS_IO_BACKEND_URING ? "io_uring" : "job threads", bs_numJobThreads(), num_failed);
+    printf("%llu KB reads: %.2f ms, %.1f MB/s\n", (unsigned long long)small_size / 1024, small_time * 1000.0, file.size / 1e6 / small_time);
+    printf("%llu KB reads: %.2f ms, %.1f MB/s\n", (unsigned long long)large_size / 1024, large_time * 1000.0, file.size / 1e6 / large_time);
+
+    bs_free(dst);
+    bs_closeIo(&file);
+    bs_freeIo();
+    bs_freeJobs();
+    return 0;
+}
+
+// - gltf -
+// field lookups on every accessor, without the key table bs_findToken() falls back to searching the object's tokens
+static double bs_benchLookups(bs_JsonArray* accessors, bool indexed, bs_U32 num_rounds, bs_I64* sum) {
+    static const char* fields[] = { "bufferView", "byteOffset", "componentType", "count", "type" };
+
+    double start = bs_time();
+    for(bs_U32 round = 0; round < num_rounds; round++) {
+        for(int i = 0; i < accessors->size; i++) {
+            bs_Json accessor = accessors->as_objects[i];
+            if(!indexed) accessor.keys = NULL;
+
+            for(int j = 0; j < 5; j++) {
+                *sum += bs_jsonField(&accessor, fields[j]).found;
+            }
+        }
+    }
+
+    return (bs_time() - start) / ((double)num_rounds * accessors->size * 5);
+}
+
+// "scene" closes the manifest, the linear search walked all of it to get there
+static double bs_benchRootLookups(bs_Json* json, bool indexed, bs_U32 num_lookups, bs_I64* sum) {
+    bs_Json root = *json;
+    if(!indexed) root.keys = NULL;
+
+    double start = bs_time();
+    for(bs_U32 i = 0; i < num_lookups; i++) {
+        *sum += bs_jsonField(&root, "scene").found;
+    }
+
+    return (bs_time() - start) / num_lookups;
+}
+
+// bsbench gltf [--accessors <accessors>]...
+// ns per bs_jsonField() on accessors and on the top level with and without the key table,
+// for manifests of 1000, 10000 and 100000 accessors or the given counts. Flat times across sizes are O(1)
+static int bs_benchGltfLookups(int argc, char** argv) {
+    bs_U32 sizes[16];
+    bs_U32 num_sizes = 0;
+    for(int i = 0; i < argc - 1 && num_sizes < 16; i++) {
+        if(strcmp(argv[i], "--accessors") == 0) sizes[num_sizes++] = atoi(argv[i + 1]);
+    }
+
+    if(num_sizes == 0) {
+        sizes[num_sizes++] = 1000;
+        sizes[num_sizes++] = 10000;
+        sizes[num_sizes++] = 100000;
+    }
+
+    bs_I64 sum = 0;
+    for(bs_U32 i = 0; i < num_sizes; i++) {
+        char* raw = bs_benchGltf(sizes[i]);
+        bs_Arena arena = bs_arena(0);
+
+        double start = bs_time();
+        bs_Json json = bs_jsonWith(raw, &arena.allocator);
+        double lex_time = bs_time() - start;
+
+        bs_JsonArray accessors = bs_jsonField(&json, "accessors").as_array;
+
+        // about a million lookups per size, the searched top level gets fewer as every one walks the manifest
+        bs_U32 num_rounds = 200000 / accessors.size + 1;
+        double indexed = bs_benchLookups(&accessors, true, num_rounds, &sum);
+        double linear = bs_benchLookups(&accessors, false, num_rounds, &sum);
+        double root_indexed = bs_benchRootLookups(&json, true, 1000000, &sum);
+        double root_linear = bs_benchRootLookups(&json, false, 100, &sum);
+
+        printf("%6u accessors, %.1f KB, lexed and indexed in %.2f ms\n", accessors.size, strlen(raw) / 1e3, lex_time * 1000.0);
+        printf("       accessor fields: %.1f ns indexed, %.1f ns searched\n", indexed * 1e9, linear * 1e9);
+        printf("       top level:       %.1f ns indexed, %.1f ns searched\n", root_indexed * 1e9, root_linear * 1e9);
+
+        bs_freeArena(&arena);
+        bs_free(raw);
+    }
+
+    printf("(%lld found)\n", (long long)sum);
+    return 0;
+}
+
+// - lex -
+// bsbench lex [<file.json>] [--accessors <accessors>] [--rounds <rounds>]
+// MB/s of lexing and indexing a file or a generated glTF manifest with bs_jsonInPlace() and with bs_json(),
+// which copies raw first. bs_jsonInPlace() lexes a fresh copy every round, the copying isn't timed
+static int bs_benchLex(int argc, char** argv) {
+    bs_U32 num_rounds = atoi(bs_benchOption(argc, argv, "--rounds", "20"));
+    char* raw = NULL;
+    int raw_len = 0;
+
+    if(argc > 0 && argv[0][0] != '-') {
+        raw = bs_loadFile(argv[0], &raw_len);
+    } else {
+        raw = bs_benchGltf(atoi(bs_benchOption(argc, argv, "--accessors", "20000")));
+        raw_len = strlen(raw) + 1;
+    }
+
+    char* copy = bs_alloc(raw_len);
+    bs_Arena arena = bs_arena(0);
+    double in_place_time = 0.0;
+    double copied_time = 0.0;
+    int num_tokens = 0;
+
+    for(bs_U32 i = 0; i < num_rounds; i++) {
+        memcpy(copy, raw, raw_len);
+
+        double start = bs_time();
+        num_tokens = bs_jsonInPlace(copy, raw_len, &arena.allocator).num_tokens;
+        in_place_time += bs_time() - start;
+        bs_arenaReset(&arena);
+
+        start = bs_time();
+        bs_jsonWith(raw, &arena.allocator);
+        copied_time += bs_time() - start;
+        bs_arenaReset(&arena);
+    }
+
+    double mb = (double)raw_len * num_rounds / 1e6;
+    printf("%.1f MB, %d tokens\n", raw_len / 1e6, num_tokens);
+    printf("bs_jsonInPlace: %.2f ms, %.1f MB/s\n", in_place_time * 1000.0 / num_rounds, mb / in_place_time);
+    printf("bs_json:        %.2f ms, %.1f MB/s\n", copied_time * 1000.0 / num_rounds, mb / copied_time);
+
+    bs_freeArena(&arena);
+    bs_free(copy);
+    bs_free(raw);
+    return 0;
+}
+
+static const bs_Benchmark benchmarks[] = {
+    { "batches", "[--count <batches>] [--sync]", bs_benchBatches },
+    { "draws", "[--count <draws>] [--frames <frames>] [--indirect]", bs_benchDraws },
+    { "record", "[--count <draws>] [--jobs <jobs>] [--threads <threads>] [--frames <frames>]", bs_benchRecord },
+    { "pipelines", "[--cold] [--cache <path>] [<vs.spv> <fs.spv>]...", bs_benchPipelines },
+    { "upload", "[--count <textures>] [--size <texels>] [<file.png>...]", bs_benchUpload },
+    { "stream", "[--count <textures>] [--size <texels>] [--threads <threads>] [<file.png>...]", bs_benchStream },
+    { "arena", "[--accessors <accessors>] [--loads <loads>]", bs_benchArena },
+    { "append", "[--count <units>] [--size <bytes>] [--increment <units>] [--buffers <buffers>]", bs_benchAppend },
+    { "map", "<file> [copy|map] [--size <MB>]", bs_benchMap },
+    { "io", "<file> [--small <KB>] [--large <MB>] [--threads <threads>] [--size <MB>]", bs_benchIo },
+    { "gltf", "[--accessors <accessors>]...", bs_benchGltfLookups },
+    { "lex", "[<file.json>] [--accessors <accessors>] [--rounds <rounds>]", bs_benchLex },
+};
+
+int main(int argc, char** argv) {
+    bs_U32 num_benchmarks = sizeof(benchmarks) / sizeof(benchmarks[0]);
+
+    if(argc > 1) {
+        for(bs_U32 i = 0; i < num_benchmarks; i++) {
+            if(strcmp(argv[1], benchmarks[i].name) == 0) {
+                return benchmarks[i].run(argc - 2, argv + 2);
+            }
+        }
+
+        printf("unknown benchmark %s\n", argv[1]);
+    }
+
+    printf("usage: bsbench <benchmark> [args]\n");
+    for(bs_U32 i = 0; i < num_benchmarks; i++) {
+        printf("       bsbench %s %s\n", benchmarks[i].name, benchmarks[i].usage);
+    }
+
+    return 1;
+}
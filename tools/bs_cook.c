@@ -0,0 +1,534 @@
+// Offline texture cooker, converts PNGs into DDS files of BC1, BC3, BC5 or BC7 blocks with a full mip chain,
+// which bs_textureFile() loads without decoding, or into page files for bs_virtualTexture().
+// usage: bscook <in.png> <out.dds> [bc1|bc3|bc5|bc7] [--srgb] [--no-mips]
+//        bscook <in.png> <out.bsvt> vtex
+
+#include <bs_types.h>
+#include <bs_vtex.h>
+
+#include <lodepng.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+typedef enum {
+    BS_COOK_BC1,
+    BS_COOK_BC3,
+    BS_COOK_BC5,
+    BS_COOK_BC7
+} bs_CookFormat;
+
+typedef struct {
+    bs_U32 w, h;
+    // RGBA8
+    bs_U8* texels;
+} bs_CookLevel;
+
+// DXGI_FORMAT values written into the DX10 header, srgb variants are one higher except for BC5
+static bs_U32 bs_dxgiFormat(bs_CookFormat format, bool srgb) {
+    switch(format) {
+        case BS_COOK_BC1: return srgb ? 72 : 71;
+        case BS_COOK_BC3: return srgb ? 78 : 77;
+        case BS_COOK_BC5: return 83;
+        case BS_COOK_BC7: return srgb ? 99 : 98;
+    }
+
+    return 0;
+}
+
+static bs_U32 bs_blockBytes(bs_CookFormat format) {
+    return format == BS_COOK_BC1 ? 8 : 16;
+}
+
+// - mips -
+static float bs_toLinear(bs_U8 value) {
+    float c = value / 255.0f;
+    return c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+}
+
+static bs_U8 bs_toSrgb(float c) {
+    c = c <= 0.0031308f ? c * 12.92f : 1.055f * powf(c, 1.0f / 2.4f) - 0.055f;
+    return (bs_U8)(c * 255.0f + 0.5f);
+}
+
+// 2x2 box filter, color is averaged in linear space for srgb textures
+static bs_CookLevel bs_downsample(bs_CookLevel src, bool srgb) {
+    bs_CookLevel dst;
+    dst.w = src.w > 1 ? src.w / 2 : 1;
+    dst.h = src.h > 1 ? src.h / 2 : 1;
+    dst.texels = malloc(dst.w * dst.h * 4);
+
+    for(bs_U32 y = 0; y < dst.h; y++) {
+        for(bs_U32 x = 0; x < dst.w; x++) {
+            bs_U32 x0 = x * 2, x1 = x * 2 + 1 < src.w ? x * 2 + 1 : x * 2;
+            bs_U32 y0 = y * 2, y1 = y * 2 + 1 < src.h ? y * 2 + 1 : y * 2;
+            const bs_U8* p[4] = {
+                src.texels + (y0 * src.w + x0) * 4, src.texels + (y0 * src.w + x1) * 4,
+                src.texels + (y1 * src.w + x0) * 4, src.texels + (y1 * src.w + x1) * 4
+            };
+
+            bs_U8* out = dst.texels + (y * dst.w + x) * 4;
+            for(int c = 0; c < 4; c++) {
+                if(srgb && c < 3) {
+                    out[c] = bs_toSrgb((bs_toLinear(p[0][c]) + bs_toLinear(p[1][c]) + bs_toLinear(p[2][c]) + bs_toLinear(p[3][c])) * 0.25f);
+                } else {
+                    out[c] = (bs_U8)((p[0][c] + p[1][c] + p[2][c] + p[3][c] + 2) / 4);
+                }
+            }
+        }
+    }
+
+    return dst;
+}
+
+// - endpoints -
+// extremes of the texels along their principal axis, the usual starting point for every BCn mode
+static void bs_fitEndpoints(float texels[16][4], int channels, float* e0, float* e1) {
+    float mean[4] = { 0 };
+    for(int i = 0; i < 16; i++) {
+        for(int c = 0; c < channels; c++) mean[c] += texels[i][c] / 16.0f;
+    }
+
+    float cov[4][4] = { 0 };
+    for(int i = 0; i < 16; i++) {
+        for(int a = 0; a < channels; a++) {
+            for(int b = 0; b < channels; b++) {
+                cov[a][b] += (texels[i][a] - mean[a]) * (texels[i][b] - mean[b]);
+            }
+        }
+    }
+
+    // power iteration converges quickly enough for 4x4 blocks
+    float axis[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+    for(int iteration = 0; iteration < 8; iteration++) {
+        float next[4] = { 0 };
+        float length = 0.0f;
+
+        for(int a = 0; a < channels; a++) {
+            for(int b = 0; b < channels; b++) next[a] += cov[a][b] * axis[b];
+            length += next[a] * next[a];
+        }
+
+        if(length < 1e-8f) break;
+
+        length = sqrtf(length);
+        for(int a = 0; a < channels; a++) axis[a] = next[a] / length;
+    }
+
+    float min_t = 0.0f, max_t = 0.0f;
+    for(int i = 0; i < 16; i++) {
+        float t = 0.0f;
+        for(int c = 0; c < channels; c++) t += (texels[i][c] - mean[c]) * axis[c];
+        if(t < min_t) min_t = t;
+        if(t > max_t) max_t = t;
+    }
+
+    for(int c = 0; c < channels; c++) {
+        e0[c] = fminf(fmaxf(mean[c] + axis[c] * max_t, 0.0f), 255.0f);
+        e1[c] = fminf(fmaxf(mean[c] + axis[c] * min_t, 0.0f), 255.0f);
+    }
+}
+
+static int bs_nearest(float texel[4], float palette[][4], int num_entries, int channels) {
+    int best = 0;
+    float best_error = 1e30f;
+
+    for(int i = 0; i < num_entries; i++) {
+        float error = 0.0f;
+        for(int c = 0; c < channels; c++) {
+            float d = texel[c] - palette[i][c];
+            error += d * d;
+        }
+
+        if(error < best_error) {
+            best_error = error;
+            best = i;
+        }
+    }
+
+    return best;
+}
+
+// - BC1 -
+static bs_U16 bs_pack565(const float* color) {
+    bs_U16 r = (bs_U16)(color[0] * 31.0f / 255.0f + 0.5f);
+    bs_U16 g = (bs_U16)(color[1] * 63.0f / 255.0f + 0.5f);
+    bs_U16 b = (bs_U16)(color[2] * 31.0f / 255.0f + 0.5f);
+    return (r << 11) | (g << 5) | b;
+}
+
+static void bs_unpack565(bs_U16 packed, float* color) {
+    bs_U32 r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+    color[0] = (float)((r << 3) | (r >> 2));
+    color[1] = (float)((g << 2) | (g >> 4));
+    color[2] = (float)((b << 3) | (b >> 2));
+    color[3] = 255.0f;
+}
+
+// always four color mode, which is also the only one BC3 color blocks have
+static void bs_encodeBc1(float texels[16][4], bs_U8* out) {
+    float e0[4], e1[4];
+    bs_fitEndpoints(texels, 3, e0, e1);
+
+    bs_U16 c0 = bs_pack565(e0), c1 = bs_pack565(e1);
+    if(c0 < c1) {
+        bs_U16 temp = c0;
+        c0 = c1;
+        c1 = temp;
+    }
+
+    float palette[4][4];
+    bs_unpack565(c0, palette[0]);
+    bs_unpack565(c1, palette[1]);
+    for(int c = 0; c < 3; c++) {
+        palette[2][c] = (2.0f * palette[0][c] + palette[1][c]) / 3.0f;
+        palette[3][c] = (palette[0][c] + 2.0f * palette[1][c]) / 3.0f;
+    }
+
+    bs_U32 indices = 0;
+    if(c0 != c1) {
+        for(int i = 0; i < 16; i++) {
+            indices |= (bs_U32)bs_nearest(texels[i], palette, 4, 3) << (i * 2);
+        }
+    }
+
+    out[0] = c0 & 0xFF;
+    out[1] = c0 >> 8;
+    out[2] = c1 & 0xFF;
+    out[3] = c1 >> 8;
+    memcpy(out + 4, &indices, 4);
+}
+
+// - BC4 -
+// one channel, eight interpolated values between the min and max
+static void bs_encodeBc4(float texels[16][4], int channel, bs_U8* out) {
+    float min = 255.0f, max = 0.0f;
+    for(int i = 0; i < 16; i++) {
+        if(texels[i][channel] < min) min = texels[i][channel];
+        if(texels[i][channel] > max) max = texels[i][channel];
+    }
+
+    bs_U8 a0 = (bs_U8)(max + 0.5f), a1 = (bs_U8)(min + 0.5f);
+
+    float palette[8][4] = { 0 };
+    palette[0][0] = a0;
+    palette[1][0] = a1;
+    for(int i = 1; i < 7; i++) {
+        palette[i + 1][0] = ((7 - i) * a0 + i * a1) / 7.0f;
+    }
+
+    bs_U64 indices = 0;
+    if(a0 != a1) {
+        for(int i = 0; i < 16; i++) {
+            float value[4] = { texels[i][channel] };
+            indices |= (bs_U64)bs_nearest(value, palette, 8, 1) << (i * 3);
+        }
+    }
+
+    out[0] = a0;
+    out[1] = a1;
+    for(int i = 0; i < 6; i++) {
+        out[2 + i] = (bs_U8)(indices >> (i * 8));
+    }
+}
+
+// - BC7 -
+typedef struct {
+    bs_U8* out;
+    bs_U32 bit;
+} bs_BitWriter;
+
+static void bs_writeBits(bs_BitWriter* writer, bs_U32 value, bs_U32 num_bits) {
+    for(bs_U32 i = 0; i < num_bits; i++, writer->bit++) {
+        if((value >> i) & 1) writer->out[writer->bit / 8] |= 1 << (writer->bit % 8);
+    }
+}
+
+// 7 bit endpoint channels sharing one p bit, picks whichever p reconstructs the endpoint closer
+static void bs_quantizeMode6(const float* endpoint, bs_U8* quantized, bs_U8* p_bit) {
+    float best_error = 1e30f;
+
+    for(bs_U8 p = 0; p < 2; p++) {
+        bs_U8 candidate[4];
+        float error = 0.0f;
+
+        for(int c = 0; c < 4; c++) {
+            int value = (int)((endpoint[c] - p) / 2.0f + 0.5f);
+            candidate[c] = (bs_U8)(value < 0 ? 0 : value > 127 ? 127 : value);
+
+            float d = endpoint[c] - ((candidate[c] << 1) | p);
+            error += d * d;
+        }
+
+        if(error < best_error) {
+            best_error = error;
+            memcpy(quantized, candidate, 4);
+            *p_bit = p;
+        }
+    }
+}
+
+// mode 6, a single RGBA line with 4 bit indices
+static void bs_encodeBc7(float texels[16][4], bs_U8* out) {
+    static const int weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+    float e[2][4];
+    bs_fitEndpoints(texels, 4, e[0], e[1]);
+
+    bs_U8 q[2][4], p[2];
+    bs_quantizeMode6(e[0], q[0], p + 0);
+    bs_quantizeMode6(e[1], q[1], p + 1);
+
+    float palette[16][4];
+    for(int i = 0; i < 16; i++) {
+        for(int c = 0; c < 4; c++) {
+            int a = (q[0][c] << 1) | p[0], b = (q[1][c] << 1) | p[1];
+            palette[i][c] = (float)(((64 - weights[i]) * a + weights[i] * b + 32) >> 6);
+        }
+    }
+
+    int indices[16];
+    for(int i = 0; i < 16; i++) {
+        indices[i] = bs_nearest(texels[i], palette, 16, 4);
+    }
+
+    // the first index is stored without its top bit, swapping the endpoints flips it to 0
+    if(indices[0] & 8) {
+        for(int c = 0; c < 4; c++) {
+            bs_U8 temp = q[0][c];
+            q[0][c] = q[1][c];
+            q[1][c] = temp;
+        }
+
+        bs_U8 temp = p[0];
+        p[0] = p[1];
+        p[1] = temp;
+
+        for(int i = 0; i < 16; i++) indices[i] = 15 - indices[i];
+    }
+
+    memset(out, 0, 16);
+    bs_BitWriter writer = { out, 0 };
+    bs_writeBits(&writer, 1 << 6, 7);
+
+    for(int c = 0; c < 4; c++) {
+        bs_writeBits(&writer, q[0][c], 7);
+        bs_writeBits(&writer, q[1][c], 7);
+    }
+
+    bs_writeBits(&writer, p[0], 1);
+    bs_writeBits(&writer, p[1], 1);
+
+    for(int i = 0; i < 16; i++) {
+        bs_writeBits(&writer, indices[i], i == 0 ? 3 : 4);
+    }
+}
+
+// - blocks -
+static void bs_encodeLevel(bs_CookLevel level, bs_CookFormat format, bs_U8* out) {
+    bs_U32 blocks_x = (level.w + 3) / 4, blocks_y = (level.h + 3) / 4;
+
+    for(bs_U32 by = 0; by < blocks_y; by++) {
+        for(bs_U32 bx = 0; bx < blocks_x; bx++) {
+            // texels past the edge repeat the last row and column
+            float texels[16][4];
+            for(int i = 0; i < 16; i++) {
+                bs_U32 x = bx * 4 + i % 4, y = by * 4 + i / 4;
+                if(x >= level.w) x = level.w - 1;
+                if(y >= level.h) y = level.h - 1;
+
+                const bs_U8* texel = level.texels + (y * level.w + x) * 4;
+                for(int c = 0; c < 4; c++) texels[i][c] = texel[c];
+            }
+
+            switch(format) {
+                case BS_COOK_BC1:
+                    bs_encodeBc1(texels, out);
+                    break;
+                case BS_COOK_BC3:
+                    bs_encodeBc4(texels, 3, out);
+                    bs_encodeBc1(texels, out + 8);
+                    break;
+                case BS_COOK_BC5:
+                    bs_encodeBc4(texels, 0, out);
+                    bs_encodeBc4(texels, 1, out + 8);
+                    break;
+                case BS_COOK_BC7:
+                    bs_encodeBc7(texels, out);
+                    break;
+            }
+
+            out += bs_blockBytes(format);
+        }
+    }
+}
+
+// - dds -
+static void bs_write32(FILE* f, bs_U32 value) {
+    fwrite(&value, 4, 1, f);
+}
+
+static void bs_writeDdsHeader(FILE* f, bs_U32 w, bs_U32 h, bs_U32 num_levels, bs_U32 level_size, bs_U32 dxgi_format) {
+    fwrite("DDS ", 1, 4, f);
+
+    // DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT | DDSD_LINEARSIZE
+    bs_write32(f, 124);
+    bs_write32(f, 0x1 | 0x2 | 0x4 | 0x1000 | 0x20000 | 0x80000);
+    bs_write32(f, h);
+    bs_write32(f, w);
+    bs_write32(f, level_size);
+    bs_write32(f, 0);
+    bs_write32(f, num_levels);
+    for(int i = 0; i < 11; i++) bs_write32(f, 0);
+
+    // pixel format, DDPF_FOURCC with the DX10 extension header
+    bs_write32(f, 32);
+    bs_write32(f, 0x4);
+    fwrite("DX10", 1, 4, f);
+    for(int i = 0; i < 5; i++) bs_write32(f, 0);
+
+    // DDSCAPS_TEXTURE, DDSCAPS_COMPLEX | DDSCAPS_MIPMAP with mips
+    bs_write32(f, 0x1000 | (num_levels > 1 ? 0x8 | 0x400000 : 0));
+    for(int i = 0; i < 4; i++) bs_write32(f, 0);
+
+    // DX10 header, a single 2D texture
+    bs_write32(f, dxgi_format);
+    bs_write32(f, 3);
+    bs_write32(f, 0);
+    bs_write32(f, 1);
+    bs_write32(f, 0);
+}
+
+// - virtual textures -
+// header, then the pages of every level from the largest, row major, each RGBA8 with a border clamped to the level's edges
+static bs_U32 bs_writeVirtualTexture(FILE* f, bs_CookLevel level) {
+    const bs_U32 page_texels = BS_VTEX_PAGE_SIZE + 2 * BS_VTEX_BORDER;
+
+    // down to the level that fits in a single page, which the runtime keeps resident
+    bs_U32 num_levels = 1;
+    for(bs_U32 w = level.w, h = level.h; (w > BS_VTEX_PAGE_SIZE || h > BS_VTEX_PAGE_SIZE) && num_levels < BS_VTEX_MAX_LEVELS; num_levels++) {
+        w = w > 1 ? w / 2 : 1;
+        h = h > 1 ? h / 2 : 1;
+    }
+
+    fwrite("BSVT", 1, 4, f);
+    bs_write32(f, level.w);
+    bs_write32(f, level.h);
+    bs_write32(f, num_levels);
+    bs_write32(f, BS_VTEX_PAGE_SIZE);
+    bs_write32(f, BS_VTEX_BORDER);
+
+    bs_U8* page = malloc(page_texels * page_texels * 4);
+    for(bs_U32 i = 0; i < num_levels; i++) {
+        bs_U32 pages_x = (level.w + BS_VTEX_PAGE_SIZE - 1) / BS_VTEX_PAGE_SIZE;
+        bs_U32 pages_y = (level.h + BS_VTEX_PAGE_SIZE - 1) / BS_VTEX_PAGE_SIZE;
+
+        for(bs_U32 py = 0; py < pages_y; py++) {
+            for(bs_U32 px = 0; px < pages_x; px++) {
+                for(bs_U32 y = 0; y < page_texels; y++) {
+                    int sy = (int)(py * BS_VTEX_PAGE_SIZE + y) - BS_VTEX_BORDER;
+                    sy = sy < 0 ? 0 : (sy >= (int)level.h ? (int)level.h - 1 : sy);
+
+                    for(bs_U32 x = 0; x < page_texels; x++) {
+                        int sx = (int)(px * BS_VTEX_PAGE_SIZE + x) - BS_VTEX_BORDER;
+                        sx = sx < 0 ? 0 : (sx >= (int)level.w ? (int)level.w - 1 : sx);
+                        memcpy(page + (y * page_texels + x) * 4, level.texels + (sy * level.w + sx) * 4, 4);
+                    }
+                }
+
+                fwrite(page, 1, page_texels * page_texels * 4, f);
+            }
+        }
+
+        if(i + 1 < num_levels) {
+            bs_CookLevel next = bs_downsample(level, true);
+            free(level.texels);
+            level = next;
+        }
+    }
+
+    free(page);
+    free(level.texels);
+    return num_levels;
+}
+
+int main(int argc, char** argv) {
+    if(argc < 3) {
+        printf("usage: bscook <in.png> <out.dds> [bc1|bc3|bc5|bc7] [--srgb] [--no-mips]\n");
+        printf("       bscook <in.png> <out.bsvt> vtex\n");
+        return 1;
+    }
+
+    bs_CookFormat format = BS_COOK_BC7;
+    bool srgb = false, mips = true, vtex = false;
+
+    for(int i = 3; i < argc; i++) {
+        if(strcmp(argv[i], "bc1") == 0) format = BS_COOK_BC1;
+        else if(strcmp(argv[i], "bc3") == 0) format = BS_COOK_BC3;
+        else if(strcmp(argv[i], "bc5") == 0) format = BS_COOK_BC5;
+        else if(strcmp(argv[i], "bc7") == 0) format = BS_COOK_BC7;
+        else if(strcmp(argv[i], "vtex") == 0) vtex = true;
+        else if(strcmp(argv[i], "--srgb") == 0) srgb = true;
+        else if(strcmp(argv[i], "--no-mips") == 0) mips = false;
+        else {
+            printf("unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    bs_CookLevel level = { 0 };
+    unsigned int w, h;
+    bs_U32 err = lodepng_decode32_file(&level.texels, &w, &h, argv[1]);
+    if(err != 0) {
+        printf("failed to decode %s: %s\n", argv[1], lodepng_error_text(err));
+        return 1;
+    }
+
+    level.w = w;
+    level.h = h;
+
+    bs_U32 num_levels = 1;
+    if(mips) {
+        for(bs_U32 size = w > h ? w : h; size > 1; size >>= 1) num_levels++;
+    }
+
+    FILE* f = fopen(argv[2], "wb");
+    if(f == NULL) {
+        printf("failed to open %s\n", argv[2]);
+        return 1;
+    }
+
+    // pages go into an sRGB atlas, so levels are always averaged in linear space
+    if(vtex) {
+        num_levels = bs_writeVirtualTexture(f, level);
+        fclose(f);
+
+        printf("%s: %ux%u, %u levels of %u texel pages\n", argv[2], w, h, num_levels, BS_VTEX_PAGE_SIZE);
+        return 0;
+    }
+
+    bs_U32 level_size = ((w + 3) / 4) * ((h + 3) / 4) * bs_blockBytes(format);
+    bs_writeDdsHeader(f, w, h, num_levels, level_size, bs_dxgiFormat(format, srgb && format != BS_COOK_BC5));
+
+    bs_U8* blocks = malloc(level_size);
+    for(bs_U32 i = 0; i < num_levels; i++) {
+        bs_U32 size = ((level.w + 3) / 4) * ((level.h + 3) / 4) * bs_blockBytes(format);
+        bs_encodeLevel(level, format, blocks);
+        fwrite(blocks, 1, size, f);
+
+        if(i + 1 < num_levels) {
+            bs_CookLevel next = bs_downsample(level, srgb);
+            free(level.texels);
+            level = next;
+        }
+    }
+
+    free(blocks);
+    free(level.texels);
+    fclose(f);
+
+    printf("%s: %ux%u, %u levels\n", argv[2], w, h, num_levels);
+    return 0;
+}
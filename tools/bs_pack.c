@@ -0,0 +1,283 @@
+// Asset packer, writes files and directories into a single .bspk that bs_mountPack() maps.
+// Names are the paths as given, with '/' separators, so run it from the directory the game loads relative to.
+// usage: bspack <out.bspk> <file|directory>... [--no-compress] [--align <bytes>]
+
+#include <bs_types.h>
+#include <bs_compress.h>
+#include <bs_pack.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+// compressed entries have to save at least this share of their size
+#define BS_PACK_MIN_SAVING 0.1
+
+typedef struct {
+    char** names;
+    bs_U32 num_names;
+    bs_U32 capacity;
+} bs_NameList;
+
+// FNV-1a, has to match bs_hash()
+static bs_U64 bs_nameHash(const char* name, bs_U64 len) {
+    bs_U64 hash = 0xcbf29ce484222325ull;
+    for(bs_U64 i = 0; i < len; i++) {
+        hash ^= (bs_U8)name[i];
+        hash *= 0x100000001b3ull;
+    }
+
+    return hash;
+}
+
+static void bs_addName(bs_NameList* list, const char* path) {
+    if(list->num_names == list->capacity) {
+        list->capacity = list->capacity ? list->capacity * 2 : 64;
+        list->names = realloc(list->names, list->capacity * sizeof(char*));
+    }
+
+    if(path[0] == '.' && (path[1] == '/' || path[1] == '\\')) {
+        path += 2;
+    }
+
+    char* name = malloc(strlen(path) + 1);
+    strcpy(name, path);
+    for(char* c = name; *c != '\0'; c++) {
+        if(*c == '\\') *c = '/';
+    }
+
+    list->names[list->num_names++] = name;
+}
+
+static void bs_addPath(bs_NameList* list, const char* path);
+
+#ifdef _WIN32
+static void bs_addDirectory(bs_NameList* list, const char* path) {
+    char pattern[MAX_PATH];
+    snprintf(pattern, sizeof(pattern), "%s/*", path);
+
+    WIN32_FIND_DATAA find;
+    HANDLE handle = FindFirstFileA(pattern, &find);
+    if(handle == INVALID_HANDLE_VALUE) return;
+
+    do {
+        if(strcmp(find.cFileName, ".") == 0 || strcmp(find.cFileName, "..") == 0) continue;
+
+        char child[MAX_PATH];
+        snprintf(child, sizeof(child), "%s/%s", path, find.cFileName);
+        bs_addPath(list, child);
+    } while(FindNextFileA(handle, &find));
+
+    FindClose(handle);
+}
+
+static bool bs_isDirectory(const char* path) {
+    DWORD attributes = GetFileAttributesA(path);
+    return attributes != INVALID_FILE_ATTRIBUTES && (attributes & FILE_ATTRIBUTE_DIRECTORY);
+}
+#else
+static void bs_addDirectory(bs_NameList* list, const char* path) {
+    DIR* dir = opendir(path);
+    if(dir == NULL) return;
+
+    struct dirent* ent;
+    while((ent = readdir(dir)) != NULL) {
+        if(strcmp(ent->d_name, ".") == 0 || strcmp(ent->d_name, "..") == 0) continue;
+
+        char child[4096];
+        snprintf(child, sizeof(child), "%s/%s", path, ent->d_name);
+        bs_addPath(list, child);
+    }
+
+    closedir(dir);
+}
+
+static bool bs_isDirectory(const char* path) {
+    struct stat st;
+    return stat(path, &st) == 0 && S_ISDIR(st.st_mode);
+}
+#endif
+
+static void bs_addPath(bs_NameList* list, const char* path) {
+    if(bs_isDirectory(path)) {
+        bs_addDirectory(list, path);
+    } else {
+        bs_addName(list, path);
+    }
+}
+
+static int bs_compareNames(const void* a, const void* b) {
+    return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+static bs_U8* bs_readFile(const char* path, bs_U64* size) {
+    FILE* f = fopen(path, "rb");
+    if(f == NULL) return NULL;
+
+    fseek(f, 0, SEEK_END);
+    long length = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    bs_U8* data = malloc(length > 0 ? length : 1);
+    if(length > 0 && fread(data, 1, length, f) != (size_t)length) {
+        free(data);
+        data = NULL;
+    }
+
+    fclose(f);
+    *size = length;
+    return data;
+}
+
+static void bs_pad(FILE* f, bs_U64* offset, bs_U64 alignment) {
+    static const bs_U8 zeros[256] = { 0 };
+
+    while(*offset % alignment != 0) {
+        bs_U64 n = alignment - *offset % alignment;
+        if(n > sizeof(zeros)) n = sizeof(zeros);
+
+        fwrite(zeros, 1, n, f);
+        *offset += n;
+    }
+}
+
+int main(int argc, char** argv) {
+    if(argc < 3) {
+        printf("usage: bspack <out.bspk> <file|directory>... [--no-compress] [--align <bytes>]\n");
+        return 1;
+    }
+
+    bool compress = true;
+    bs_U64 alignment = 64;
+    bs_NameList list = { 0 };
+
+    for(int i = 2; i < argc; i++) {
+        if(strcmp(argv[i], "--no-compress") == 0) {
+            compress = false;
+        } else if(strcmp(argv[i], "--align") == 0 && i + 1 < argc) {
+            alignment = strtoull(argv[++i], NULL, 10);
+            if(alignment < 8 || (alignment & (alignment - 1)) != 0) {
+                printf("alignment has to be a power of two of at least 8\n");
+                return 1;
+            }
+        } else {
+            bs_addPath(&list, argv[i]);
+        }
+    }
+
+    // sorted so packs of the same files are identical
+    qsort(list.names, list.num_names, sizeof(char*), bs_compareNames);
+
+    FILE* f = fopen(argv[1], "wb");
+    if(f == NULL) {
+        printf("failed to open %s\n", argv[1]);
+        return 1;
+    }
+
+    bs_PackHeader header = { 0 };
+    fwrite(&header, sizeof(header), 1, f);
+    bs_U64 offset = sizeof(header);
+
+    bs_PackEntry* entries = calloc(list.num_names ? list.num_names : 1, sizeof(bs_PackEntry));
+    bs_U64 names_size = 0, raw_total = 0, stored_total = 0;
+
+    for(bs_U32 i = 0; i < list.num_names; i++) {
+        bs_U64 size = 0;
+        bs_U8* data = bs_readFile(list.names[i], &size);
+        if(data == NULL) {
+            printf("failed to read %s\n", list.names[i]);
+            return 1;
+        }
+
+        bs_PackEntry* entry = entries + i;
+        bs_U64 name_len = strlen(list.names[i]);
+        entry->hash = bs_nameHash(list.names[i], name_len);
+        entry->raw_size = size;
+        entry->crc = bs_crc32(0, data, size);
+        entry->name_offset = (bs_U32)names_size;
+        entry->name_len = (bs_U32)name_len;
+        names_size += name_len + 1;
+
+        const bs_U8* stored = data;
+        entry->size = size;
+        entry->compression = BS_PACK_RAW;
+
+        bs_U8* compressed = NULL;
+        if(compress && size > 0) {
+            compressed = malloc(bs_lz4Bound(size));
+            bs_U64 compressed_size = bs_lz4Compress(data, size, compressed);
+
+            if(compressed_size < size * (1.0 - BS_PACK_MIN_SAVING)) {
+                stored = compressed;
+                entry->size = compressed_size;
+                entry->compression = BS_PACK_LZ4;
+            }
+        }
+
+        bs_pad(f, &offset, alignment);
+        entry->offset = offset;
+        fwrite(stored, 1, entry->size, f);
+        offset += entry->size;
+
+        raw_total += size;
+        stored_total += entry->size;
+        free(compressed);
+        free(data);
+    }
+
+    // at most half full so probes stay short
+    bs_U32 num_buckets = 1;
+    while(num_buckets < list.num_names * 2) num_buckets *= 2;
+
+    bs_U32* buckets = malloc(num_buckets * sizeof(bs_U32));
+    memset(buckets, 0xFF, num_buckets * sizeof(bs_U32));
+
+    for(bs_U32 i = 0; i < list.num_names; i++) {
+        bs_U32 bucket = entries[i].hash & (num_buckets - 1);
+
+        while(buckets[bucket] != BS_PACK_EMPTY_BUCKET) {
+            if(strcmp(list.names[buckets[bucket]], list.names[i]) == 0) {
+                printf("%s is packed twice\n", list.names[i]);
+                return 1;
+            }
+
+            bucket = (bucket + 1) & (num_buckets - 1);
+        }
+
+        buckets[bucket] = i;
+    }
+
+    bs_pad(f, &offset, 8);
+    header.entries_offset = offset;
+    fwrite(entries, sizeof(bs_PackEntry), list.num_names, f);
+    offset += (bs_U64)list.num_names * sizeof(bs_PackEntry);
+
+    header.buckets_offset = offset;
+    fwrite(buckets, sizeof(bs_U32), num_buckets, f);
+    offset += (bs_U64)num_buckets * sizeof(bs_U32);
+
+    header.names_offset = offset;
+    header.names_size = names_size;
+    for(bs_U32 i = 0; i < list.num_names; i++) {
+        fwrite(list.names[i], 1, strlen(list.names[i]) + 1, f);
+    }
+
+    header.magic = BS_PACK_MAGIC;
+    header.version = BS_PACK_VERSION;
+    header.num_entries = list.num_names;
+    header.num_buckets = num_buckets;
+
+    fseek(f, 0, SEEK_SET);
+    fwrite(&header, sizeof(header), 1, f);
+    fclose(f);
+
+    printf("%s: %u files, %llu bytes stored as %llu\n", argv[1], list.num_names, (unsigned long long)raw_total, (unsigned long long)stored_total);
+    return 0;
+}